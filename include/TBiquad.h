@@ -5,6 +5,16 @@
 namespace coro
 {
 
+/**
+ * @brief Compute biquad coefficients (normalized to a0) for a filter.
+ *
+ * AllPass filters with q <= 0.5 are first order (b2 and a2 are zero).
+ *
+ * @param coeffs b0, b1, b2, a1, a2
+ * @return false, if filter type is not supported.
+ */
+bool biquadCoeffs(const Filter& filter, uint32_t rate, double* coeffs);
+
 template <typename InT, typename AccT>
 class TBiquad
 {
@@ -45,12 +55,21 @@ public:
     };
     Coeffs m_coeffs;
 
-    // We have a history for each channel and cascade
-    struct History {
-        InT x1 = 0.0, x2 = 0.0;
-        InT y1 = 0.0, y2 = 0.0;
+    // History of all cascades and channels lives in one contiguous, aligned
+    // SoA block: per cascade the states x1, x2, y1 and y2 of all channels.
+    // Each state is padded to whole lanes, so it can be loaded into SIMD
+    // registers as is.
+    enum State : uint8_t {
+        X1 = 0, X2, Y1, Y2
+    };
+    struct alignas(32) Lanes {
+        InT v[32/sizeof(InT)] = {};
     };
-    std::vector<std::vector<History>> m_history;
+    InT* history(std::size_t cascade, State state);
+
+    uint8_t m_cascadeCount = 1;
+    std::size_t m_lanesPerState = 1;
+    std::vector<Lanes> m_history;
 };
 
 } // namespace coro
@@ -19,6 +19,7 @@
 
 #include <coro/core/Sink.h>
 
+#include <atomic>
 #include <string>
 
 typedef struct _snd_pcm snd_pcm_t;
@@ -29,12 +30,42 @@ namespace audio {
 class AlsaSink : public core::Sink
 {
 public:
-    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
-        return {{{ { AudioCapRaw<int16_t> {} },
-                   { core::NoCap {} }
-               }}};
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 4> caps() {
+        return {{
+                { { AudioCapRaw<int16_t> {} },
+                  { core::NoCap {} }},
+                // Float is converted while writing to the device
+                { { AudioCapRaw<float> {} },
+                  { core::NoCap {} }},
+                // Planes are interleaved before writing to the device
+                { { AudioCapRaw<int16_t> { SampleRates::Any, ChannelFlags::Any, core::CapFlag::Planar } },
+                  { core::NoCap {} }},
+                { { AudioCapRaw<float> { SampleRates::Any, ChannelFlags::Any, core::CapFlag::Planar } },
+                  { core::NoCap {} }}
+               }};
     }
 
+    /// Trade-off between latency and robustness against scheduling jitter
+    enum class LatencyProfile {
+        UltraLow,   ///< 64 frames period, 4 periods buffer, starts after 2 periods
+        Low,        ///< 128 frames period, 4 periods buffer, starts after 2 periods
+        Balanced,   ///< 256 frames period, 8 periods buffer, starts after 4 periods
+        Robust,     ///< 256 frames period, max(16 periods, 500 ms) buffer, starts after max(4 periods, 100 ms)
+        Custom      ///< Explicit frames (see setLatency())
+    };
+
+    /// Period, buffer and start threshold granted by the device
+    struct Latency {
+        uint32_t periodFrames = 0;
+        uint32_t bufferFrames = 0;
+        uint32_t startFrames = 0;
+        /// Latency of output: frames queued in device, once it started. In
+        /// output thread mode, buffers waiting in its ring add to it.
+        uint32_t latencyUs = 0;
+        /// Max latency of output: all frames of buffer queued
+        uint32_t maxLatencyUs = 0;
+    };
+
     AlsaSink();
     virtual ~AlsaSink();
 
@@ -42,23 +73,97 @@ public:
 
     void setDevice(const std::string& device);
 
+    /**
+     * @brief Write through the mmap'ed ring buffer of the device.
+     *
+     * Samples are rendered straight into the ring buffer
+     * (SND_PCM_ACCESS_MMAP_INTERLEAVED) instead of being copied by
+     * snd_pcm_writei(). Float input is converted on the way, so no
+     * AudioConverter is needed in front. Falls back to read/write access,
+     * if the device does not support mmap. Applies on next start.
+     */
+    void setMmap(bool enable);
+
+    /// Whether the opened device actually runs in mmap mode
+    bool isMmap() const;
+
+    /**
+     * @brief Write from a dedicated output thread.
+     *
+     * Incoming buffers are put into a lock-free ring, so the delivering
+     * thread never blocks. The output thread waits on the poll descriptors of
+     * the device and renders exactly one period whenever the device asks for
+     * it. Missing frames are filled with silence and counted as underrun.
+     * Applies on next start.
+     *
+     * @param enable run output thread
+     * @param priority SCHED_FIFO priority (1..99), 0 keeps default scheduling
+     * @param cpu CPU to pin output thread to, -1 for any
+     */
+    void setOutputThread(bool enable, int priority = 0, int cpu = -1);
+
+    /// Return number of underruns (periods which ran short of frames, device xruns)
+    size_t underrunCount() const;
+
+    /// Set latency profile. Reopens the device, if already opened. Default is Robust.
+    void setLatencyProfile(LatencyProfile profile);
+    LatencyProfile latencyProfile() const;
+
+    /**
+     * @brief Set explicit latency (profile becomes Custom).
+     *
+     * Device might grant different sizes (see latency()).
+     *
+     * @param periodFrames period size in frames
+     * @param bufferFrames buffer size in frames, at least two periods
+     * @param startFrames frames queued before playback starts, at most bufferFrames
+     */
+    void setLatency(uint32_t periodFrames, uint32_t bufferFrames, uint32_t startFrames);
+
+    /// Return latency actually granted by the opened device
+    Latency latency() const;
+
 private:
     const char* name() const override;
     void onStart() override;
     void onStop() override;
-    AudioConf onProcess(const AudioConf& conf, core::Buffer& buffer) override;
+    void onProcess(core::BufferPtr& buffer) override;
 
     // alsa members
     bool open(const AudioConf& conf);
     bool openSimple(const AudioConf& conf);
     bool write(const char* samples, uint32_t bytesCount);
     void writeSimple(const char* samples, uint32_t bytesCount);
+    void writeMmap(const char* samples, AudioCodec codec, uint32_t frameCount);
+    void writeSegments(const core::Buffer& buffer);
+    void startIfFilled();
     bool recover(int err);
 
+    // output thread
+    void startThread();
+    void stopThread();
+    void runThread();
+    void writePeriod();
+    uint32_t render(char* dst, uint32_t frameCount);
+
     snd_pcm_t* m_pcm = nullptr;
     AudioConf  m_conf;
 
     std::string m_device = "default";
+
+    bool m_isMmapRequested = false;
+    bool m_isMmap = false;
+    LatencyProfile m_latencyProfile = LatencyProfile::Robust;
+    // Requested sizes of Custom profile
+    Latency m_customLatency;
+    // Granted sizes
+    Latency m_latency;
+
+    bool m_isThreaded = false;
+    int  m_priority = 0;
+    int  m_cpu = -1;
+    class AlsaSinkThread* m_thread = nullptr;
+    std::atomic<size_t> m_underrunCount = 0;
 };
 
 } // namespace audio
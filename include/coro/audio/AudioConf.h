@@ -29,6 +29,8 @@ public:
     SampleRate  rate = SampleRate::Invalid;
     ChannelFlags channels = Channels::Invalid;
     bool        isRtpPayloaded = false;
+    /// Raw samples are stored as one plane per channel (all frames of channel 0, then channel 1, ...)
+    bool        isPlanar = false;
 
     uint32_t frameSize() const;
 
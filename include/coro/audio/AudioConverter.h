@@ -2,9 +2,28 @@
 
 #include <coro/audio/AudioNode.h>
 
+#include <type_traits>
+
 namespace coro {
 namespace audio {
 
+/**
+ * @brief Convert samples between raw codecs.
+ *
+ * Integers are full scale fixed point, float is +-1.0. Narrowing
+ * conversions round to nearest and saturate. in and out might be the same,
+ * if out samples are not wider than in samples.
+ *
+ * @return false, if a codec is not raw
+ */
+bool convert(const char* in, AudioCodec inCodec, char* out, AudioCodec outCodec, size_t count);
+
+/**
+ * Converts between sample types (int16_t, Int24, Int24Packed, int32_t and
+ * float) with SIMD kernels. Conversion runs in place, if output samples are
+ * not wider than input samples. Otherwise, output is written behind.
+ * Samples are converted one by one, so planar buffers pass as well.
+ */
 template <class InT, class OutT>
 class AudioConverter : public AudioNode
 {
@@ -12,16 +31,28 @@ public:
     AudioConverter();
     virtual ~AudioConverter();
 
-    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 2> caps() {
         return {{
-                { { AudioCapRaw<InT> { } }, // in
-                  { AudioCapRaw<OutT> { } }}
+                { { rawCap<InT>() }, // in
+                  { rawCap<OutT>() }},
+                { { rawCap<InT>(core::CapFlag::Planar) }, // in
+                  { rawCap<OutT>(core::CapFlag::Planar) }}
                }};
     }
 
 private:
+    // 24 bit codecs have no AudioCapRaw
+    template <class T>
+    static constexpr core::Cap rawCap(core::CapFlags flags = 0) {
+        if constexpr (std::is_same<T, Int24>::value || std::is_same<T, Int24Packed>::value) {
+            return core::Cap { AudioCap { rawCodec<T>(), SampleRates::Any, ChannelFlags::Any, flags } };
+        } else {
+            return core::Cap { AudioCapRaw<T> { SampleRates::Any, ChannelFlags::Any, flags } };
+        }
+    }
+
     const char* name() const override;
-    AudioConf onProcess(const AudioConf& conf, core::Buffer& buffer) override;
+    void onProcess(core::BufferPtr& buffer) override;
 };
 
 } // namespace audio
@@ -35,7 +35,7 @@ public:
     AudioDecoderFfmpeg();
     ~AudioDecoderFfmpeg();
 
-    static constexpr std::array<std::pair<core::Cap, core::Cap>, 3> caps() {
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 4> caps() {
         return {{
                 { { AudioCap { AudioCodec::Ac3 }}, // in
                   { AudioCap { AudioCodec::RawFloat32, // out
@@ -43,6 +43,10 @@ public:
                 { { AudioCap { AudioCodec::Ac3 }}, // in
                   { AudioCapRaw<float> {
                                SampleRate::Rate32000 | SampleRate::Rate44100 | SampleRate::Rate48000 } }},
+                { { AudioCap { AudioCodec::Ac3 }}, // in
+                  { AudioCapRaw<float> {
+                               SampleRate::Rate32000 | SampleRate::Rate44100 | SampleRate::Rate48000,
+                               ChannelFlags::Any, core::CapFlag::Planar } }},
                 { { AudioCap { AudioCodec::Alac }}, // in
                   { AudioCap { AudioCodec::RawInt16, // out
                                SampleRate::Rate44100 } }}
@@ -55,6 +59,9 @@ public:
     // <format> <format specific parameters>
     void init(const std::string& data);
 
+    /// Output planes as decoded (e.g. FLTP), instead of interleaving them.
+    void setPlanar(bool isPlanar);
+
 private:
     const char* name() const override;
 
@@ -65,9 +72,12 @@ private:
 
     template<typename T>
     void interleave(const AVFrame* in, core::Buffer& out);
+    template<typename T>
+    void copyPlanes(const AVFrame* in, core::Buffer& out);
 
     std::string m_codecData;
     AudioConf m_conf;
+    bool m_isPlanar = false;
 
     AVCodecContext* m_context = nullptr;
 };
@@ -42,6 +42,8 @@ public:
             }};
     }
 
+    static constexpr bool isForwarding = true;
+
     /**
      * @brief setBitrate
      * @param kbps
@@ -64,6 +66,7 @@ private:
     AudioCodec m_codec = AudioCodec::Invalid;
     AudioConf m_conf;
     uint16_t m_bitrateKbps = 320;
+    bool m_isRejected = false;
 
     AVCodecContext* m_context = nullptr;
     AVFrame* m_partialFrame = nullptr;
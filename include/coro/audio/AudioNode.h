@@ -19,6 +19,8 @@
 
 #include <coro/core/Node.h>
 
+#include <atomic>
+
 namespace coro {
 namespace audio {
 
@@ -28,8 +30,16 @@ public:
     AudioNode();
     virtual ~AudioNode();
 
+    /// Revision of parameters. Setters bump it, so that fused chains (see FusedChain) pick up changes.
+    uint32_t revision() const;
+
 protected:
     audio::AudioConf onProcess(const audio::AudioConf& conf, core::Buffer& buffer) override;
+
+    void bumpRevision();
+
+private:
+    std::atomic<uint32_t> m_revision = 0;
 };
 
 } // namespace audio
@@ -38,6 +38,10 @@ enum class AudioCodec : uint16_t
     Aptx = 0x0080,
     Alac = 0x0100,
 
+    RawInt32    = 0x0200,       // S32_LE
+    RawInt24    = 0x0400,       // S24_LE: 24 bit, LSB aligned in 32 bit
+    RawInt24Packed = 0x0800,    // S24_3LE: 24 bit in 3 bytes
+
     RtpPayload = 0x8000,    // @TODO(mawe): remove RTP payload flag here
 
     Unknown = 0x4000
@@ -45,6 +49,25 @@ enum class AudioCodec : uint16_t
 using AudioCodecs = core::Flags<AudioCodec>;
 DECLARE_OPERATORS_FOR_FLAGS(AudioCodecs)
 uint8_t size(AudioCodec codec);
+bool isRaw(AudioCodec codec);
+
+/// Sample type of AudioCodec::RawInt24 (sign extended)
+struct Int24 {
+    int32_t value;
+};
+
+/// Sample type of AudioCodec::RawInt24Packed (little endian)
+struct Int24Packed {
+    uint8_t bytes[3];
+};
+
+/// Raw codec for sample type T
+template <typename T> constexpr AudioCodec rawCodec();
+template <> constexpr AudioCodec rawCodec<int16_t>() { return AudioCodec::RawInt16; }
+template <> constexpr AudioCodec rawCodec<int32_t>() { return AudioCodec::RawInt32; }
+template <> constexpr AudioCodec rawCodec<float>() { return AudioCodec::RawFloat32; }
+template <> constexpr AudioCodec rawCodec<Int24>() { return AudioCodec::RawInt24; }
+template <> constexpr AudioCodec rawCodec<Int24Packed>() { return AudioCodec::RawInt24Packed; }
 
 enum class SampleRate : uint8_t
 {
@@ -72,10 +95,18 @@ enum class Channels : uint8_t
     Lfe     = 0x04,
     RearStereo = 0x08,
     RearCenter = 0x10,
+    SideStereo = 0x20,
+    TopStereo  = 0x40,
     Quad    = Stereo | RearStereo,
     Surround50 = Quad | Center,
     Surround51 = Surround50 | Lfe,
 
+    // Active speaker layouts (see Crossover): bands from low to high are
+    // Stereo, RearStereo, SideStereo and TopStereo, followed by Lfe.
+    Surround21 = Stereo | Lfe,
+    Surround41 = Quad | Lfe,
+    Hexa    = Quad | SideStereo,
+    Octo    = Hexa | TopStereo,
 };
 using ChannelFlags = core::Flags<Channels>;
 DECLARE_OPERATORS_FOR_FLAGS(ChannelFlags)
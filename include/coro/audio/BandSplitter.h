@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <coro/audio/BiquadCascade.h>
+
+#include <vector>
+
+namespace coro {
+namespace audio {
+
+/**
+ * @brief Splits interleaved input into any number of filtered outputs.
+ *
+ * Each output mixes its input from the input channels, then runs through
+ * its own biquad sections with its gain folded into the first one (e.g. one
+ * output per crossover band and channel, plus an LFE sum). All outputs run
+ * in one pass: each input frame is read once and output frames are written
+ * contiguously (see simd::biquadLanes()).
+ *
+ * int16_t and int32_t samples run in fixed point like TBiquadCascade.
+ *
+ * Not thread-safe, owning nodes have to lock.
+ */
+template <typename T>
+class TBandSplitter
+{
+public:
+    struct Output {
+        /// Weight per input channel
+        std::vector<float> mix;
+        /// Filters, one section each (up to simd::maxLaneSections)
+        std::vector<Filter> filters;
+        /// Linear gain
+        float gain = 1.0f;
+    };
+
+    TBandSplitter(uint8_t inputChannelCount = 2, uint32_t rate = 44100);
+
+    /// Set number of input channels (1 to simd::maxLaneInputs). Resets history on change.
+    void setInputChannelCount(uint8_t channelCount);
+    uint8_t inputChannelCount() const;
+
+    /// Set outputs. Resets history.
+    void setOutputs(const std::vector<Output>& outputs);
+    const std::vector<Output>& outputs() const;
+    std::size_t outputCount() const;
+
+    void setRate(uint32_t rate);
+
+    /// Sections per output (longest output)
+    std::size_t sectionCount() const;
+
+    /// Clear history.
+    void reset();
+
+    /// Process interleaved frames. in and out must not overlap.
+    void process(const T* in, T* out, uint32_t frameCount);
+
+private:
+    void update();
+
+    using State = typename TBiquadCascade<T>::State;
+
+    uint8_t m_inputChannelCount;
+    uint32_t m_rate;
+    std::vector<Output> m_outputs;
+
+    // Outputs padded to lanes of 8. All arrays are lane-major.
+    std::size_t m_stride = 0;
+    std::size_t m_sectionCount = 0;
+    std::vector<State> m_mix;
+    std::vector<State> m_coeffs;
+    std::vector<State> m_history;
+};
+
+using BandSplitter = TBandSplitter<float>;
+
+} // namespace audio
+} // namespace coro
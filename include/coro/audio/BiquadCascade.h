@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "TBiquad.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace coro {
+namespace audio {
+
+template <typename T> class TCoefficientSet;
+
+/**
+ * @brief Cascade of biquad sections, processed fused.
+ *
+ * All sections run back to back on each frame, instead of streaming the
+ * whole buffer once per section. Coefficients of all sections sit in one
+ * contiguous array, the history of all sections and channels in one aligned
+ * block.
+ *
+ * float samples run through the SIMD kernel. Denormals are handled
+ * according to audio::denormalMode().
+ *
+ * int16_t and int32_t samples run in fixed point without any float math:
+ * samples and history are Q31 (int16_t is promoted), feed-forward
+ * coefficients Q25 (+-64, shelves up to about +30 dB), feedback coefficients
+ * Q28 and products accumulate in 64 bit without overflow. Output saturates.
+ * Coefficients, which do not fit, are clamped with a warning.
+ *
+ * Precomputed coefficients (see TCoefficientBank) are swapped in lock-free
+ * with setPreset(). Otherwise, not thread-safe, owning nodes have to lock.
+ * Filters set directly are precomputed for all common rates as well, so rate
+ * and gain changes do not compute coefficients in the audio thread.
+ */
+template <typename T>
+class TBiquadCascade
+{
+public:
+    // Type of coefficients and history
+    using State = std::conditional_t<std::is_floating_point<T>::value, T, int32_t>;
+
+    TBiquadCascade(uint8_t channelCount = 2, uint32_t rate = 44100);
+
+    /// Set number of channels. Resets history on change.
+    void setChannelCount(uint8_t channelCount);
+    uint8_t channelCount() const;
+
+    void setRate(uint32_t rate);
+
+    /**
+     * @brief Set filters, one section per filter.
+     *
+     * Invalid and unsupported filters are skipped, as well as filters
+     * beyond simd::maxCascadeSections. The same filter can be set multiple
+     * times (e.g. Linkwitz-Riley crossovers).
+     */
+    void setFilters(const std::vector<Filter>& filters);
+
+    /**
+     * @brief Set filters with coefficients precomputed by the caller.
+     *
+     * Only swaps the set, so owning nodes build it outside of their lock.
+     * Rates missing in the set are computed on demand.
+     */
+    void setFilters(std::shared_ptr<const TCoefficientSet<T>> filterSet);
+
+    /// Return filters of the latest preset or filters set directly.
+    std::vector<Filter> filters() const;
+
+    /**
+     * @brief Set precomputed coefficients.
+     *
+     * Can be called from any thread without locking the audio thread, the
+     * preset is picked up by the next process() call. No coefficients are
+     * computed (unless the preset misses the current rate) and history is
+     * kept. The cascade holds the preset, as long as the audio thread might
+     * use it.
+     */
+    void setPreset(std::shared_ptr<const TCoefficientSet<T>> preset);
+
+    /// Set linear gain, which is folded into the coefficients of first section.
+    void setGain(float gain);
+
+    /// Number of active sections.
+    std::size_t sectionCount() const;
+
+    /// Clear history of all sections.
+    void reset();
+
+    /**
+     * @brief Process interleaved frames.
+     *
+     * If there are no active sections, input is copied (with gain) to output.
+     * in and out might be the same.
+     */
+    void process(const T* in, T* out, uint32_t frameCount, uint8_t inSpacing, uint8_t outSpacing);
+
+    /**
+     * @brief Process planar frames (channelCount() planes of frameCount samples).
+     *
+     * Channels run one after another, so they are not vectorized. in and
+     * out might be the same.
+     */
+    void processPlanar(const T* in, T* out, uint32_t frameCount);
+
+    /// Fractional bits of fixed point feedback coefficients (a1, a2)
+    static constexpr int coeffBits = 28;
+    /// Fractional bits of fixed point feed-forward coefficients (b0..b2)
+    static constexpr int feedForwardBits = 25;
+
+    /**
+     * @brief Compute coefficients of all valid filters (up to
+     * simd::maxCascadeSections) with gain folded into first section.
+     */
+    static void computeCoefficients(const std::vector<Filter>& filters, uint32_t rate, double gain,
+                                    std::vector<State>& coeffs);
+
+private:
+    void update();
+    void pickUpPreset();
+    void applyPreset();
+    void processLanes(const T* in, T* out, uint32_t frameCount, uint8_t channelCount,
+                      uint8_t inSpacing, uint8_t outSpacing, std::size_t lane);
+    void clearHistory(std::size_t fromSection, std::size_t toSection);
+
+    uint8_t m_channelCount = 2;
+    uint32_t m_rate = 44100;
+    float m_gain = 1.0f;
+
+    // b0, b1, b2, a1, a2 per section. Capacity for all sections is reserved.
+    std::vector<State> m_coeffs;
+
+    // Filters set directly
+    std::shared_ptr<const TCoefficientSet<T>> m_filterSet;
+
+    // Preset used by the audio thread and the one handed over to it
+    const TCoefficientSet<T>* m_preset = nullptr;
+    std::atomic<const TCoefficientSet<T>*> m_pendingPreset { nullptr };
+
+    // Keep presets alive while the audio thread might use them: the latest
+    // one and the one picked up before (guarded by m_presetMutex).
+    std::shared_ptr<const TCoefficientSet<T>> m_latestPreset;
+    std::shared_ptr<const TCoefficientSet<T>> m_usedPreset;
+    mutable std::mutex m_presetMutex;
+
+    // z1 and z2 per tap (up to maxCascadeSections+1), each padded to whole lanes
+    struct alignas(32) Lanes {
+        State v[32/sizeof(State)] = {};
+    };
+    std::size_t m_lanesPerState = 1;
+    std::vector<Lanes> m_history;
+};
+
+using BiquadCascade = TBiquadCascade<float>;
+
+} // namespace audio
+} // namespace coro
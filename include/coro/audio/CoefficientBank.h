@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <coro/audio/AudioTypes.h>
+#include <coro/audio/BiquadCascade.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace coro {
+namespace audio {
+
+/**
+ * @brief Coefficients of a set of filters, precomputed for several rates.
+ *
+ * Immutable after construction, so it can be shared between threads.
+ * Fixed point sets support boosts up to about +30 dB, coefficients of
+ * stronger boosts are clamped (see TBiquadCascade).
+ */
+template <typename T>
+class TCoefficientSet
+{
+public:
+    using State = typename TBiquadCascade<T>::State;
+
+    TCoefficientSet(const std::vector<Filter>& filters,
+                    SampleRates rates = SampleRate::Rate32000 | SampleRate::Rate44100 | SampleRate::Rate48000 |
+                                        SampleRate::Rate96000 | SampleRate::Rate192000);
+
+    const std::vector<Filter>& filters() const;
+
+    /// b0, b1, b2, a1, a2 per section at rate. nullptr, if rate was not precomputed.
+    const std::vector<State>* coeffs(uint32_t rate) const;
+
+private:
+    std::vector<Filter> m_filters;
+    std::vector<std::pair<uint32_t, std::vector<State>>> m_coeffs;
+};
+
+/**
+ * @brief Named filter presets, precomputed for all supported rates.
+ *
+ * Switching presets (see TPeq::setPreset()) or rates does not compute any
+ * coefficients in the audio thread. Presets are shared with the filters
+ * using them, so replaced presets are released once no filter uses them
+ * anymore.
+ */
+template <typename T>
+class TCoefficientBank
+{
+public:
+    TCoefficientBank(SampleRates rates = SampleRate::Rate32000 | SampleRate::Rate44100 | SampleRate::Rate48000 |
+                                         SampleRate::Rate96000 | SampleRate::Rate192000);
+
+    /// Precompute and store preset. Replaces existing preset with same name.
+    std::shared_ptr<const TCoefficientSet<T>> setPreset(const std::string& name, const std::vector<Filter>& filters);
+
+    /// Returns preset or nullptr.
+    std::shared_ptr<const TCoefficientSet<T>> preset(const std::string& name) const;
+
+    std::vector<std::string> presetNames() const;
+
+private:
+    const SampleRates m_rates;
+    std::map<std::string, std::shared_ptr<const TCoefficientSet<T>>> m_presets;
+
+    mutable std::mutex m_mutex;
+};
+
+using CoefficientSet = TCoefficientSet<float>;
+using CoefficientBank = TCoefficientBank<float>;
+
+} // namespace audio
+} // namespace coro
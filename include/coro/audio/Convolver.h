@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <coro/audio/AudioNode.h>
+#include <coro/audio/PartitionedConvolver.h>
+
+#include <memory>
+#include <mutex>
+
+namespace coro {
+namespace audio {
+
+/**
+ * FIR convolution (e.g. room correction) with one impulse response per
+ * channel. Long impulse responses (several 10k taps) run in partitions,
+ * see PartitionedConvolver.
+ *
+ * Output is delayed by latency() frames. Buffers pass unchanged, if no
+ * impulse responses are set or they do not match the stream's channel
+ * count and rate.
+ */
+class Convolver : public audio::AudioNode
+{
+public:
+    /// See PartitionedConvolver::PartitionedConvolver()
+    Convolver(std::size_t blockSize = 256, std::size_t tailBlockSize = 0);
+
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 2> caps() {
+        return {{
+                { { AudioCapRaw<float> { SampleRate::Rate44100 | SampleRate::Rate48000 } }, // in
+                  { AudioCapRaw<float> { SampleRate::Rate44100 | SampleRate::Rate48000 } }}, // out
+                { { AudioCapRaw<float> { SampleRate::Rate44100 | SampleRate::Rate48000, ChannelFlags::Any, core::CapFlag::Planar } }, // in
+                  { AudioCapRaw<float> { SampleRate::Rate44100 | SampleRate::Rate48000, ChannelFlags::Any, core::CapFlag::Planar } }}  // out
+            }};
+    }
+
+    /**
+     * @brief Set impulse responses, one per channel, measured at rate.
+     *
+     * Filter spectra are computed in the calling thread, processing
+     * continues with the previous ones meanwhile.
+     */
+    void setImpulseResponses(const std::vector<std::vector<float>>& impulseResponses, uint32_t rate);
+
+    /// Latency in frames
+    std::size_t latency() const;
+
+private:
+    const char* name() const override;
+    void onProcess(core::BufferPtr& buffer) override;
+
+    const std::size_t m_blockSize;
+    const std::size_t m_tailBlockSize;
+
+    uint32_t m_rate = 0;
+    std::unique_ptr<PartitionedConvolver> m_convolver;
+    bool m_isMatching = true;
+
+    std::mutex m_mutex;
+};
+
+} // namespace audio
+} // namespace coro
@@ -20,58 +20,79 @@
 #include <mutex>
 
 #include "AudioNode.h"
-#include "TBiquad.h"
+#include "BandSplitter.h"
 
 namespace coro {
 namespace audio {
 
-class Crossover : public audio::AudioNode
+class FusedChain;
+
+/**
+ * Active speaker crossover. Splits stereo into 2, 3 or 4 bands (Linkwitz-Riley,
+ * phase compensated, so bands sum up to an all-pass) and optionally a mono
+ * LFE channel. Sample type T is float, int16_t or int32_t (fixed point).
+ *
+ * Output channels are the bands from low to high (Stereo, RearStereo,
+ * SideStereo, TopStereo), followed by Lfe. So, 2-way is Quad, 2-way with LFE
+ * is Surround41 and LFE only (mains high-passed) is Surround21.
+ *
+ * All bands run in one pass over the input with gains folded into the
+ * coefficients (see TBandSplitter).
+ */
+template <typename T>
+class TCrossover : public audio::AudioNode
 {
 public:
-    Crossover();
+    TCrossover();
 
     static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
         return {{{
-                { AudioCapRaw<float> { SampleRate::Rate44100 | SampleRate::Rate48000 } }, // in
-                { AudioCapRaw<float> { SampleRate::Rate44100 | SampleRate::Rate48000 } }  // out
+                { AudioCapRaw<T> { SampleRate::Rate44100 | SampleRate::Rate48000 } }, // in
+                { AudioCapRaw<T> { SampleRate::Rate44100 | SampleRate::Rate48000 } }  // out
                }}};
     }
 
+    /// Maximum number of crossover points (4-way)
+    static constexpr std::size_t maxFilterCount = 3;
+
+    /**
+     * @brief Set 2-way crossover.
+     *
+     * q <= 0.5 is LR2, otherwise LR4. A positive g attenuates the band
+     * below f, a negative g the band above.
+     */
     void setFilter(const Filter& f);
-    //float frequency();
 
+    /// Set crossover points (up to maxFilterCount) for 2- to 4-way. See setFilter().
+    void setFilters(const std::vector<Filter>& filters);
+    std::vector<Filter> filters();
+
+    /// Enable LFE: lowest band is high-passed at lfeFrequency, LFE gets the low-passed mono sum.
     void setLfe(bool enable);
     bool lfe();
 
+    static constexpr float lfeFrequency = 80.0f;
+
 private:
     const char* name() const override;
-    AudioConf onProcess(const AudioConf& conf, core::Buffer& buffer) override;
-
-    //bool isFrequencyValid() const;
-    void updateCrossover();
-    void updateLfe();
-
-    template<typename InFrame, typename OutFrame>
-    static void processLfe(InFrame* inFrames, OutFrame* outFrames, std::uint32_t frameCount)
-    {
-        for (std::uint32_t i = 0; i < frameCount; ++i) {
-            outFrames[i].lfe = inFrames[i].left*M_SQRT1_2/*0.5*/ + inFrames[i].right*M_SQRT1_2/*0.5*/;
-        }
-    }
+    void onProcess(core::BufferPtr& buffer) override;
 
-    Filter  m_filter;
-    bool    m_lfe;
+    void update();
 
-    TBiquad<float, float> m_lp;
-    TBiquad<float, float> m_hp;
-    TBiquad<float, float> m_lfeLp;
-    TBiquad<float, float> m_lfeHp;
+    std::vector<Filter> m_filters;
+    bool    m_lfe = false;
+    ChannelFlags m_channels = Channels::Stereo;
 
-    float m_lowGain = 1.0f;
-    float m_highGain = 1.0f;
+    TBandSplitter<T> m_splitter;
 
     std::mutex m_mutex;
+
+    friend class FusedChain;
 };
 
+using Crossover = TCrossover<float>;
+using CrossoverInt16 = TCrossover<int16_t>;
+using CrossoverInt32 = TCrossover<int32_t>;
+
 } // namespace audio
 } // namespace coro
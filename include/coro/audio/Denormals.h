@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace coro {
+namespace audio {
+
+/**
+ * @brief Handling of denormal (subnormal) floats in the DSP chain.
+ *
+ * When a stream goes quiet, the history of recursive filters decays into
+ * denormals, which are several times slower to compute on most CPUs.
+ */
+enum class DenormalMode : uint8_t {
+    Off = 0,        ///< Denormals are processed as they are
+    FlushToZero,    ///< FTZ/DAZ is set while processing (falls back to DcOffset if CPU can't)
+    DcOffset        ///< A tiny offset is added within recursive filters
+};
+
+/// Set denormal mode for all DSP nodes. Default is FlushToZero.
+void setDenormalMode(DenormalMode mode);
+DenormalMode denormalMode();
+
+/// Returns true, if FTZ/DAZ can be set on this platform.
+bool canFlushDenormals();
+
+/// Returns offset to be added within recursive filters (0.0 if not needed).
+float denormalOffset();
+
+/**
+ * @brief Scoped FTZ/DAZ for the calling thread.
+ *
+ * Sets FTZ/DAZ on construction (if mode is FlushToZero) and restores the
+ * previous state on destruction. Nested scopes do not touch the control
+ * register again.
+ */
+class ScopedDenormalFlush
+{
+public:
+    ScopedDenormalFlush();
+    ~ScopedDenormalFlush();
+
+    ScopedDenormalFlush(const ScopedDenormalFlush&) = delete;
+    ScopedDenormalFlush& operator=(const ScopedDenormalFlush&) = delete;
+
+private:
+    uint64_t m_state = 0;
+    bool m_restore = false;
+};
+
+} // namespace audio
+} // namespace coro
@@ -27,7 +27,7 @@ class FileSink : public core::Sink
 {
 public:
     static constexpr std::array<AudioCap,1> inCaps() {
-        return {{ { AudioCodec::RawInt16 | AudioCodec::RawFloat32 | AudioCodec::Ac3 } }};
+        return {{ { AudioCodec::RawInt16 | AudioCodec::RawInt32 | AudioCodec::RawFloat32 | AudioCodec::Ac3 } }};
     }
 
     FileSink();
@@ -39,10 +39,11 @@ private:
     const char* name() const override;
     void onStart() override;
     void onStop() override;
-    AudioConf onProcess(const AudioConf& conf, core::Buffer& buffer) override;
+    void onProcess(core::BufferPtr& buffer) override;
 
     std::string m_fileName;
     std::ofstream m_file;
+    bool m_isRejected = false;
 };
 
 } // namespace audio
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <coro/audio/AudioNode.h>
+#include <coro/audio/BandSplitter.h>
+#include <coro/audio/BiquadCascade.h>
+
+#include <memory>
+#include <vector>
+
+namespace coro {
+namespace audio {
+
+/**
+ * @brief Fuses a chain of linked DSP nodes into one block-based kernel.
+ *
+ * Link this node in front of a chain and call compile(). It fuses the
+ * longest run of downstream nodes matching
+ *
+ *     [AudioConverter<int16_t,float>] (Loudness | Peq)* [Crossover] [AudioConverter<float,int16_t>]
+ *
+ * and links itself to the first node behind that run, so fused nodes are
+ * skipped. Buffers are processed in blocks of blockSize frames, which stay
+ * in cache: conversion in, all biquad sections (with volume folded into the
+ * first one), crossover bands and saturating conversion out.
+ *
+ * Parameters are still set on the fused nodes. Their setters bump
+ * AudioNode::revision(), on which the kernel is rebuilt (under the node's
+ * lock), so steady state processing does not lock at all. Bypass of
+ * Loudness, Peq and Crossover is followed as well. Bypassing this node
+ * bypasses all fused nodes.
+ */
+class FusedChain : public AudioNode
+{
+public:
+    FusedChain();
+    ~FusedChain();
+
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{ { core::AnyCap {} }, // in
+                   { core::AnyCap {} }  // out
+               }}};
+    }
+
+    static constexpr bool isForwarding = true;
+
+    /// Frames processed per block
+    static constexpr uint32_t blockSize = 256;
+
+    /**
+     * @brief Fuse downstream nodes.
+     *
+     * Relinking this node undoes fusion, so call it again after linking.
+     * Not to be called while processing.
+     *
+     * @return number of fused nodes. If less than two nodes can be fused,
+     * nothing is fused and this node passes through.
+     */
+    std::size_t compile();
+
+    /// Fused nodes in processing order
+    std::vector<AudioNode*> nodes() const;
+
+private:
+    enum class Kind : uint8_t {
+        ConverterIn,
+        Loudness,
+        Peq,
+        Crossover,
+        ConverterOut
+    };
+
+    struct Stage {
+        AudioNode* node;
+        Kind kind;
+        uint32_t revision = 0;
+        bool isBypassed = false;
+    };
+
+    const char* name() const override;
+    void setNext(core::Node* next) override;
+    void onProcess(core::BufferPtr& buffer) override;
+
+    bool isDirty() const;
+    void rebuild();
+
+    core::Node* m_head = nullptr;
+    std::vector<Stage> m_stages;
+    bool m_isInt16In = false;
+    bool m_isInt16Out = false;
+
+    // Sections of all Loudness and Peq stages, split up into cascades of simd::maxCascadeSections
+    std::vector<std::unique_ptr<BiquadCascade>> m_cascades;
+    BandSplitter m_splitter;
+    ChannelFlags m_channels = Channels::Stereo;
+
+    std::vector<float> m_block;
+    std::vector<float> m_bands;
+};
+
+} // namespace audio
+} // namespace coro
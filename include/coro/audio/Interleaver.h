@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <coro/audio/AudioNode.h>
+
+namespace coro {
+namespace audio {
+
+/**
+ * @brief Converts interleaved frames into channel planes.
+ *
+ * Placed once behind the decoder, so following nodes (e.g. Convolver) run on
+ * contiguous channels. Sample type T is float, int16_t or int32_t.
+ */
+template <typename T>
+class TDeinterleaver : public AudioNode
+{
+public:
+    TDeinterleaver();
+
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{
+                { { AudioCapRaw<T> { } }, // in
+                  { AudioCapRaw<T> { SampleRates::Any, ChannelFlags::Any, core::CapFlag::Planar } }}
+               }};
+    }
+
+private:
+    const char* name() const override;
+    void onProcess(core::BufferPtr& buffer) override;
+};
+
+/**
+ * @brief Converts channel planes back into interleaved frames.
+ *
+ * Placed once in front of sinks, which only take interleaved frames.
+ */
+template <typename T>
+class TInterleaver : public AudioNode
+{
+public:
+    TInterleaver();
+
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{
+                { { AudioCapRaw<T> { SampleRates::Any, ChannelFlags::Any, core::CapFlag::Planar } }, // in
+                  { AudioCapRaw<T> { } }}
+               }};
+    }
+
+private:
+    const char* name() const override;
+    void onProcess(core::BufferPtr& buffer) override;
+};
+
+/**
+ * @brief Interleaves a planar raw buffer in place. Other buffers are left untouched.
+ *
+ * For sinks, which accept planar buffers of any raw sample type.
+ */
+void interleave(core::Buffer& buffer, const core::Node* caller = nullptr);
+
+using Deinterleaver = TDeinterleaver<float>;
+using DeinterleaverInt16 = TDeinterleaver<int16_t>;
+using DeinterleaverInt32 = TDeinterleaver<int32_t>;
+using Interleaver = TInterleaver<float>;
+using InterleaverInt16 = TInterleaver<int16_t>;
+using InterleaverInt32 = TInterleaver<int32_t>;
+
+} // namespace audio
+} // namespace coro
@@ -18,25 +18,31 @@
 #pragma once
 
 #include <coro/audio/AudioNode.h>
-
-#include "TBiquad.h"
+#include <coro/audio/BiquadCascade.h>
 
 #include <mutex>
 
 namespace coro {
 namespace audio {
 
-class Loudness : public audio::AudioNode
+class FusedChain;
 
+/**
+ * Loudness compensation. Sample type T is float, int16_t or int32_t (fixed point).
+ */
+template <typename T>
+class TLoudness : public audio::AudioNode
 {
 public:
-    Loudness();
+    TLoudness();
 
-    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
-        return {{{
-                { AudioCapRaw<float> { SampleRate::Rate44100 | SampleRate::Rate48000 } }, // in
-                { AudioCapRaw<float> { SampleRate::Rate44100 | SampleRate::Rate48000 } }  // out
-               }}};
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 2> caps() {
+        return {{
+                { { AudioCapRaw<T> { SampleRate::Rate44100 | SampleRate::Rate48000 } }, // in
+                  { AudioCapRaw<T> { SampleRate::Rate44100 | SampleRate::Rate48000 } }}, // out
+                { { AudioCapRaw<T> { SampleRate::Rate44100 | SampleRate::Rate48000, ChannelFlags::Any, core::CapFlag::Planar } }, // in
+                  { AudioCapRaw<T> { SampleRate::Rate44100 | SampleRate::Rate48000, ChannelFlags::Any, core::CapFlag::Planar } }}  // out
+            }};
     }
 
     void setLevel(uint8_t phon);
@@ -45,17 +51,22 @@ public:
 
 private:
     const char* name() const override;
-    AudioConf onProcess(const AudioConf& conf, core::Buffer& buffer) override;
+    void onProcess(core::BufferPtr& buffer) override;
 
     float   m_headroom = 1.0;
     float   m_volume = 1.0;
 
-    TBiquad<float, float>   m_tpk1;
-    TBiquad<float, float>   m_tpk2;
-    TBiquad<float, float>   m_ths;
+    // Peak, peak and high shelf. Volume is folded in as gain.
+    TBiquadCascade<T> m_cascade;
 
     std::mutex m_mutex;
+
+    friend class FusedChain;
 };
 
+using Loudness = TLoudness<float>;
+using LoudnessInt16 = TLoudness<int16_t>;
+using LoudnessInt32 = TLoudness<int32_t>;
+
 } // namespace audio
 } // namespace coro
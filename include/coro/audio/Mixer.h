@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <coro/audio/AudioCaps.h>
+#include <coro/audio/AudioNode.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace coro {
+namespace audio {
+
+class Mixer;
+
+/**
+ * Input of a Mixer. Upstream nodes link to this.
+ */
+class MixerInput : public core::Node
+{
+public:
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{ { AudioCapRaw<float> {} }, // in
+                   { core::NoCap {} }         // out
+               }}};
+    }
+
+    static constexpr bool isForwarding = true;
+
+    void setGain(float gain);
+    float gain() const;
+
+private:
+    MixerInput(Mixer& mixer);
+
+    const char* name() const override;
+    void onStop() override;
+    void onProcess(core::BufferPtr& buffer) override;
+
+    Mixer& m_mixer;
+    std::atomic<float> m_gain = 1.0f;
+
+    // Guarded by mixer
+    std::vector<float> m_samples;
+    size_t  m_readPos = 0;
+    size_t  m_audibleEnd = 0;   // Samples behind this position are silent
+    bool    m_isActive = false;
+    bool    m_isRejected = false;
+
+    friend class Mixer;
+};
+
+/**
+ * Mixer sums multiple inputs with individual gains.
+ *
+ * Incoming samples are aligned into blocks of fixed size. A block is emitted
+ * as soon as every active input provided it. If an input falls behind by more
+ * than maxPendingBlocks, it is considered missing and skipped. Missing inputs,
+ * inputs with zero gain and silent input blocks are not processed at all.
+ *
+ * Downstream nodes are processed by the thread of the input, which completed
+ * a block, outside of the mixer lock. If another thread is still processing
+ * downstream nodes, that thread emits the block as well.
+ */
+class Mixer : public AudioNode
+{
+public:
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{ { core::NoCap {} },        // in
+                   { AudioCapRaw<float> {} }  // out
+               }}};
+    }
+
+    static constexpr bool isForwarding = true;
+
+    static constexpr uint32_t maxPendingBlocks = 4;
+
+    /**
+     * @param inputCount number of inputs
+     * @param blockFrames number of frames per emitted block (at least 1)
+     */
+    Mixer(size_t inputCount = 2, uint32_t blockFrames = 256);
+    ~Mixer();
+
+    MixerInput& input(size_t index);
+    size_t inputCount() const;
+
+    uint32_t blockFrames() const;
+
+private:
+    const char* name() const override;
+
+    void push(MixerInput& input, const core::Buffer& buffer);
+    void stop(MixerInput& input);
+    void mix();
+    void emit();
+
+    std::vector<std::unique_ptr<MixerInput>> m_inputs;
+    const uint32_t m_blockFrames;
+    AudioConf   m_conf;
+    std::mutex  m_mutex;
+
+    // Guarded by m_mutex
+    std::vector<float> m_pending;   // Mixed blocks, not emitted yet
+    bool    m_isStopPending = false;
+
+    // Owned by the emitting thread
+    std::atomic<bool> m_isEmitting = false;
+    core::BufferPtr m_output;
+
+    friend class MixerInput;
+};
+
+} // namespace audio
+} // namespace coro
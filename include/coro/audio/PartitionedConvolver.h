@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace coro {
+namespace audio {
+
+/**
+ * @brief Multichannel FIR convolution, uniformly partitioned overlap-save.
+ *
+ * Impulse responses are split into partitions of blockSize taps. Each block
+ * of input is transformed once (FFT of 2*blockSize) and multiplied with the
+ * spectra of all partitions (frequency domain delay line). So, cost grows
+ * with the number of partitions instead of the number of taps.
+ *
+ * Optionally, partitioning is non-uniform with two stages: the first
+ * 2*tailBlockSize taps run in partitions of blockSize (head), the remaining
+ * taps in partitions of tailBlockSize (tail). Latency stays at blockSize,
+ * while long impulse responses need far fewer partitions. The tail is
+ * computed in the calling thread. Since its output is due one tail block
+ * later, its work is spread across the tailBlockSize/blockSize blocks in
+ * between, so no single block takes the whole tail.
+ *
+ * Two channels share one complex FFT (one as real, one as imaginary part),
+ * spectra are stored split into real and imaginary parts, so the multiply-
+ * accumulate runs in SIMD (see simd::complexMulAdd()).
+ *
+ * Not thread-safe, owning nodes have to lock.
+ */
+class PartitionedConvolver
+{
+public:
+    /**
+     * @param blockSize partition size (and latency) in frames, power of two.
+     * @param tailBlockSize partition size of tail in frames, 0 for uniform
+     *        partitioning. Otherwise, a multiple of blockSize.
+     */
+    PartitionedConvolver(std::size_t blockSize = 256, std::size_t tailBlockSize = 0);
+    ~PartitionedConvolver();
+
+    /// Set one impulse response per channel. Sets channel count and resets history.
+    void setImpulseResponses(const std::vector<std::vector<float>>& impulseResponses);
+
+    std::size_t channelCount() const;
+    std::size_t blockSize() const;
+    std::size_t tailBlockSize() const;
+
+    /// Latency in frames
+    std::size_t latency() const;
+
+    /// Clear history.
+    void reset();
+
+    /**
+     * @brief Process interleaved frames of channelCount() channels.
+     *
+     * Output is delayed by latency(). in and out might be the same.
+     */
+    void process(const float* in, float* out, uint32_t frameCount);
+
+    /**
+     * @brief Process planar frames (channelCount() planes of frameCount samples).
+     *
+     * Same as process(), but blocks are copied without (de)interleaving.
+     */
+    void processPlanar(const float* in, float* out, uint32_t frameCount);
+
+private:
+    class Stage;
+
+    void processBlock();
+
+    std::size_t m_blockSize;
+    std::size_t m_tailBlockSize;
+    std::size_t m_channelCount = 0;
+
+    std::unique_ptr<Stage> m_head;
+    std::unique_ptr<Stage> m_tail;
+
+    // Planar blocks of input and output, filled up to m_pos
+    std::vector<float> m_input;
+    std::vector<float> m_output;
+    std::size_t m_pos = 0;
+    std::size_t m_tailPos = 0;
+};
+
+} // namespace audio
+} // namespace coro
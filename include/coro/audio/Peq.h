@@ -18,25 +18,32 @@
 #pragma once
 
 #include <coro/audio/AudioNode.h>
+#include <coro/audio/BiquadCascade.h>
+#include <coro/audio/CoefficientBank.h>
 
-#include "TBiquad.h"
-
-#include <deque>
 #include <mutex>
 
 namespace coro {
 namespace audio {
 
-class Peq : public audio::AudioNode
+class FusedChain;
+
+/**
+ * Parametric EQ. Sample type T is float, int16_t or int32_t (fixed point).
+ */
+template <typename T>
+class TPeq : public audio::AudioNode
 {
 public:
-    Peq();
+    TPeq();
 
-    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
-        return {{{
-                { AudioCapRaw<float> { SampleRate::Rate44100 | SampleRate::Rate48000 } }, // in
-                { AudioCapRaw<float> { SampleRate::Rate44100 | SampleRate::Rate48000 } }  // out
-               }}};
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 2> caps() {
+        return {{
+                { { AudioCapRaw<T> { SampleRate::Rate44100 | SampleRate::Rate48000 } }, // in
+                  { AudioCapRaw<T> { SampleRate::Rate44100 | SampleRate::Rate48000 } }}, // out
+                { { AudioCapRaw<T> { SampleRate::Rate44100 | SampleRate::Rate48000, ChannelFlags::Any, core::CapFlag::Planar } }, // in
+                  { AudioCapRaw<T> { SampleRate::Rate44100 | SampleRate::Rate48000, ChannelFlags::Any, core::CapFlag::Planar } }}  // out
+            }};
     }
 
     void setVolume(float volume);
@@ -44,17 +51,26 @@ public:
     void setFilters(const std::vector<Filter> filters);
     std::vector<Filter> filters();
 
+    /// Switch to a precomputed preset (see TCoefficientBank). Does not lock.
+    void setPreset(std::shared_ptr<const TCoefficientSet<T>> preset);
+
 private:
     const char* name() const override;
-    AudioConf onProcess(const AudioConf& conf, core::Buffer& buffer) override;
+    void onProcess(core::BufferPtr& buffer) override;
 
     float               m_volume = 1.0;
-    std::deque<TBiquad<float, float>> m_tBiquads;
+    TBiquadCascade<T>   m_cascade;
 
     AudioConf m_conf;
 
     std::mutex m_mutex;
+
+    friend class FusedChain;
 };
 
+using Peq = TPeq<float>;
+using PeqInt16 = TPeq<int16_t>;
+using PeqInt32 = TPeq<int32_t>;
+
 } // namespace audio
 } // namespace coro
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace coro {
+namespace audio {
+
+/**
+ * @brief Polyphase sample rate converter for interleaved float frames.
+ *
+ * The ratio outRate/inRate is reduced to L/M. A windowed sinc (Kaiser) is
+ * precomputed as a bank of L phases, so each output sample is a single
+ * dot product over the taps of one phase (see simd::dotProduct()). The
+ * cutoff follows the lower of both rates, so downsampling is anti-aliased.
+ *
+ * Not thread-safe, owning nodes have to lock.
+ */
+class PolyphaseResampler
+{
+public:
+    PolyphaseResampler(uint32_t inRate = 44100, uint32_t outRate = 48000, uint8_t channelCount = 2);
+
+    /// Set rates. Rebuilds filter bank and resets history on change.
+    void setRates(uint32_t inRate, uint32_t outRate);
+    uint32_t inRate() const;
+    uint32_t outRate() const;
+
+    /// Set number of channels. Resets history on change.
+    void setChannelCount(uint8_t channelCount);
+    uint8_t channelCount() const;
+
+    /// Taps per phase
+    std::size_t tapCount() const;
+
+    /// Latency in input frames. Output itself is not shifted: output frame n
+    /// is at input frame n*inRate/outRate.
+    uint32_t latency() const;
+
+    /// Upper bound of output frames for the given number of input frames.
+    uint32_t maxOutputFrames(uint32_t frameCount) const;
+
+    /// Clear history.
+    void reset();
+
+    /**
+     * @brief Process interleaved frames.
+     *
+     * If both rates are equal, input is copied. in and out must not overlap
+     * and out needs room for maxOutputFrames().
+     *
+     * @return number of output frames
+     */
+    uint32_t process(const float* in, uint32_t frameCount, float* out);
+
+private:
+    void update();
+
+    uint32_t m_inRate;
+    uint32_t m_outRate;
+    uint8_t m_channelCount;
+
+    // Interpolation (L) and decimation (M) factor
+    uint32_t m_up = 1;
+    uint32_t m_down = 1;
+
+    // Taps per phase, multiple of 8
+    std::size_t m_tapCount = 0;
+    // Phase after phase, tap t applies to frame t of the window
+    std::vector<float> m_bank;
+
+    // Planar input history, m_historySize frames per channel, each
+    // channel m_stride floats apart
+    std::vector<float> m_history;
+    std::size_t m_stride = 0;
+    std::size_t m_historySize = 0;
+    std::size_t m_pos = 0;
+    uint32_t m_phase = 0;
+};
+
+} // namespace audio
+} // namespace coro
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <coro/audio/AudioNode.h>
+#include <coro/audio/PolyphaseResampler.h>
+
+#include <mutex>
+
+namespace coro {
+namespace audio {
+
+/**
+ * Converts any supported input rate to one fixed output rate, so sinks do
+ * not need to be reopened when sources switch. See PolyphaseResampler.
+ */
+class Resampler : public audio::AudioNode
+{
+public:
+    Resampler(SampleRate rate = SampleRate::Rate48000);
+
+    static constexpr SampleRates rates() {
+        return SampleRate::Rate32000 | SampleRate::Rate44100 | SampleRate::Rate48000 |
+               SampleRate::Rate96000 | SampleRate::Rate192000;
+    }
+
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{
+                { AudioCapRaw<float> { rates() } }, // in
+                { AudioCapRaw<float> { rates() } }  // out
+               }}};
+    }
+
+    /// Set output rate
+    void setRate(SampleRate rate);
+    SampleRate rate() const;
+
+private:
+    const char* name() const override;
+    void onProcess(core::BufferPtr& buffer) override;
+
+    SampleRate m_rate;
+    PolyphaseResampler m_resampler;
+
+    mutable std::mutex m_mutex;
+};
+
+} // namespace audio
+} // namespace coro
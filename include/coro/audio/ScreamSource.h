@@ -38,7 +38,7 @@ public:
     virtual ~ScreamSource();
 
 private:
-    AudioConf onProcess(const AudioConf& conf, core::Buffer& buffer) override;
+    void onProcess(core::BufferPtr& buffer) override;
 
     const char* name() const override;
 };
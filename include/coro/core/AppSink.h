@@ -45,7 +45,7 @@ public:
 
 private:
     virtual const char* name() const override;
-    virtual audio::AudioConf onProcess(const audio::AudioConf& conf, core::Buffer& buffer) override;
+    virtual void onProcess(core::BufferPtr& buffer) override;
     virtual void onStop() override;
 
     class AppSinkPrivate* const d;
@@ -17,8 +17,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 
+#include <sys/uio.h>
+
 namespace coro {
 namespace audio {
 class AudioConf;
@@ -36,6 +39,11 @@ using BufferPtr = std::unique_ptr<Buffer, BufferDeleter>;
 class Buffer
 {
 public:
+    /// Alignment of storage (and of acquired memory) in bytes. Fits cache lines and SIMD registers.
+    static constexpr size_t alignment = 64;
+    /// Max bytes of headers, which are held as separate segment in front of payload.
+    static constexpr size_t maxHeaderSize = 128;
+
     static BufferPtr create(size_t reservedSize = 0, const Node* caller = nullptr);
 
     Buffer(size_t reservedSize = 0);
@@ -53,6 +61,11 @@ public:
     Buffer(const Buffer&) = delete;
     Buffer(Buffer&&) = default;
 
+    /**
+     * @brief Swap contents (storage, segments and conf) with other buffer. Nothing is copied.
+     */
+    void swap(Buffer& other);
+
     /**
      * @brief isValid
      */
@@ -61,24 +74,106 @@ public:
     // @TODO(mawe): change to unsigned char (uint8_t)?
     // openssl, apple alac prefer unsigned.
     // also std::byte inherits from unsigned char.
+    // Non-const access detaches the buffer from shared storage (copy-on-write).
+    // Access to contiguous data flattens segments (see segments()).
     char* data();
     const char* data() const;
+    const char* constData() const;
     size_t size() const;
 
     size_t capacity() const;
 
+    /**
+     * @brief Return true if buffer consists of a single segment.
+     */
+    bool isContiguous() const;
+
+    /**
+     * @brief Return number of segments (header, payload and zero padding).
+     */
+    size_t segmentCount() const;
+
+    /**
+     * @brief Fill given vector with segments of this buffer (scatter/gather).
+     *
+     * Segments can be passed to vectored I/O (e.g. writev(), sendmsg()), so
+     * headers and padding never have to be copied next to the payload.
+     * Segment memory must not be written to.
+     *
+     * @param segments vector to be filled
+     * @param count max number of segments to fill
+     * @return number of filled segments
+     */
+    size_t segments(struct iovec* segments, size_t count) const;
+
+    /**
+     * @brief Create a slice, which shares storage with this buffer.
+     *
+     * No payload is copied. Storage is reference counted and only gets copied
+     * when one of the sharing buffers is written to (copy-on-write). Trimming a
+     * slice never copies.
+     *
+     * @param offset offset of slice relative to payload of this buffer
+     * @param size max size of slice
+     */
+    BufferPtr slice(size_t offset = 0, size_t size = SIZE_MAX) const;
+
+    /**
+     * @brief Return true if storage is shared with other buffers.
+     */
+    bool isShared() const;
+
+    /**
+     * @brief Return free bytes in front of payload.
+     */
+    size_t headroom() const;
+
+    /**
+     * @brief Return free bytes behind payload.
+     */
+    size_t tailroom() const;
+
+    /**
+     * @brief Reserve free space in front of and behind payload.
+     *
+     * Payload is moved (and storage reallocated) only, if current space does
+     * not suffice. This is meant to be called once up front, so that steady
+     * state processing never reallocates.
+     *
+     * @param headroom bytes to be available in front of payload
+     * @param tailroom bytes to be available behind payload
+     * @param caller node requesting the space (for logging purposes)
+     */
+    void reserve(size_t headroom, size_t tailroom, const core::Node* caller = nullptr);
+
+    /**
+     * @brief Acquire uninitialized, aligned memory within this buffer.
+     *
+     * Memory is taken from front or back of the payload. If there is not
+     * enough room, storage gets reallocated. After writing into it, commit()
+     * has to be called to make it the new payload.
+     */
     char* acquire(size_t size, const core::Node* caller = nullptr) const;
     void commit(size_t newSize);
 
     /**
-     * @brief prepend
-     * @param data
-     * @param size
+     * @brief Prepend data (e.g. a header) to buffer.
+     *
+     * Data is written in front of payload, if there is enough headroom.
+     * Otherwise it is held in a separate header segment, so payload is never
+     * moved.
      */
     void prepend(const char* data, uint32_t size);
 
     /**
-     * @brief grow
+     * @brief Pad buffer with zeros up to given size.
+     *
+     * Zeros are attached as separate segment, so payload is never moved.
+     */
+    void pad(size_t size);
+
+    /**
+     * @brief Grow payload to given size (limited by capacity). New bytes are uninitialized.
      */
     void grow(size_t size);
 
@@ -103,9 +198,18 @@ public:
     void trimBack(size_t size);
 
     audio::AudioConf& audioConf();
+    const audio::AudioConf& audioConf() const;
 
 private:
-    class BufferPrivate* const d;
+    void dropStorage();
+    // Replace storage by new one of given capacity. Payload is dropped.
+    void resetStorage(size_t capacity);
+
+    // Size class of BufferPool this buffer was handed out from
+    size_t poolClass() const;
+    void setPoolClass(size_t poolClass);
+
+    class BufferPrivate* d;
 
     friend class BufferPool;
 };
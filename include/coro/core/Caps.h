@@ -34,7 +34,7 @@ class NoCap {
 using AudioFloatCap = audio::AudioCapRaw<float>;
 
 // @TODO(mawe): not sure, if creating a variant is the right thing here.
-class Cap : public std::variant<core::AnyCap, core::NoCap, audio::AudioCap, audio::AudioCapRaw<float>, audio::AudioCapRaw<int16_t>>
+class Cap : public std::variant<core::AnyCap, core::NoCap, audio::AudioCap, audio::AudioCapRaw<float>, audio::AudioCapRaw<int16_t>, audio::AudioCapRaw<int32_t>>
 {
 public:
     template<class OutCaps, class InCaps>
@@ -56,6 +56,10 @@ public:
                     if (audio::AudioCapRaw<int16_t>::intersect(std::get<audio::AudioCapRaw<int16_t>>(outCap.second), std::get<audio::AudioCapRaw<int16_t>>(inCap.first)).isValid()) {
                         return true;
                     }
+                } else if (std::holds_alternative<audio::AudioCapRaw<int32_t>>(outCap.second) && std::holds_alternative<audio::AudioCapRaw<int32_t>>(inCap.first)) {
+                    if (audio::AudioCapRaw<int32_t>::intersect(std::get<audio::AudioCapRaw<int32_t>>(outCap.second), std::get<audio::AudioCapRaw<int32_t>>(inCap.first)).isValid()) {
+                        return true;
+                    }
                 }
             }
         }
@@ -21,44 +21,147 @@
 #include <coro/audio/AudioConf.h>
 #include <coro/core/Buffer.h>
 #include <coro/core/Caps.h>
+#ifdef CORO_NODE_STATS
+#include <coro/core/NodeStats.h>
+#endif
 
 namespace coro {
+namespace audio {
+class Mixer;
+}
 namespace core {
 
+template<class SourceT, class... Stages> class StaticPipeline;
+
 class Node
 {
 public:
     template<class Node1, class Node2>
     static std::enable_if_t<Cap::canIntersect(Node1::caps(), Node2::caps())>
     link(Node1& prev, Node2& next) {
-        prev.m_next = &next;
+        static_cast<Node&>(prev).setNext(&next);
     }
 
+    /**
+     * Nodes handing buffers on to next() themselves (e.g. queues or encoders)
+     * shadow this with true. They cannot be stages of a StaticPipeline.
+     */
+    static constexpr bool isForwarding = false;
+
     /// Return name of node
     virtual const char* name() const = 0;
 
     /// Return next node
     Node* next() const;
 
-    /// Obsolete process method
+    /**
+     * @brief Process buffer by this and all downstream nodes.
+     *
+     * Audio conf travels with the buffer (Buffer::audioConf()). Nodes might
+     * take ownership of the buffer (e.g. queues or encoders). In that case a
+     * pooled buffer of same size is handed back, so buffer is never null on
+     * return.
+     */
+    void process(core::BufferPtr& buffer);
+
+    /// Obsolete process method. Payload is swapped into a pooled buffer (no copy).
     audio::AudioConf process(const audio::AudioConf& conf, core::Buffer& buffer);
 
     bool isBypassed() const;
     void setIsBypassed(bool);
 
+    /// Return bytes this node needs in front of payload (e.g. to prepend headers)
+    size_t headroom() const;
+
+    /// Return space this node needs behind payload, as multiple of incoming payload size
+    float tailroom() const;
+
+    /**
+     * @brief Reserve space in buffer for this and all downstream nodes.
+     *
+     * Sources should call this for their buffers up front, so that no node
+     * has to reallocate during steady state processing. Payload, which is
+     * not in the buffer yet (e.g. a packet to be received), gets space behind
+     * the current payload as well, in front of the space of downstream nodes.
+     *
+     * @param buffer buffer to reserve space in
+     * @param payloadSize max size of payload this node receives
+     */
+    void reserve(core::Buffer& buffer, size_t payloadSize) const;
+
+    /// Block sizes (in frames) supported by block mode
+    static constexpr uint32_t minBlockSize = 32;
+    static constexpr uint32_t maxBlockSize = 256;
+
+    /**
+     * @brief Enable block mode for this and all downstream nodes.
+     *
+     * Raw audio buffers larger than frames are split into blocks, which run
+     * through this node and the whole downstream chain one after another, so
+     * intermediate data stays in L1/L2 cache. Blocks are copied into one
+     * reused buffer. Sinks receive the blocks instead of the whole buffer.
+     * Set it on the first node of a graph (or its source).
+     *
+     * @param frames block size (clamped to minBlockSize..maxBlockSize), 0 disables block mode
+     */
+    void setBlockSize(uint32_t frames);
+    uint32_t blockSize() const;
+
+#ifdef CORO_NODE_STATS
+    /// Enable collection of timing statistics (only available with ENABLE_NODE_STATS)
+    void setStatsEnabled(bool enabled);
+    bool isStatsEnabled() const;
+    const NodeStats& stats() const;
+    NodeStats& stats();
+#endif
+
 protected:
+    /// Called by link(). Nodes with multiple downstream links (e.g. Tee) override this.
+    virtual void setNext(Node* next);
+
+    void setHeadroom(size_t bytes);
+    void setTailroom(float factor);
+
     virtual void onStart();
     virtual void onStop();
-    virtual audio::AudioConf onProcess(const audio::AudioConf& conf, core::Buffer& buffer);
+
+    /**
+     * @brief Process buffer.
+     *
+     * Conf is to be read from and written to buffer. A node might take
+     * ownership of the buffer by moving it out. It might also hand back
+     * another buffer. Default implementation calls obsolete onProcess().
+     */
     virtual void onProcess(core::BufferPtr& buffer);
 
+    /// Obsolete process method. Override onProcess(core::BufferPtr&) instead.
+    virtual audio::AudioConf onProcess(const audio::AudioConf& conf, core::Buffer& buffer);
+
 private:
-    void process(core::BufferPtr& buffer);
+    // Stop this and all downstream nodes, which are not bypassed.
+    void stopChain();
+
+    // Process buffer (or block of it) by this and all downstream nodes.
+    void processBuffer(core::BufferPtr& buffer);
+    void processBlocks(core::BufferPtr& buffer);
 
     Node* m_next = nullptr;
     bool m_isBypassed = false;
+    size_t m_headroom = 0;
+    float m_tailroom = 0.0f;
+
+    uint32_t m_blockSize = 0;
+    core::BufferPtr m_block;
+
+#ifdef CORO_NODE_STATS
+    std::atomic_bool m_isStatsEnabled = false;
+    NodeStats m_stats;
+#endif
 
     friend class Source;
+    friend class Tee;
+    template<class SourceT, class... Stages> friend class StaticPipeline;
+    friend class audio::Mixer;
 };
 
 } // namespace core
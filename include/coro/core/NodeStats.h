@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace coro {
+namespace audio {
+class AudioConf;
+}
+namespace core {
+
+/**
+ * Timing statistics of a node.
+ *
+ * Statistics are written by the processing thread and can be read from any
+ * other thread. They are only collected, if built with ENABLE_NODE_STATS
+ * (CORO_NODE_STATS) and enabled per node (see Node::setStatsEnabled()).
+ */
+class NodeStats
+{
+public:
+    /// Histogram bucket n counts durations in [2^n, 2^(n+1)) ns.
+    static constexpr size_t histogramSize = 32;
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Add a sample of one onProcess() call.
+     *
+     * Audio duration is derived from raw input or, if input is encoded, from
+     * raw output.
+     */
+    void add(const audio::AudioConf& inConf, size_t inBytes,
+             const audio::AudioConf& outConf, size_t outBytes,
+             Clock::duration duration);
+
+    uint64_t count() const;
+    uint64_t bytes() const;
+    uint64_t frames() const;
+
+    /// Return time spent in onProcess()
+    uint64_t processingNs() const;
+    uint64_t maxProcessingNs() const;
+
+    /// Return duration of processed audio
+    uint64_t audioNs() const;
+
+    /// Return processing time divided by audio duration (1.0 is 100 percent of a core)
+    float dspLoad() const;
+
+    std::array<uint64_t, histogramSize> histogram() const;
+
+    /// Reset statistics. Not atomic as a whole.
+    void reset();
+
+private:
+    // Single writer, so no read-modify-write instructions needed.
+    static void add(std::atomic<uint64_t>& value, uint64_t delta) {
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> m_count = 0;
+    std::atomic<uint64_t> m_bytes = 0;
+    std::atomic<uint64_t> m_frames = 0;
+    std::atomic<uint64_t> m_processingNs = 0;
+    std::atomic<uint64_t> m_maxProcessingNs = 0;
+    std::atomic<uint64_t> m_audioNs = 0;
+    std::array<std::atomic<uint64_t>, histogramSize> m_histogram = {};
+};
+
+} // namespace core
+} // namespace coro
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <coro/core/Caps.h>
+#include <coro/core/Node.h>
+
+namespace coro {
+namespace core {
+
+/**
+ * Queue decouples upstream and downstream nodes.
+ *
+ * Incoming buffers are put into a bounded, lock-free ring. Downstream nodes
+ * are processed on a worker thread owned by this queue. So, e.g. network
+ * ingest is not delayed by a blocking output device.
+ */
+class Queue : public Node
+{
+public:
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{ { AnyCap {} }, // in
+                   { AnyCap {} }  // out
+               }}};
+    }
+
+    static constexpr bool isForwarding = true;
+
+    /// Behaviour if queue is full
+    enum class OverflowPolicy {
+        DropOldest, ///< Drop oldest queued buffer to make room (keeps latency low)
+        DropNewest, ///< Drop incoming buffer
+        Block       ///< Block upstream until there is room
+    };
+
+    /**
+     * @param depth max number of queued buffers
+     * @param policy behaviour if queue is full
+     */
+    Queue(size_t depth = 8, OverflowPolicy policy = OverflowPolicy::DropOldest);
+    ~Queue();
+
+    size_t depth() const;
+    OverflowPolicy overflowPolicy() const;
+
+    /// Return number of buffers dropped due to overflow
+    size_t droppedCount() const;
+
+private:
+    const char* name() const override;
+    void onStop() override;
+    void onProcess(core::BufferPtr& buffer) override;
+
+    class QueuePrivate* const d;
+};
+
+} // namespace core
+} // namespace coro
@@ -47,6 +47,9 @@ public:
     virtual void setReadyCallback(ReadyCallback callback);
 
 protected:
+    /// Push buffer (carrying its conf) downstream. Buffer is valid (but maybe replaced) afterwards.
+    void pushBuffer(core::BufferPtr& buffer);
+    /// Obsolete push method
     void pushBuffer(const audio::AudioConf& conf, core::Buffer& buffer);
 
 private:
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <coro/core/Node.h>
+
+#include <algorithm>
+#include <atomic>
+#include <tuple>
+#include <utility>
+
+namespace coro {
+namespace core {
+
+/**
+ * Pipeline with a fixed set of nodes, which is assembled at compile time.
+ *
+ * Stages are held by value in a tuple and called one after another, without
+ * walking next() pointers. Since the dynamic type of each stage is known, the
+ * compiler devirtualizes and inlines their onProcess() calls, so the steady
+ * state path becomes straight-line code. Caps of adjacent nodes are checked
+ * statically (as with Node::link()). Bypass state of all stages is held in
+ * one bitmask.
+ *
+ * The source pushes into the pipeline through one internal entry node, so
+ * sources do not need to know about static pipelines.
+ *
+ * Stages are not linked, so their next() is null. Stages handing buffers on
+ * to next() themselves (Node::isForwarding, e.g. Queue or Tee) would drop
+ * their output and are rejected at compile time.
+ */
+template<class SourceT, class... Stages>
+class StaticPipeline
+{
+public:
+    static constexpr size_t stageCount = sizeof...(Stages);
+    static_assert(stageCount > 0 && stageCount <= 32, "StaticPipeline supports 1 to 32 stages");
+    static_assert(!(Stages::isForwarding || ...), "Stages must not forward buffers to next() themselves");
+
+    template<class... Args>
+    explicit StaticPipeline(Args&&... sourceArgs) :
+        m_source(std::forward<Args>(sourceArgs)...),
+        m_entry(*this)
+    {
+        static_assert(canIntersect<SourceT, Stages...>(), "Caps of adjacent nodes do not intersect");
+
+        // Let source reserve space for all stages
+        size_t headroom = 0;
+        float tailroom = 0.0f;
+        float factor = 1.0f;
+        forEachStage([&](Node& node) {
+            headroom = std::max(headroom, node.headroom());
+            if (node.tailroom() > 0.0f) {
+                factor *= node.tailroom();
+                tailroom += factor;
+            }
+        });
+        m_entry.setHeadroom(headroom);
+        m_entry.setTailroom(tailroom);
+
+        static_cast<Node&>(m_source).setNext(&m_entry);
+    }
+
+    SourceT& source() {
+        return m_source;
+    }
+
+    /// Return stage at given index (source not included)
+    template<size_t I>
+    auto& stage() {
+        return std::get<I>(m_stages);
+    }
+
+    bool isBypassed(size_t index) const {
+        return m_bypassMask.load(std::memory_order_relaxed) & (1u << index);
+    }
+
+    void setIsBypassed(size_t index, bool bypass) {
+        if (bypass) {
+            m_bypassMask.fetch_or(1u << index, std::memory_order_relaxed);
+        } else {
+            m_bypassMask.fetch_and(~(1u << index), std::memory_order_relaxed);
+        }
+    }
+
+    /// Enable block mode for all stages (see Node::setBlockSize())
+    void setBlockSize(uint32_t frames) {
+        m_entry.setBlockSize(frames);
+    }
+
+    uint32_t blockSize() const {
+        return m_entry.blockSize();
+    }
+
+    /// Process buffer through all stages (without source)
+    void process(core::BufferPtr& buffer) {
+        // Load bypass state once per buffer
+        processStage<0>(buffer, m_bypassMask.load(std::memory_order_relaxed));
+        if (buffer) {
+            buffer->clear();
+        }
+    }
+
+private:
+    template<class Node1, class Node2, class... Nodes>
+    static constexpr bool canIntersect() {
+        if constexpr (sizeof...(Nodes) > 0) {
+            return Cap::canIntersect(Node1::caps(), Node2::caps()) && canIntersect<Node2, Nodes...>();
+        } else {
+            return Cap::canIntersect(Node1::caps(), Node2::caps());
+        }
+    }
+
+    template<class Func>
+    void forEachStage(Func&& func) {
+        std::apply([&](auto&... stages) { (func(static_cast<Node&>(stages)), ...); }, m_stages);
+    }
+
+    template<size_t I>
+    void processStage(core::BufferPtr& buffer, uint32_t bypassMask) {
+        if constexpr (I < stageCount) {
+            // Stop if buffer got consumed or invalid
+            if (!buffer || buffer->audioConf().codec == audio::AudioCodec::Invalid || !buffer->size()) {
+                return;
+            }
+            if (!(bypassMask & (1u << I))) {
+                auto& node = static_cast<Node&>(std::get<I>(m_stages));
+#ifdef CORO_NODE_STATS
+                if (node.isStatsEnabled()) {
+                    const auto inConf = buffer->audioConf();
+                    const auto inBytes = buffer->size();
+                    const auto start = NodeStats::Clock::now();
+                    node.onProcess(buffer);
+                    const auto duration = NodeStats::Clock::now() - start;
+                    node.m_stats.add(inConf, inBytes, buffer ? buffer->audioConf() : inConf, buffer ? buffer->size() : 0, duration);
+                } else
+#endif
+                node.onProcess(buffer);
+            }
+            processStage<I+1>(buffer, bypassMask);
+        }
+    }
+
+    void stop() {
+        const auto bypassMask = m_bypassMask.load(std::memory_order_relaxed);
+        size_t i = 0;
+        forEachStage([&](Node& node) {
+            if (!(bypassMask & (1u << i++))) {
+                node.onStop();
+            }
+        });
+    }
+
+    // Connects source to stages
+    class Entry : public Node {
+    public:
+        Entry(StaticPipeline& pipeline) : m_pipeline(pipeline) {}
+
+    private:
+        const char* name() const override {
+            return "StaticPipeline";
+        }
+
+        void onStop() override {
+            m_pipeline.stop();
+        }
+
+        void onProcess(core::BufferPtr& buffer) override {
+            m_pipeline.process(buffer);
+        }
+
+        StaticPipeline& m_pipeline;
+
+        friend class StaticPipeline;
+    };
+
+    SourceT m_source;
+    std::tuple<Stages...> m_stages;
+    Entry   m_entry;
+    std::atomic<uint32_t> m_bypassMask = 0;
+};
+
+} // namespace core
+} // namespace coro
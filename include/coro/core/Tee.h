@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <coro/core/Caps.h>
+#include <coro/core/Node.h>
+
+#include <vector>
+
+namespace coro {
+namespace core {
+
+/**
+ * Tee forwards buffers to multiple downstream branches.
+ *
+ * Each call to Node::link(tee, node) adds another branch. Branches get a
+ * shared, read-only view (slice) of the incoming buffer, which is only copied
+ * if a branch writes to it. Branches are processed one after another. To run
+ * a branch on its own worker thread, link a Queue as first node of it.
+ */
+class Tee : public Node
+{
+public:
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{ { AnyCap {} }, // in
+                   { AnyCap {} }  // out
+               }}};
+    }
+
+    static constexpr bool isForwarding = true;
+
+    Tee();
+    ~Tee();
+
+    /// Return first nodes of linked branches
+    const std::vector<Node*>& branches() const;
+
+private:
+    const char* name() const override;
+    void setNext(Node* next) override;
+    void onStop() override;
+    void onProcess(core::BufferPtr& buffer) override;
+
+    std::vector<Node*> m_branches;
+};
+
+} // namespace core
+} // namespace coro
@@ -36,7 +36,8 @@ enum class CapFlag : uint8_t
 {
     Invalid         = 0x00,
     RtpPayloaded    = 0x01,
-    Encrypted       = 0x02
+    Encrypted       = 0x02,
+    Planar          = 0x04      // Raw audio in channel planes instead of interleaved frames
 };
 using CapFlags = core::Flags<CapFlag>;
 DECLARE_OPERATORS_FOR_FLAGS(CapFlags)
@@ -39,7 +39,7 @@ public:
     // @TODO(mawe): think about struct vs multiple parameters...
     struct Config {
         uint16_t port = 0;
-        uint8_t prePadding = 0;
+        uint8_t prePadding = 0; // payload offset from an aligned address (e.g. to align payload after stripping a header)
         uint16_t mtu = 1492;
         uint32_t multicastGroup = 0;
     };
@@ -68,7 +68,7 @@ private:
     boost::asio::steady_timer  m_timeout;
     int           m_bufferCount = 0;
     bool          m_isReceiving = false;
-    core::Buffer  m_buffer;
+    core::BufferPtr m_buffer;
     float         m_previousBytesTransferred = 0.0f;
 };
 
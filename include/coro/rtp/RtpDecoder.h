@@ -43,7 +43,7 @@ public:
 private:
     const char* name() const override;
 
-    audio::AudioConf onProcess(const audio::AudioConf& conf, core::Buffer& buffer) override;
+    void onProcess(core::BufferPtr& buffer) override;
     void onStop() override;
     audio::AudioConf onProcessCodec(const RtpHeader& header, core::Buffer& buffer);
 
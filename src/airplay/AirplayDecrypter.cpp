@@ -66,7 +66,9 @@ const char* AirplayDecrypter::name() const
 
 audio::AudioConf AirplayDecrypter::onProcess(const audio::AudioConf&, core::Buffer& buffer)
 {
-    decrypt(buffer.data(), buffer.acquire(buffer.size(), this), buffer.size());
+    // Acquire first, since it might move the payload.
+    auto out = buffer.acquire(buffer.size(), this);
+    decrypt(buffer.constData(), out, buffer.size());
     buffer.commit(buffer.size());
 
     return { audio::AudioCodec::Alac, audio::SampleRate::Rate44100, audio::Channels::Stereo };
@@ -17,24 +17,93 @@
 
 #include "audio/AlsaSink.h"
 
+#include "audio/AudioConverter.h"
+#include "audio/Interleaver.h"
 #include "audio/SpdifTypes.h"
+#include "core/RingBuffer.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include <vector>
 #include <alsa/asoundlib.h>
 #include <loguru/loguru.hpp>
 
 namespace coro {
 namespace audio {
 
+// Device frames are interleaved stereo S16
+static constexpr uint32_t deviceChannelCount = 2;
+static constexpr uint32_t deviceFrameSize = deviceChannelCount * sizeof(int16_t);
+
+class AlsaSinkThread
+{
+public:
+    // Max number of queued buffers
+    static constexpr size_t depth = 32;
+
+    AlsaSinkThread(uint32_t periodFrames) :
+        ring(depth),
+        period(periodFrames * deviceFrameSize) {
+    }
+
+    core::RingBuffer<core::BufferPtr> ring;
+    // Partly rendered buffer
+    core::BufferPtr current;
+    // Period to be written in read/write mode
+    std::vector<char> period;
+
+    std::thread thread;
+    std::atomic_bool isRunning = false;
+    std::atomic_size_t droppedCount = 0;
+    // Last period was fully rendered
+    bool isPlaying = false;
+};
+
 static void doAc3Payload(core::Buffer& buffer);
 
+// Requested period, buffer and start threshold. Zero sizes get derived by snd_pcm_set_params2().
+static AlsaSink::Latency requestedLatency(AlsaSink::LatencyProfile profile, const AlsaSink::Latency& custom)
+{
+    AlsaSink::Latency latency;
+    switch (profile) {
+    case AlsaSink::LatencyProfile::UltraLow:
+        latency.periodFrames = 64;
+        latency.bufferFrames = 4 * 64;
+        latency.startFrames = 2 * 64;
+        break;
+    case AlsaSink::LatencyProfile::Low:
+        latency.periodFrames = 128;
+        latency.bufferFrames = 4 * 128;
+        latency.startFrames = 2 * 128;
+        break;
+    case AlsaSink::LatencyProfile::Balanced:
+        latency.periodFrames = 256;
+        latency.bufferFrames = 8 * 256;
+        latency.startFrames = 4 * 256;
+        break;
+    case AlsaSink::LatencyProfile::Robust:
+        latency.periodFrames = 256;
+        break;
+    case AlsaSink::LatencyProfile::Custom:
+        latency = custom;
+        latency.periodFrames = latency.periodFrames ? latency.periodFrames : 256;
+        break;
+    }
+    return latency;
+}
+
 int snd_pcm_set_params2(snd_pcm_t *pcm,
                         snd_pcm_format_t format,
                         snd_pcm_access_t access,
                         unsigned int channels,
                         unsigned int rate,
-                        snd_pcm_uframes_t period_size = 256) {
+                        snd_pcm_uframes_t period_size = 256,
+                        snd_pcm_uframes_t buffer_size = 0,
+                        snd_pcm_uframes_t delay_size = 0) {
     snd_pcm_hw_params_t   *params;
     snd_pcm_hw_params_alloca(&params);
     //snd_pcm_hw_params_t params = {0};
@@ -43,8 +112,6 @@ int snd_pcm_set_params2(snd_pcm_t *pcm,
     //snd_pcm_sw_params_t swparams = {0};
     const char *s = snd_pcm_stream_name(snd_pcm_stream(pcm));
     int err;
-    snd_pcm_uframes_t delay_size = rate / 10;
-    snd_pcm_uframes_t buffer_size = rate / 2;
 
     assert(pcm);
     {
@@ -90,8 +157,8 @@ int snd_pcm_set_params2(snd_pcm_t *pcm,
             return err;
         }
 
-        // set the buffer size
-        buffer_size = std::max(period_size * 16, buffer_size);
+        // set the buffer size (default: 16 periods, at least 500 ms)
+        buffer_size = buffer_size ? std::max(period_size * 2, buffer_size) : std::max<snd_pcm_uframes_t>(period_size * 16, rate / 2);
         err = snd_pcm_hw_params_set_buffer_size_near(pcm, params, &buffer_size);
         if (err < 0) {
             SNDERR("Unable to set buffer size %lu %s: %s", buffer_size, s, snd_strerror(err));
@@ -113,8 +180,9 @@ int snd_pcm_set_params2(snd_pcm_t *pcm,
         return err;
     }
 
-    // start the transfer when the buffer with delay.
-    delay_size = std::max(period_size * 4, delay_size);
+    // start the transfer when the buffer with delay (default: 4 periods, at least 100 ms).
+    delay_size = delay_size ? delay_size : std::max<snd_pcm_uframes_t>(period_size * 4, rate / 10);
+    delay_size = std::min(delay_size, buffer_size);
     err = snd_pcm_sw_params_set_start_threshold(pcm, swparams, delay_size);
     if (err < 0) {
         SNDERR("Unable to set start threshold mode for %s: %s", s, snd_strerror(err));
@@ -140,10 +208,13 @@ int snd_pcm_set_params2(snd_pcm_t *pcm,
 
 AlsaSink::AlsaSink()
 {
+    // Encoded audio gets payloaded with a SPDIF header.
+    setHeadroom(spdif::SpdifAc3Header::size());
 }
 
 AlsaSink::~AlsaSink()
 {
+    stopThread();
 }
 
 void AlsaSink::start(const AudioConf& conf)
@@ -176,11 +247,33 @@ void AlsaSink::start(const AudioConf& conf)
     if (err < 0) {
         LOG_F(WARNING, "snd_pcm_hw_params_get_buffer_time() failed.\n");
     }
-    LOG_F(INFO, "Device opened. delay: %u ms, buffer: %u ms",
-          (uint)frames * 1000 / toInt(conf.rate),
-          (uint)buffer_size * 1000 / toInt(conf.rate));
+    snd_pcm_uframes_t period_size = min;
+    err = snd_pcm_hw_params_get_period_size(hwparams, &period_size, NULL);
+    if (err < 0) {
+        LOG_F(WARNING, "snd_pcm_hw_params_get_period_size() failed.\n");
+    }
+    m_latency.bufferFrames = buffer_size;
+    m_latency.startFrames = frames;
+    m_latency.periodFrames = period_size;
+    const uint64_t rate = toInt(conf.rate);
+    m_latency.latencyUs = frames * 1000000 / rate;
+    m_latency.maxLatencyUs = buffer_size * 1000000 / rate;
+    LOG_F(INFO, "Device opened. period: %u frames, buffer: %u frames, start: %u frames, latency: %.1f ms (max %.1f ms), mmap: %d",
+          m_latency.periodFrames, m_latency.bufferFrames, m_latency.startFrames,
+          m_latency.latencyUs / 1000.0, m_latency.maxLatencyUs / 1000.0,
+          m_isMmap);
+
+    // Output thread keeps the device filled up to the start threshold only. So,
+    // it is woken up once there is room for another period below it.
+    if (m_isThreaded) {
+        min = std::min<snd_pcm_uframes_t>(buffer_size - std::min(frames, buffer_size) + period_size, buffer_size);
+        if (snd_pcm_sw_params_set_avail_min(m_pcm, params, min) < 0 || snd_pcm_sw_params(m_pcm, params) < 0) {
+            LOG_F(WARNING, "Unable to set avail min for output thread");
+        }
+    }
 
     snd_pcm_prepare(m_pcm);
+    startThread();
 }
 
 void AlsaSink::setDevice(const std::string& device)
@@ -194,13 +287,75 @@ void AlsaSink::setDevice(const std::string& device)
     start(m_conf);
 }
 
+void AlsaSink::setMmap(bool enable)
+{
+    m_isMmapRequested = enable;
+}
+
+bool AlsaSink::isMmap() const
+{
+    return m_isMmap;
+}
+
+void AlsaSink::setOutputThread(bool enable, int priority, int cpu)
+{
+    m_isThreaded = enable;
+    m_priority = priority;
+    m_cpu = cpu;
+}
+
+size_t AlsaSink::underrunCount() const
+{
+    return m_underrunCount;
+}
+
+void AlsaSink::setLatencyProfile(LatencyProfile profile)
+{
+    if (profile == m_latencyProfile) {
+        return;
+    }
+
+    m_latencyProfile = profile;
+    if (m_pcm) {
+        onStop();
+        start(m_conf);
+    }
+}
+
+AlsaSink::LatencyProfile AlsaSink::latencyProfile() const
+{
+    return m_latencyProfile;
+}
+
+void AlsaSink::setLatency(uint32_t periodFrames, uint32_t bufferFrames, uint32_t startFrames)
+{
+    m_customLatency.periodFrames = periodFrames;
+    m_customLatency.bufferFrames = bufferFrames;
+    m_customLatency.startFrames = startFrames;
+    m_latencyProfile = LatencyProfile::Custom;
+    if (m_pcm) {
+        onStop();
+        start(m_conf);
+    }
+}
+
+AlsaSink::Latency AlsaSink::latency() const
+{
+    return m_latency;
+}
+
 const char* AlsaSink::name() const
 {
     return "AlsaSink";
 }
 
-AudioConf AlsaSink::onProcess(const AudioConf& conf, core::Buffer& buffer)
+void AlsaSink::onProcess(core::BufferPtr& buffer)
 {
+    // Device takes interleaved frames only
+    interleave(*buffer, this);
+
+    const auto& conf = buffer->audioConf();
+
     if (m_conf != conf) {
         onStop();
         start(conf);
@@ -212,7 +367,32 @@ AudioConf AlsaSink::onProcess(const AudioConf& conf, core::Buffer& buffer)
     }
 
     if (conf.codec == AudioCodec::Ac3) {
-        doAc3Payload(buffer);
+        doAc3Payload(*buffer);
+    }
+
+    // Output thread takes ownership of buffer. Upstream gets a pooled one.
+    // If ring is full, oldest buffer is dropped, so this never blocks.
+    if (m_thread) {
+        if (!m_thread->ring.push(buffer)) {
+            core::BufferPtr oldest;
+            if (m_thread->ring.pop(oldest)) {
+                ++m_thread->droppedCount;
+                LOG_F(2, "%s overflow. dropped buffers: %zu", name(), m_thread->droppedCount.load());
+            }
+            m_thread->ring.push(buffer);
+        }
+        if (buffer) {
+            buffer->clear();
+        }
+        return;
+    }
+
+    // In mmap mode, float is converted straight into the ring buffer.
+    if (conf.codec == AudioCodec::RawFloat32 && !m_isMmap) {
+        const auto count = buffer->size()/sizeof(float);
+        convert(buffer->data(), AudioCodec::RawFloat32, buffer->data(), AudioCodec::RawInt16, count);
+        buffer->shrink(count*sizeof(int16_t));
+        buffer->audioConf().codec = AudioCodec::RawInt16;
     }
 
     /*
@@ -227,11 +407,9 @@ AudioConf AlsaSink::onProcess(const AudioConf& conf, core::Buffer& buffer)
     //snd_pcm_delay(m_pcm, &delay);
     //LOG_F(1, "Device delay: %zu ms", delay * 1000 / toInt(m_conf.rate));
 
-    writeSimple(buffer.data(), buffer.size());
+    writeSegments(*buffer);
 
-    buffer.clear();
-
-    return conf;
+    buffer->clear();
 }
 
 void AlsaSink::onStart()
@@ -240,6 +418,8 @@ void AlsaSink::onStart()
 
 void AlsaSink::onStop()
 {
+    // Output thread must not touch the device anymore
+    stopThread();
     if (m_pcm) {
         snd_pcm_drain(m_pcm);
         snd_pcm_close(m_pcm);
@@ -262,11 +442,33 @@ bool AlsaSink::openSimple(const AudioConf& conf)
     }
 
     unsigned int rate = toInt(conf.rate);
-    err = snd_pcm_set_params2(m_pcm,
-                              SND_PCM_FORMAT_S16,
-                              SND_PCM_ACCESS_RW_INTERLEAVED,
-                              2,
-                              rate);
+    // Zero sizes are derived from period and rate
+    const Latency requested = requestedLatency(m_latencyProfile, m_customLatency);
+    m_isMmap = m_isMmapRequested;
+    if (m_isMmap) {
+        err = snd_pcm_set_params2(m_pcm,
+                                  SND_PCM_FORMAT_S16,
+                                  SND_PCM_ACCESS_MMAP_INTERLEAVED,
+                                  2,
+                                  rate,
+                                  requested.periodFrames,
+                                  requested.bufferFrames,
+                                  requested.startFrames);
+        if (err) {
+            LOG_F(WARNING, "mmap access not available for '%s', falling back to read/write", m_device.c_str());
+            m_isMmap = false;
+        }
+    }
+    if (!m_isMmap) {
+        err = snd_pcm_set_params2(m_pcm,
+                                  SND_PCM_FORMAT_S16,
+                                  SND_PCM_ACCESS_RW_INTERLEAVED,
+                                  2,
+                                  rate,
+                                  requested.periodFrames,
+                                  requested.bufferFrames,
+                                  requested.startFrames);
+    }
     if (err) {
         LOG_F(WARNING, "snd_pcm_set_params2() failed.");
         return false;
@@ -306,6 +508,323 @@ void AlsaSink::writeSimple(const char* samples, uint32_t bytesCount)
     }
 }
 
+void AlsaSink::writeMmap(const char* samples, AudioCodec codec, uint32_t frameCount)
+{
+    const auto inFrameSize = deviceChannelCount * size(codec);
+
+    while (frameCount > 0) {
+        auto avail = snd_pcm_avail_update(m_pcm);
+        if (avail < 0) {
+            LOG_F(WARNING, "Avail update failed: %s", snd_strerror(avail));
+            if ((avail = snd_pcm_recover(m_pcm, avail, 0)) < 0) {
+                LOG_F(WARNING, "Recovery failed: %s", snd_strerror(avail));
+                return;
+            }
+            continue;
+        }
+        // Ring buffer is full, wait for the device to consume a period
+        if (avail == 0) {
+            if (snd_pcm_state(m_pcm) == SND_PCM_STATE_PREPARED) {
+                snd_pcm_start(m_pcm);
+            }
+            snd_pcm_wait(m_pcm, 1000);
+            continue;
+        }
+
+        const snd_pcm_channel_area_t* areas;
+        snd_pcm_uframes_t offset = 0;
+        snd_pcm_uframes_t frames = std::min<snd_pcm_uframes_t>(frameCount, avail);
+        auto err = snd_pcm_mmap_begin(m_pcm, &areas, &offset, &frames);
+        if (err < 0) {
+            LOG_F(WARNING, "mmap begin failed: %s", snd_strerror(err));
+            if ((err = snd_pcm_recover(m_pcm, err, 0)) < 0) {
+                LOG_F(WARNING, "Recovery failed: %s", snd_strerror(err));
+                return;
+            }
+            continue;
+        }
+
+        // Interleaved: all channels share the first area, frames are step bits apart.
+        char* dst = static_cast<char*>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8;
+        convert(samples, codec, dst, AudioCodec::RawInt16, frames * deviceChannelCount);
+
+        const auto committed = snd_pcm_mmap_commit(m_pcm, offset, frames);
+        if (committed < 0 || (snd_pcm_uframes_t)committed != frames) {
+            LOG_F(WARNING, "mmap commit failed: %s", snd_strerror(committed < 0 ? committed : -EPIPE));
+            if (snd_pcm_recover(m_pcm, committed < 0 ? committed : -EPIPE, 0) < 0) {
+                return;
+            }
+        }
+
+        startIfFilled();
+
+        samples += frames * inFrameSize;
+        frameCount -= frames;
+    }
+}
+
+void AlsaSink::startIfFilled()
+{
+    // Unlike snd_pcm_writei(), mmap access does not start the device by itself.
+    if (snd_pcm_state(m_pcm) != SND_PCM_STATE_PREPARED) {
+        return;
+    }
+    const auto avail = snd_pcm_avail_update(m_pcm);
+    if (avail >= 0 && m_latency.bufferFrames - std::min<uint32_t>(avail, m_latency.bufferFrames) >= m_latency.startFrames) {
+        snd_pcm_start(m_pcm);
+    }
+}
+
+void AlsaSink::writeSegments(const core::Buffer& buffer)
+{
+    // Segments are written one by one, so headers and padding are never copied
+    // next to the payload. Segments might not end at a frame boundary, so the
+    // bytes of a split frame are gathered in between.
+    const auto codec = isRaw(buffer.audioConf().codec) ? buffer.audioConf().codec : AudioCodec::RawInt16;
+    const size_t frameSize = deviceChannelCount * size(codec);
+    char frame[2 * sizeof(float)];
+    size_t frameBytes = 0;
+
+    auto write = [&](const char* data, size_t bytes) {
+        if (m_isMmap) {
+            writeMmap(data, codec, bytes / frameSize);
+        } else {
+            writeSimple(data, bytes);
+        }
+    };
+
+    struct iovec segments[8];
+    const auto count = buffer.segments(segments, 8);
+    if (count < buffer.segmentCount()) {
+        LOG_F(WARNING, "Too many segments: %zu", buffer.segmentCount());
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        auto data = static_cast<const char*>(segments[i].iov_base);
+        auto size = segments[i].iov_len;
+
+        if (frameBytes) {
+            const auto n = std::min(frameSize - frameBytes, size);
+            std::memcpy(frame + frameBytes, data, n);
+            frameBytes += n;
+            data += n;
+            size -= n;
+            if (frameBytes < frameSize) {
+                continue;
+            }
+            write(frame, frameSize);
+            frameBytes = 0;
+        }
+
+        const auto alignedSize = size - size % frameSize;
+        write(data, alignedSize);
+        frameBytes = size - alignedSize;
+        std::memcpy(frame, data + alignedSize, frameBytes);
+    }
+}
+
+void AlsaSink::startThread()
+{
+    if (!m_isThreaded || !m_pcm || m_thread || !m_latency.periodFrames) {
+        return;
+    }
+
+    m_thread = new AlsaSinkThread(m_latency.periodFrames);
+    m_thread->isRunning = true;
+    m_thread->thread = std::thread(&AlsaSink::runThread, this);
+}
+
+void AlsaSink::stopThread()
+{
+    if (!m_thread) {
+        return;
+    }
+
+    m_thread->isRunning = false;
+    if (m_thread->thread.joinable()) {
+        m_thread->thread.join();
+    }
+    LOG_F(INFO, "Output thread stopped. underruns: %zu, dropped buffers: %zu",
+          m_underrunCount.load(), m_thread->droppedCount.load());
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+void AlsaSink::runThread()
+{
+    if (m_priority > 0) {
+        sched_param param {};
+        param.sched_priority = m_priority;
+        const int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        LOG_IF_F(WARNING, err, "Unable to set SCHED_FIFO priority %d: %s", m_priority, strerror(err));
+    }
+    if (m_cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(m_cpu, &cpus);
+        const int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        LOG_IF_F(WARNING, err, "Unable to pin output thread to CPU %d: %s", m_cpu, strerror(err));
+    }
+
+    std::vector<struct pollfd> fds(std::max(snd_pcm_poll_descriptors_count(m_pcm), 0));
+    snd_pcm_poll_descriptors(m_pcm, fds.data(), fds.size());
+
+    snd_pcm_sw_params_t* params;
+    snd_pcm_sw_params_alloca(&params);
+    snd_pcm_uframes_t availMin = m_latency.periodFrames;
+    if (snd_pcm_sw_params_current(m_pcm, params) == 0) {
+        snd_pcm_sw_params_get_avail_min(params, &availMin);
+    }
+
+    while (m_thread->isRunning) {
+        const auto avail = snd_pcm_avail_update(m_pcm);
+        if (avail < 0) {
+            LOG_F(WARNING, "Output thread xrun: %s", snd_strerror(avail));
+            ++m_underrunCount;
+            const int err = snd_pcm_recover(m_pcm, avail, 1);
+            if (err < 0) {
+                LOG_F(ERROR, "Recovery failed: %s", snd_strerror(err));
+                break;
+            }
+            continue;
+        }
+
+        if ((snd_pcm_uframes_t)avail >= availMin) {
+            writePeriod();
+            continue;
+        }
+
+        // Device below start threshold would never ask for more
+        if (snd_pcm_state(m_pcm) == SND_PCM_STATE_PREPARED) {
+            snd_pcm_start(m_pcm);
+        }
+        // Timeout only bounds latency of stopping
+        if (poll(fds.data(), fds.size(), 100) > 0) {
+            unsigned short revents = 0;
+            snd_pcm_poll_descriptors_revents(m_pcm, fds.data(), fds.size(), &revents);
+            LOG_IF_F(WARNING, revents & POLLERR, "Output thread poll error");
+        }
+    }
+}
+
+void AlsaSink::writePeriod()
+{
+    const uint32_t frameCount = m_latency.periodFrames;
+    uint32_t rendered = 0;
+    if (!m_isMmap) {
+        rendered = render(m_thread->period.data(), frameCount);
+        writeSimple(m_thread->period.data(), frameCount * deviceFrameSize);
+    } else {
+        // Render straight into the ring buffer of the device. A period might
+        // wrap around its end, so it is mapped in up to two chunks.
+        uint32_t written = 0;
+        while (written < frameCount) {
+            const snd_pcm_channel_area_t* areas;
+            snd_pcm_uframes_t offset = 0;
+            snd_pcm_uframes_t frames = frameCount - written;
+            auto err = snd_pcm_mmap_begin(m_pcm, &areas, &offset, &frames);
+            if (err < 0) {
+                LOG_F(WARNING, "mmap begin failed: %s", snd_strerror(err));
+                snd_pcm_recover(m_pcm, err, 1);
+                return;
+            }
+            if (!frames) {
+                return;
+            }
+            char* dst = static_cast<char*>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8;
+            rendered += render(dst, frames);
+            const auto committed = snd_pcm_mmap_commit(m_pcm, offset, frames);
+            if (committed < 0 || (snd_pcm_uframes_t)committed != frames) {
+                LOG_F(WARNING, "mmap commit failed: %s", snd_strerror(committed < 0 ? committed : -EPIPE));
+                snd_pcm_recover(m_pcm, committed < 0 ? committed : -EPIPE, 1);
+                return;
+            }
+            written += frames;
+        }
+        startIfFilled();
+    }
+
+    // Count each gap in the stream once, not every silent period of a pause.
+    if (rendered < frameCount && m_thread->isPlaying) {
+        ++m_underrunCount;
+        LOG_F(1, "Output thread underrun: %u of %u frames", rendered, frameCount);
+    }
+    m_thread->isPlaying = rendered == frameCount;
+}
+
+uint32_t AlsaSink::render(char* dst, uint32_t frameCount)
+{
+    auto& current = m_thread->current;
+    uint32_t rendered = 0;
+    while (rendered < frameCount) {
+        if (!current && !m_thread->ring.pop(current)) {
+            break;
+        }
+
+        // SPDIF payloaded frames are S16 stereo as well
+        const auto& conf = current->audioConf();
+        const auto codec = isRaw(conf.codec) ? conf.codec : AudioCodec::RawInt16;
+        const size_t frameSize = deviceChannelCount * size(codec);
+
+        // Segments (e.g. SPDIF header, payload and padding) are rendered one
+        // by one, since gathering them would allocate on this thread.
+        struct iovec segments[8];
+        const auto count = current->segments(segments, 8);
+        size_t segmentBytes = 0;
+        for (size_t i = 0; i < count; ++i) {
+            segmentBytes += segments[i].iov_len;
+        }
+        const uint32_t available = segmentBytes / frameSize;
+        const uint32_t n = std::min(frameCount - rendered, available);
+
+        char* out = dst + rendered * deviceFrameSize;
+        auto write = [&](const char* data, size_t frames) {
+            convert(data, codec, out, AudioCodec::RawInt16, frames * deviceChannelCount);
+            out += frames * deviceFrameSize;
+        };
+        char frame[2 * sizeof(float)];
+        size_t frameBytes = 0;
+        size_t bytes = n * frameSize;
+        for (size_t i = 0; i < count && bytes; ++i) {
+            auto data = static_cast<const char*>(segments[i].iov_base);
+            auto size = std::min(segments[i].iov_len, bytes);
+            bytes -= size;
+
+            // Frame split across segments
+            if (frameBytes) {
+                const auto m = std::min(frameSize - frameBytes, size);
+                std::memcpy(frame + frameBytes, data, m);
+                frameBytes += m;
+                data += m;
+                size -= m;
+                if (frameBytes < frameSize) {
+                    continue;
+                }
+                write(frame, 1);
+                frameBytes = 0;
+            }
+
+            const auto alignedSize = size - size % frameSize;
+            write(data, alignedSize / frameSize);
+            frameBytes = size - alignedSize;
+            std::memcpy(frame, data + alignedSize, frameBytes);
+        }
+
+        rendered += n;
+        if (!available || n * frameSize == current->size()) {
+            current.reset();
+        } else {
+            current->trimFront(n * frameSize);
+        }
+    }
+
+    if (rendered < frameCount) {
+        snd_pcm_format_set_silence(SND_PCM_FORMAT_S16, dst + rendered * deviceFrameSize,
+                                   (frameCount - rendered) * deviceChannelCount);
+    }
+    return rendered;
+}
+
 bool AlsaSink::recover(int err)
 {
     // underrun
@@ -348,19 +867,20 @@ void doAc3Payload(core::Buffer& buffer)
         return;
     }
 
-    spdif::SpdifAc3Header ac3Header(buffer.data(), buffer.size());
-    buffer.prepend((char*)&ac3Header, 8);
+    spdif::SpdifAc3Header ac3Header(buffer.constData(), buffer.size());
 
 #if __BYTE_ORDER == __LITTLE_ENDIAN
-    auto ac3Data = buffer.data() + ac3Header.size();
-    const auto size = buffer.size() - ac3Header.size();
+    auto ac3Data = buffer.data();
+    const auto size = buffer.size();
 
     for (uint32_t i = 0; i < size; i += 2) {
         *(uint16_t*)(ac3Data+i) = __bswap_16(*(uint16_t*)(ac3Data+i));
     }
 #endif
 
-    buffer.grow(spdif::ac3FrameSize);
+    // Header and burst padding are attached as segments, payload is not moved.
+    buffer.prepend((char*)&ac3Header, ac3Header.size());
+    buffer.pad(spdif::ac3FrameSize);
 }
 
 } // namespace audio
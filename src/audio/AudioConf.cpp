@@ -13,7 +13,8 @@ bool AudioConf::operator==(const AudioConf& other) const
     return codec == other.codec &&
             rate == other.rate &&
             channels == other.channels &&
-            isRtpPayloaded == other.isRtpPayloaded;
+            isRtpPayloaded == other.isRtpPayloaded &&
+            isPlanar == other.isPlanar;
 }
 
 bool AudioConf::operator!=(const AudioConf& other) const
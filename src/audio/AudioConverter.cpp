@@ -1,7 +1,8 @@
 #include "audio/AudioConverter.h"
 
-#include "loguru/loguru.hpp"
+#include "Simd.h"
 
+#include <algorithm>
 #include <cstring>
 
 namespace coro {
@@ -9,91 +10,176 @@ namespace audio {
 
 template class AudioConverter<int16_t, float>;
 template class AudioConverter<float, int16_t>;
-
-template<class InT, class OutT>
-AudioConverter<InT,OutT>::AudioConverter()
+template class AudioConverter<int16_t, int32_t>;
+template class AudioConverter<int32_t, int16_t>;
+template class AudioConverter<int32_t, float>;
+template class AudioConverter<float, int32_t>;
+template class AudioConverter<int16_t, Int24>;
+template class AudioConverter<Int24, int16_t>;
+template class AudioConverter<int32_t, Int24>;
+template class AudioConverter<Int24, int32_t>;
+template class AudioConverter<float, Int24>;
+template class AudioConverter<Int24, float>;
+template class AudioConverter<int16_t, Int24Packed>;
+template class AudioConverter<Int24Packed, int16_t>;
+template class AudioConverter<int32_t, Int24Packed>;
+template class AudioConverter<Int24Packed, int32_t>;
+template class AudioConverter<float, Int24Packed>;
+template class AudioConverter<Int24Packed, float>;
+template class AudioConverter<Int24, Int24Packed>;
+template class AudioConverter<Int24Packed, Int24>;
+
+namespace {
+
+// Samples per block of conversions running through int32_t
+constexpr size_t blockSize = 256;
+
+// Raw samples -> int32_t (Q31)
+void toInt32(const char* in, AudioCodec codec, int32_t* out, size_t count)
 {
+    switch (codec) {
+    case AudioCodec::RawInt16:
+        simd::int16ToInt32(out, (const int16_t*)in, count);
+        break;
+    case AudioCodec::RawInt24:
+        simd::int24ToInt32(out, (const int32_t*)in, count);
+        break;
+    case AudioCodec::RawInt24Packed: {
+        auto bytes = (const uint8_t*)in;
+        for (size_t i = 0; i < count; ++i, bytes += 3) {
+            out[i] = int32_t(uint32_t(bytes[0]) << 8 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 24);
+        }
+        break;
+    }
+    case AudioCodec::RawInt32:
+        std::memcpy(out, in, count*sizeof(int32_t));
+        break;
+    case AudioCodec::RawFloat32:
+        simd::floatToInt32(out, (const float*)in, count);
+        break;
+    default:
+        break;
+    }
 }
 
-template<class InT, class OutT>
-AudioConverter<InT,OutT>::~AudioConverter()
+// int32_t (Q31) -> raw samples. in is used as scratch.
+void fromInt32(int32_t* in, char* out, AudioCodec codec, size_t count)
 {
+    switch (codec) {
+    case AudioCodec::RawInt16:
+        simd::int32ToInt16((int16_t*)out, in, count);
+        break;
+    case AudioCodec::RawInt24:
+        simd::int32ToInt24((int32_t*)out, in, count);
+        break;
+    case AudioCodec::RawInt24Packed: {
+        simd::int32ToInt24(in, in, count);
+        auto bytes = (uint8_t*)out;
+        for (size_t i = 0; i < count; ++i, bytes += 3) {
+            bytes[0] = uint8_t(in[i]);
+            bytes[1] = uint8_t(in[i] >> 8);
+            bytes[2] = uint8_t(in[i] >> 16);
+        }
+        break;
+    }
+    case AudioCodec::RawInt32:
+        std::memcpy(out, in, count*sizeof(int32_t));
+        break;
+    case AudioCodec::RawFloat32:
+        simd::int32ToFloat((float*)out, in, count);
+        break;
+    default:
+        break;
+    }
 }
 
-template<class InT, class OutT>
-const char* AudioConverter<InT,OutT>::name() const
-{
-    return "AudioConverter";
-}
+} // namespace
 
-template<>
-AudioConf AudioConverter<int16_t,float>::onProcess(const AudioConf& conf, core::Buffer& buffer)
+bool convert(const char* in, AudioCodec inCodec, char* out, AudioCodec outCodec, size_t count)
 {
-    char* to = buffer.acquire(buffer.size()*2);
-    char* from = buffer.data();
-
-    // @TODO(mawe): remove memcpy, since memory alignment is now done in AudioBuffer.
-    for (size_t i = 0; i < buffer.size()/size(conf.codec); ++i) {
-        int16_t tmp;
-        std::memcpy(&tmp, from+(i*2), 2);
-        float f = tmp/32767.0;
-        std::memcpy(to+(i*4), &f, 4);
+    if (!isRaw(inCodec) || !isRaw(outCodec)) {
+        return false;
     }
 
-    buffer.commit(buffer.size()*2);
+    if (inCodec == outCodec) {
+        if (in != out) {
+            std::memmove(out, in, count*size(inCodec));
+        }
+        return true;
+    }
 
-    auto _conf = conf;
-    _conf.codec = AudioCodec::RawFloat32;
-    return _conf;
+    // Common conversions run directly
+    if (inCodec == AudioCodec::RawInt16 && outCodec == AudioCodec::RawFloat32) {
+        simd::int16ToFloat((float*)out, (const int16_t*)in, count);
+    } else if (inCodec == AudioCodec::RawFloat32 && outCodec == AudioCodec::RawInt16) {
+        simd::floatToInt16((int16_t*)out, (const float*)in, count);
+    } else if (inCodec == AudioCodec::RawInt32 && outCodec == AudioCodec::RawFloat32) {
+        simd::int32ToFloat((float*)out, (const int32_t*)in, count);
+    } else if (inCodec == AudioCodec::RawFloat32 && outCodec == AudioCodec::RawInt32) {
+        simd::floatToInt32((int32_t*)out, (const float*)in, count);
+    } else if (inCodec == AudioCodec::RawInt16 && outCodec == AudioCodec::RawInt32) {
+        simd::int16ToInt32((int32_t*)out, (const int16_t*)in, count);
+    } else if (inCodec == AudioCodec::RawInt32 && outCodec == AudioCodec::RawInt16) {
+        simd::int32ToInt16((int16_t*)out, (const int32_t*)in, count);
+    } else {
+        // Others run through int32_t (lossless), blockwise. Each block is read
+        // before it is written, so this works in place as well.
+        int32_t block[blockSize];
+        const size_t inSize = size(inCodec);
+        const size_t outSize = size(outCodec);
+        for (size_t i = 0; i < count; i += blockSize) {
+            const size_t n = std::min(blockSize, count - i);
+            toInt32(in + i*inSize, inCodec, block, n);
+            fromInt32(block, out + i*outSize, outCodec, n);
+        }
+    }
+
+    return true;
 }
 
-template<>
-AudioConf AudioConverter<float,int16_t>::onProcess(const AudioConf& conf, core::Buffer& buffer)
+template<class InT, class OutT>
+AudioConverter<InT,OutT>::AudioConverter()
 {
-    char* to = buffer.acquire(buffer.size()/2);
-    char* from = buffer.data();
-
-    // @TODO(mawe): remove memcpy, since memory alignment is now done in AudioBuffer.
-    for (size_t i = 0; i < buffer.size()/size(conf.codec); ++i) {
-        float f;
-        std::memcpy(&f, from+(i*4), 4);
-        int16_t temp;
-
-        if (f >= 1.0f) {
-            temp = 32767;
-        } else if (f < -1.0f) {
-            temp = -32768;
-        } else {
-            temp = (int16_t)(f*32767.0f);
-        }
-
-        std::memcpy(to+(i*2), &temp, 2);
+    // Wider samples are written behind the incoming ones.
+    if (sizeof(OutT) > sizeof(InT)) {
+        setTailroom(float(sizeof(OutT))/sizeof(InT));
     }
+}
 
-    buffer.commit(buffer.size()/2);
-
-    auto _conf = conf;
-    _conf.codec = AudioCodec::RawInt16;
-    return _conf;
+template<class InT, class OutT>
+AudioConverter<InT,OutT>::~AudioConverter()
+{
 }
 
-template <typename T, typename U>
-AudioConf AudioConverter<T,U>::onProcess(const AudioConf& conf, core::Buffer& buffer)
+template<class InT, class OutT>
+const char* AudioConverter<InT,OutT>::name() const
 {
-    U* to = (U*)buffer.acquire(buffer.size()*sizeof(U)/sizeof(T));
-    T* from = (T*)buffer.data();
+    return "AudioConverter";
+}
 
-    for (size_t i = 0; i < buffer.size()/sizeof(T); ++i) {
-        *to = (U)(*from);
-        ++to;
-        ++from;
+template<class InT, class OutT>
+void AudioConverter<InT,OutT>::onProcess(core::BufferPtr& buffer)
+{
+    auto& conf = buffer->audioConf();
+    if (conf.codec != rawCodec<InT>()) {
+        return;
     }
 
-    buffer.commit(buffer.size()*sizeof(U)/sizeof(T));
+    const size_t count = buffer->size()/sizeof(InT);
+    const size_t outSize = count*sizeof(OutT);
+    const bool isInPlace = sizeof(OutT) <= sizeof(InT);
+    char* to = isInPlace ? buffer->data() : buffer->acquire(outSize, this);
+    const char* from = buffer->data();
+
+    convert(from, rawCodec<InT>(), to, rawCodec<OutT>(), count);
 
-    return conf;
+    if (isInPlace) {
+        buffer->shrink(outSize);
+    } else {
+        buffer->commit(outSize);
+    }
+    conf.codec = rawCodec<OutT>();
 }
 
 } // namespace audio
 } // namespace coro
-
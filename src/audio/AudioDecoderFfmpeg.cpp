@@ -119,6 +119,12 @@ void AudioDecoderFfmpeg<codec>::init(const std::string& data)
     m_codecData = data;
 }
 
+template<audio::AudioCodec codec>
+void AudioDecoderFfmpeg<codec>::setPlanar(bool isPlanar)
+{
+    m_isPlanar = isPlanar;
+}
+
 template<audio::AudioCodec codec>
 const char* AudioDecoderFfmpeg<codec>::name() const
 {
@@ -135,7 +141,7 @@ AudioConf AudioDecoderFfmpeg<codec>::onProcess(const AudioConf& conf, core::Buff
 
     //_buffer.grow(AV_INPUT_BUFFER_PADDING_SIZE);
     auto packet = av_packet_alloc();
-    packet->data = reinterpret_cast<uint8_t*>(_buffer.data());
+    packet->data = const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(_buffer.constData()));
     packet->size = _buffer.size();
 
     auto ret = avcodec_send_packet(m_context, packet);
@@ -156,9 +162,17 @@ AudioConf AudioDecoderFfmpeg<codec>::onProcess(const AudioConf& conf, core::Buff
         _conf.channels = Channels::Stereo;
         _conf.rate = toCoro(frame->sample_rate);
 
-        if (frame->format == AV_SAMPLE_FMT_FLTP) {
+        if (frame->format == AV_SAMPLE_FMT_FLTP && m_isPlanar) {
+            copyPlanes<float>(frame, _buffer);
+            _conf.codec = AudioCodec::RawFloat32;
+            _conf.isPlanar = true;
+        } else if (frame->format == AV_SAMPLE_FMT_FLTP) {
             interleave<float>(frame, _buffer);
             _conf.codec = AudioCodec::RawFloat32;
+        } else if (frame->format == AV_SAMPLE_FMT_S16P && m_isPlanar) {
+            copyPlanes<int16_t>(frame, _buffer);
+            _conf.codec = AudioCodec::RawInt16;
+            _conf.isPlanar = true;
         } else if (frame->format == AV_SAMPLE_FMT_S16P) {
             interleave<int16_t>(frame, _buffer);
             _conf.codec = AudioCodec::RawInt16;
@@ -215,5 +229,18 @@ void AudioDecoderFfmpeg<codec>::interleave(const AVFrame* in, core::Buffer& out)
     out.commit(in->linesize[0] * in->channels);
 }
 
+template<audio::AudioCodec codec>
+template<typename T>
+void AudioDecoderFfmpeg<codec>::copyPlanes(const AVFrame* in, core::Buffer& out)
+{
+    // Planes are copied without line padding
+    const size_t planeSize = in->nb_samples * sizeof(T);
+    auto data = out.acquire(planeSize * in->channels, this);
+    for (int c = 0; c < in->channels; ++c) {
+        std::memcpy(data + c * planeSize, in->data[c], planeSize);
+    }
+    out.commit(planeSize * in->channels);
+}
+
 } // namespace audio
 } // namespace coro
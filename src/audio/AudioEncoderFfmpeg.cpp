@@ -76,6 +76,17 @@ void AudioEncoderFfmpeg::onStop()
 
 AudioConf AudioEncoderFfmpeg::onProcess(const AudioConf& conf, core::Buffer& _buffer)
 {
+    // Frames are filled from interleaved samples
+    if (conf.isPlanar) {
+        if (!m_isRejected) {
+            LOG_F(WARNING, "%s does not take planar buffers", name());
+            m_isRejected = true;
+        }
+        _buffer.clear();
+        return conf;
+    }
+    m_isRejected = false;
+
     if (m_conf != conf) {
         m_conf = conf;
         updateConf();
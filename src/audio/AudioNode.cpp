@@ -15,6 +15,16 @@ AudioNode::~AudioNode()
 
 }
 
+uint32_t AudioNode::revision() const
+{
+    return m_revision.load(std::memory_order_acquire);
+}
+
+void AudioNode::bumpRevision()
+{
+    m_revision.fetch_add(1, std::memory_order_release);
+}
+
 audio::AudioConf AudioNode::onProcess(const audio::AudioConf& conf, core::Buffer&)
 {
     return conf;
@@ -11,7 +11,7 @@ AudioTestSource::AudioTestSource(const AudioConf& audioConf,
     : m_conf(audioConf),
       m_numFramesPerBuffer(numFramesPerBuffer),
       m_numBuffers(numBuffers),
-      m_buffer(numFramesPerBuffer * toInt(m_conf.channels) * size(m_conf.codec))
+      m_buffer(core::Buffer::create(numFramesPerBuffer * toInt(m_conf.channels) * size(m_conf.codec)))
 {
 }
 
@@ -28,7 +28,8 @@ void AudioTestSource::onStart()
 {
     for (uint32_t i = 0; i < m_numBuffers; ++i) {
 
-        pushBuffer(m_conf, m_buffer);
+        m_buffer->audioConf() = m_conf;
+        pushBuffer(m_buffer);
 
     }
 }
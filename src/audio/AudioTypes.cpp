@@ -8,11 +8,20 @@ uint8_t size(AudioCodec codec)
     switch (codec) {
     case AudioCodec::Invalid: return 0;
     case AudioCodec::RawFloat32: return 4;
+    case AudioCodec::RawInt32: return 4;
+    case AudioCodec::RawInt24: return 4;
+    case AudioCodec::RawInt24Packed: return 3;
     default: return 2;
     }
     return 0;
 }
 
+bool isRaw(AudioCodec codec)
+{
+    return codec == AudioCodec::RawInt16 || codec == AudioCodec::RawInt32 || codec == AudioCodec::RawFloat32 ||
+           codec == AudioCodec::RawInt24 || codec == AudioCodec::RawInt24Packed;
+}
+
 uint32_t toInt(SampleRate rate)
 {
     switch (rate) {
@@ -37,6 +46,9 @@ uint8_t toInt(ChannelFlags channels)
     if (channels.testFlag(Channels::Stereo))    i+=2;
     if (channels.testFlag(Channels::Lfe))       i+=1;
     if (channels.testFlag(Channels::RearStereo))    i+=2;
+    if (channels.testFlag(Channels::RearCenter))    i+=1;
+    if (channels.testFlag(Channels::SideStereo))    i+=2;
+    if (channels.testFlag(Channels::TopStereo))     i+=2;
 
     return i;
 }
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/BandSplitter.h"
+
+#include "audio/Denormals.h"
+#include "FixedPoint.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <loguru/loguru.hpp>
+
+namespace coro {
+namespace audio {
+
+template class TBandSplitter<float>;
+template class TBandSplitter<int16_t>;
+template class TBandSplitter<int32_t>;
+
+using namespace fixed;
+
+namespace {
+
+constexpr int coeffBits = TBiquadCascade<int32_t>::coeffBits;
+constexpr int feedForwardBits = TBiquadCascade<int32_t>::feedForwardBits;
+// Same as biquadCascadeFixed(): products are halved or shifted accordingly,
+// so sums cannot overflow.
+constexpr int ffShift = 1;
+constexpr int fbShift = coeffBits - feedForwardBits + ffShift;
+constexpr int bits = feedForwardBits - ffShift;
+
+// Fixed point counterpart of simd::biquadLanes(). Same layout.
+template <typename T>
+void biquadLanesFixed(const T* in, T* out, uint32_t frameCount, size_t inChannelCount, size_t laneCount,
+                      const int32_t* mix, const int32_t* coeffs, size_t sectionCount, int32_t* history, size_t stride)
+{
+    for (uint32_t i = 0; i < frameCount; ++i) {
+        for (size_t lane = 0; lane < laneCount; ++lane) {
+            int64_t sum = int64_t(1) << (coeffBits-2);
+            for (size_t ch = 0; ch < inChannelCount; ++ch) {
+                sum += (int64_t(mix[ch*stride + lane]) * toQ31(in[ch])) >> 1;
+            }
+            int32_t x = saturate(sum >> (coeffBits-1));
+            int32_t* z = history + lane;
+            for (size_t s = 0; s < sectionCount; ++s) {
+                const int32_t* cs = coeffs + s*5*stride + lane;
+                int32_t* zs = z + s*2*stride;
+                int64_t acc = int64_t(1) << (bits-1);
+                acc += (int64_t(cs[0])*x) >> ffShift;
+                acc += (int64_t(cs[stride])*zs[0]) >> ffShift;
+                acc += (int64_t(cs[2*stride])*zs[stride]) >> ffShift;
+                acc -= (int64_t(cs[3*stride])*zs[2*stride]) >> fbShift;
+                acc -= (int64_t(cs[4*stride])*zs[3*stride]) >> fbShift;
+                zs[stride] = zs[0];
+                zs[0] = x;
+                x = saturate(acc >> bits);
+            }
+            z[(2*sectionCount+1)*stride] = z[2*sectionCount*stride];
+            z[2*sectionCount*stride] = x;
+            out[lane] = fromQ31<T>(x);
+        }
+        in += inChannelCount;
+        out += laneCount;
+    }
+}
+
+} // namespace
+
+template <typename T>
+TBandSplitter<T>::TBandSplitter(uint8_t inputChannelCount, uint32_t rate)
+    : m_inputChannelCount(std::clamp<uint8_t>(inputChannelCount, 1, simd::maxLaneInputs)),
+      m_rate(rate)
+{
+}
+
+template <typename T>
+void TBandSplitter<T>::setInputChannelCount(uint8_t channelCount)
+{
+    channelCount = std::clamp<uint8_t>(channelCount, 1, simd::maxLaneInputs);
+    if (m_inputChannelCount == channelCount) {
+        return;
+    }
+
+    m_inputChannelCount = channelCount;
+    update();
+    reset();
+}
+
+template <typename T>
+uint8_t TBandSplitter<T>::inputChannelCount() const
+{
+    return m_inputChannelCount;
+}
+
+template <typename T>
+void TBandSplitter<T>::setOutputs(const std::vector<Output>& outputs)
+{
+    m_outputs = outputs;
+    update();
+    reset();
+}
+
+template <typename T>
+const std::vector<typename TBandSplitter<T>::Output>& TBandSplitter<T>::outputs() const
+{
+    return m_outputs;
+}
+
+template <typename T>
+std::size_t TBandSplitter<T>::outputCount() const
+{
+    return m_outputs.size();
+}
+
+template <typename T>
+void TBandSplitter<T>::setRate(uint32_t rate)
+{
+    if (m_rate == rate) {
+        return;
+    }
+
+    m_rate = rate;
+    const auto sections = m_sectionCount;
+    update();
+    // Keep history, if layout did not change
+    if (sections != m_sectionCount) {
+        reset();
+    }
+}
+
+template <typename T>
+std::size_t TBandSplitter<T>::sectionCount() const
+{
+    return m_sectionCount;
+}
+
+template <typename T>
+void TBandSplitter<T>::reset()
+{
+    m_history.assign((m_sectionCount+1) * 2 * m_stride, 0);
+}
+
+template <typename T>
+void TBandSplitter<T>::process(const T* in, T* out, uint32_t frameCount)
+{
+    if (m_outputs.empty()) {
+        return;
+    }
+
+    if constexpr (std::is_same<T, float>::value) {
+        ScopedDenormalFlush flush;
+        simd::biquadLanes(in, out, frameCount, m_inputChannelCount, m_outputs.size(),
+                          m_mix.data(), m_coeffs.data(), m_sectionCount, m_history.data(), m_stride,
+                          denormalOffset());
+    } else {
+        biquadLanesFixed(in, out, frameCount, m_inputChannelCount, m_outputs.size(),
+                         m_mix.data(), m_coeffs.data(), m_sectionCount, m_history.data(), m_stride);
+    }
+}
+
+template <typename T>
+void TBandSplitter<T>::update()
+{
+    auto toState = [](double v, int bits) -> State {
+        if constexpr (std::is_floating_point<T>::value) {
+            return v;
+        } else {
+            LOG_IF_F(WARNING, !fits(v, bits), "Mix gain %f out of fixed point range, clamped", v);
+            return toFixed(v, bits);
+        }
+    };
+
+    std::vector<std::vector<State>> coeffs(m_outputs.size());
+    m_sectionCount = 0;
+    for (std::size_t lane = 0; lane < m_outputs.size(); ++lane) {
+        TBiquadCascade<T>::computeCoefficients(m_outputs[lane].filters, m_rate, m_outputs[lane].gain, coeffs[lane]);
+        coeffs[lane].resize(std::min(coeffs[lane].size(), simd::maxLaneSections*5));
+        m_sectionCount = std::max(m_sectionCount, coeffs[lane].size()/5);
+    }
+
+    m_stride = (m_outputs.size() + 7) & ~std::size_t(7);
+    m_mix.assign(simd::maxLaneInputs * m_stride, 0);
+    m_coeffs.assign(m_sectionCount * 5 * m_stride, 0);
+    for (std::size_t lane = 0; lane < m_outputs.size(); ++lane) {
+        const auto& output = m_outputs[lane];
+        for (std::size_t ch = 0; ch < std::min<std::size_t>(output.mix.size(), m_inputChannelCount); ++ch) {
+            m_mix[ch*m_stride + lane] = toState(output.mix[ch], coeffBits);
+        }
+        // Shorter cascades are padded with identity sections.
+        for (std::size_t s = 0; s < m_sectionCount; ++s) {
+            for (std::size_t k = 0; k < 5; ++k) {
+                const std::size_t i = s*5 + k;
+                m_coeffs[i*m_stride + lane] = i < coeffs[lane].size() ? coeffs[lane][i] : (k == 0 ? toState(1.0, feedForwardBits) : 0);
+            }
+        }
+    }
+}
+
+} // namespace audio
+} // namespace coro
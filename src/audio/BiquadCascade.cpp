@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/BiquadCascade.h"
+
+#include "audio/CoefficientBank.h"
+#include "audio/Denormals.h"
+#include "FixedPoint.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iterator>
+#include <utility>
+
+#include <loguru/loguru.hpp>
+
+namespace coro {
+namespace audio {
+
+template class TBiquadCascade<float>;
+template class TBiquadCascade<int16_t>;
+template class TBiquadCascade<int32_t>;
+
+using namespace fixed;
+
+namespace {
+
+// Fixed point counterpart of simd::biquadCascade(). Same shared tap layout.
+template <typename T>
+void biquadCascadeFixed(const T* in, T* out, uint32_t frameCount, size_t channelCount,
+                        size_t inSpacing, size_t outSpacing,
+                        const int32_t* coeffs, size_t sectionCount, int32_t* history, size_t stride)
+{
+    // Products are summed with feed-forward bits minus one: feed-forward
+    // products are halved, feedback products shifted accordingly. So, the
+    // sum cannot overflow for any coefficients and samples.
+    constexpr int ffShift = 1;
+    constexpr int fbShift = TBiquadCascade<T>::coeffBits - TBiquadCascade<T>::feedForwardBits + ffShift;
+    constexpr int bits = TBiquadCascade<T>::feedForwardBits - ffShift;
+    for (uint32_t i = 0; i < frameCount; ++i) {
+        for (size_t ch = 0; ch < channelCount; ++ch) {
+            int32_t x = toQ31(in[i*inSpacing+ch]);
+            int32_t* z = history + ch;
+            for (size_t s = 0; s < sectionCount; ++s) {
+                const int32_t* cs = coeffs + s*5;
+                int32_t* zs = z + s*2*stride;
+                int64_t acc = int64_t(1) << (bits-1);
+                acc += (int64_t(cs[0])*x) >> ffShift;
+                acc += (int64_t(cs[1])*zs[0]) >> ffShift;
+                acc += (int64_t(cs[2])*zs[stride]) >> ffShift;
+                acc -= (int64_t(cs[3])*zs[2*stride]) >> fbShift;
+                acc -= (int64_t(cs[4])*zs[3*stride]) >> fbShift;
+                zs[stride] = zs[0];
+                zs[0] = x;
+                x = saturate(acc >> bits);
+            }
+            z[(2*sectionCount+1)*stride] = z[2*sectionCount*stride];
+            z[2*sectionCount*stride] = x;
+            out[i*outSpacing+ch] = fromQ31<T>(x);
+        }
+    }
+}
+
+} // namespace
+
+template <typename T>
+TBiquadCascade<T>::TBiquadCascade(uint8_t channelCount, uint32_t rate)
+    : m_rate(rate)
+{
+    // Presets are applied in process(), which must not allocate.
+    m_coeffs.reserve(simd::maxCascadeSections*5);
+    setChannelCount(channelCount);
+}
+
+template <typename T>
+void TBiquadCascade<T>::setChannelCount(uint8_t channelCount)
+{
+    if (m_channelCount == channelCount && !m_history.empty()) {
+        return;
+    }
+
+    m_channelCount = channelCount;
+    m_lanesPerState = (channelCount + std::size(Lanes().v) - 1) / std::size(Lanes().v);
+    m_history.assign((simd::maxCascadeSections+1) * 2 * m_lanesPerState, Lanes());
+}
+
+template <typename T>
+uint8_t TBiquadCascade<T>::channelCount() const
+{
+    return m_channelCount;
+}
+
+template <typename T>
+void TBiquadCascade<T>::setRate(uint32_t rate)
+{
+    if (m_rate == rate) {
+        return;
+    }
+    m_rate = rate;
+    if (m_preset) {
+        applyPreset();
+    } else {
+        update();
+    }
+}
+
+template <typename T>
+void TBiquadCascade<T>::setFilters(const std::vector<Filter>& filters)
+{
+    setFilters(std::make_shared<const TCoefficientSet<T>>(filters));
+}
+
+template <typename T>
+void TBiquadCascade<T>::setFilters(std::shared_ptr<const TCoefficientSet<T>> filterSet)
+{
+    m_filterSet.swap(filterSet);
+
+    // Owning node locks out the audio thread, so no preset is in use anymore.
+    // They are released outside of lock.
+    m_presetMutex.lock();
+    m_pendingPreset = nullptr;
+    const auto latest = std::move(m_latestPreset);
+    const auto used = std::move(m_usedPreset);
+    m_presetMutex.unlock();
+
+    m_preset = m_filterSet.get();
+    applyPreset();
+}
+
+template <typename T>
+std::vector<Filter> TBiquadCascade<T>::filters() const
+{
+    m_presetMutex.lock();
+    auto filters = m_latestPreset ? m_latestPreset->filters() :
+                   m_filterSet ? m_filterSet->filters() : std::vector<Filter>();
+    m_presetMutex.unlock();
+
+    return filters;
+}
+
+template <typename T>
+void TBiquadCascade<T>::setPreset(std::shared_ptr<const TCoefficientSet<T>> preset)
+{
+    std::shared_ptr<const TCoefficientSet<T>> released;
+
+    m_presetMutex.lock();
+    if (m_pendingPreset.exchange(preset.get())) {
+        // Previous preset was never picked up
+        released = std::move(m_latestPreset);
+    } else {
+        // Previous preset got picked up, the one before is not used anymore.
+        released = std::exchange(m_usedPreset, std::move(m_latestPreset));
+    }
+    m_latestPreset = std::move(preset);
+    m_presetMutex.unlock();
+}
+
+template <typename T>
+void TBiquadCascade<T>::setGain(float gain)
+{
+    if (m_gain == gain) {
+        return;
+    }
+    m_gain = gain;
+    if (m_preset) {
+        applyPreset();
+    } else {
+        update();
+    }
+}
+
+template <typename T>
+std::size_t TBiquadCascade<T>::sectionCount() const
+{
+    return m_coeffs.size() / 5;
+}
+
+template <typename T>
+void TBiquadCascade<T>::reset()
+{
+    std::fill(m_history.begin(), m_history.end(), Lanes());
+}
+
+template <typename T>
+void TBiquadCascade<T>::process(const T* in, T* out, uint32_t frameCount, uint8_t inSpacing, uint8_t outSpacing)
+{
+    pickUpPreset();
+    processLanes(in, out, frameCount, m_channelCount, inSpacing, outSpacing, 0);
+}
+
+template <typename T>
+void TBiquadCascade<T>::processPlanar(const T* in, T* out, uint32_t frameCount)
+{
+    pickUpPreset();
+    // Each plane runs as single channel on its own history lane
+    for (uint8_t ch = 0; ch < m_channelCount; ++ch) {
+        processLanes(in + ch*frameCount, out + ch*frameCount, frameCount, 1, 1, 1, ch);
+    }
+}
+
+template <typename T>
+void TBiquadCascade<T>::processLanes(const T* in, T* out, uint32_t frameCount, uint8_t channelCount,
+                                     uint8_t inSpacing, uint8_t outSpacing, std::size_t lane)
+{
+    const auto sections = sectionCount();
+    if (sections == 0) {
+        for (uint32_t i = 0; i < frameCount && in != out; ++i) {
+            std::copy(in + i*inSpacing, in + i*inSpacing + channelCount, out + i*outSpacing);
+        }
+        return;
+    }
+
+    const auto stride = m_lanesPerState * std::size(Lanes().v);
+    if constexpr (std::is_same<T, float>::value) {
+        // History decays into denormals during silence
+        ScopedDenormalFlush flush;
+        simd::biquadCascade(in, out, frameCount, channelCount, inSpacing, outSpacing,
+                            m_coeffs.data(), sections, m_history.front().v + lane,
+                            stride, denormalOffset());
+    } else {
+        biquadCascadeFixed(in, out, frameCount, channelCount, inSpacing, outSpacing,
+                           m_coeffs.data(), sections, m_history.front().v + lane, stride);
+    }
+}
+
+template <typename T>
+void TBiquadCascade<T>::pickUpPreset()
+{
+    if (const auto preset = m_pendingPreset.exchange(nullptr)) {
+        m_preset = preset;
+        applyPreset();
+    }
+}
+
+template <typename T>
+void TBiquadCascade<T>::computeCoefficients(const std::vector<Filter>& filters, uint32_t rate, double gain,
+                                            std::vector<State>& coeffs)
+{
+    auto toState = [](double coeff, int bits) -> State {
+        if constexpr (std::is_floating_point<T>::value) {
+            return coeff;
+        } else {
+            LOG_IF_F(WARNING, !fits(coeff, bits), "Biquad coefficient %f out of fixed point range, clamped", coeff);
+            return toFixed(coeff, bits);
+        }
+    };
+
+    coeffs.clear();
+    for (const auto& filter : filters) {
+        double c[5];
+        if (coeffs.size() == simd::maxCascadeSections*5) {
+            break;
+        }
+        if (!filter.isValid() || !biquadCoeffs(filter, rate, c)) {
+            continue;
+        }
+        // Gain is folded into first section.
+        const double g = coeffs.empty() ? gain : 1.0;
+        const State b0 = toState(c[0] * g, feedForwardBits);
+        const State b2 = toState(c[2] * g, feedForwardBits);
+        coeffs.push_back(b0);
+        // b1 takes up rounding errors of b0 and b2, so DC gain stays exact.
+        if constexpr (std::is_floating_point<T>::value) {
+            coeffs.push_back(toState(c[1] * g, feedForwardBits));
+        } else {
+            const double b1 = (c[0] + c[1] + c[2]) * g - (double(b0) + double(b2)) / (int64_t(1) << feedForwardBits);
+            coeffs.push_back(toState(b1, feedForwardBits));
+        }
+        coeffs.push_back(b2);
+        coeffs.push_back(toState(c[3], coeffBits));
+        coeffs.push_back(toState(c[4], coeffBits));
+    }
+
+    // Without filters, gain needs a section on its own.
+    if (coeffs.empty() && gain != 1.0) {
+        coeffs = { toState(gain, feedForwardBits), 0, 0, 0, 0 };
+    }
+}
+
+template <typename T>
+void TBiquadCascade<T>::update()
+{
+    const auto sections = sectionCount();
+    // Neither filters nor a preset were set
+    computeCoefficients({}, m_rate, m_gain, m_coeffs);
+    clearHistory(sections, sectionCount());
+}
+
+template <typename T>
+void TBiquadCascade<T>::applyPreset()
+{
+    const auto coeffs = m_preset->coeffs(m_rate);
+    if (!coeffs) {
+        // Rate was not precomputed
+        const auto sections = sectionCount();
+        computeCoefficients(m_preset->filters(), m_rate, m_gain, m_coeffs);
+        clearHistory(sections, sectionCount());
+        return;
+    }
+
+    // Fits into reserved capacity, so nothing is allocated.
+    const auto sections = sectionCount();
+    m_coeffs.assign(coeffs->begin(), coeffs->end());
+    if (m_gain != 1.0f) {
+        auto scale = [this](double coeff) -> State {
+            if constexpr (std::is_floating_point<T>::value) {
+                return coeff * m_gain;
+            } else {
+                const double scaled = coeff * m_gain;
+                LOG_IF_F(WARNING, !fits(scaled, 0), "Biquad gain %f out of fixed point range, clamped", m_gain);
+                return toFixed(scaled, 0);
+            }
+        };
+        // Without filters, gain needs a section on its own.
+        if (m_coeffs.empty()) {
+            m_coeffs.assign(5, 0);
+            if constexpr (std::is_floating_point<T>::value) {
+                m_coeffs[0] = 1;
+            } else {
+                m_coeffs[0] = State(1) << feedForwardBits;
+            }
+        }
+        if constexpr (std::is_floating_point<T>::value) {
+            for (std::size_t i = 0; i < 3; ++i) {
+                m_coeffs[i] = scale(m_coeffs[i]);
+            }
+        } else {
+            // Like in computeCoefficients(), b1 takes up rounding errors.
+            const double sum = double(m_coeffs[0]) + double(m_coeffs[1]) + double(m_coeffs[2]);
+            m_coeffs[0] = scale(m_coeffs[0]);
+            m_coeffs[2] = scale(m_coeffs[2]);
+            m_coeffs[1] = saturate(int64_t(scale(sum)) - m_coeffs[0] - m_coeffs[2]);
+        }
+    }
+    clearHistory(sections, sectionCount());
+}
+
+template <typename T>
+void TBiquadCascade<T>::clearHistory(std::size_t fromSection, std::size_t toSection)
+{
+    // History of remaining sections is kept, so coefficient updates do not
+    // click. Output tap moves with the section count, newly used taps start
+    // from silence.
+    if (toSection > fromSection) {
+        std::fill(m_history.begin() + (fromSection+1) * 2 * m_lanesPerState,
+                  m_history.begin() + (toSection+1) * 2 * m_lanesPerState, Lanes());
+    }
+}
+
+} // namespace audio
+} // namespace coro
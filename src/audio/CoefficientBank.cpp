@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/CoefficientBank.h"
+
+#include <utility>
+
+namespace coro {
+namespace audio {
+
+template class TCoefficientSet<float>;
+template class TCoefficientSet<int16_t>;
+template class TCoefficientSet<int32_t>;
+template class TCoefficientBank<float>;
+template class TCoefficientBank<int16_t>;
+template class TCoefficientBank<int32_t>;
+
+template <typename T>
+TCoefficientSet<T>::TCoefficientSet(const std::vector<Filter>& filters, SampleRates rates)
+    : m_filters(filters)
+{
+    for (auto rate : { SampleRate::Rate32000, SampleRate::Rate44100, SampleRate::Rate48000,
+                       SampleRate::Rate96000, SampleRate::Rate192000 }) {
+        if (!rates.testFlag(rate)) {
+            continue;
+        }
+        std::vector<State> coeffs;
+        TBiquadCascade<T>::computeCoefficients(filters, toInt(rate), 1.0, coeffs);
+        m_coeffs.emplace_back(toInt(rate), std::move(coeffs));
+    }
+}
+
+template <typename T>
+const std::vector<Filter>& TCoefficientSet<T>::filters() const
+{
+    return m_filters;
+}
+
+template <typename T>
+const std::vector<typename TCoefficientSet<T>::State>* TCoefficientSet<T>::coeffs(uint32_t rate) const
+{
+    for (const auto& coeffs : m_coeffs) {
+        if (coeffs.first == rate) {
+            return &coeffs.second;
+        }
+    }
+    return nullptr;
+}
+
+template <typename T>
+TCoefficientBank<T>::TCoefficientBank(SampleRates rates)
+    : m_rates(rates)
+{
+}
+
+template <typename T>
+std::shared_ptr<const TCoefficientSet<T>> TCoefficientBank<T>::setPreset(const std::string& name, const std::vector<Filter>& filters)
+{
+    // Compute outside of lock
+    auto preset = std::make_shared<const TCoefficientSet<T>>(filters, m_rates);
+
+    // Replaced preset is released outside of lock (unless filters still use it)
+    m_mutex.lock();
+    const auto replaced = std::exchange(m_presets[name], preset);
+    m_mutex.unlock();
+
+    return preset;
+}
+
+template <typename T>
+std::shared_ptr<const TCoefficientSet<T>> TCoefficientBank<T>::preset(const std::string& name) const
+{
+    m_mutex.lock();
+    const auto it = m_presets.find(name);
+    const auto preset = it != m_presets.end() ? it->second : nullptr;
+    m_mutex.unlock();
+
+    return preset;
+}
+
+template <typename T>
+std::vector<std::string> TCoefficientBank<T>::presetNames() const
+{
+    std::vector<std::string> names;
+    m_mutex.lock();
+    for (const auto& preset : m_presets) {
+        names.push_back(preset.first);
+    }
+    m_mutex.unlock();
+
+    return names;
+}
+
+} // namespace audio
+} // namespace coro
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/Convolver.h"
+
+#include <loguru/loguru.hpp>
+
+namespace coro {
+namespace audio {
+
+Convolver::Convolver(std::size_t blockSize, std::size_t tailBlockSize) :
+    m_blockSize(blockSize),
+    m_tailBlockSize(tailBlockSize)
+{
+}
+
+void Convolver::setImpulseResponses(const std::vector<std::vector<float>>& impulseResponses, uint32_t rate)
+{
+    std::unique_ptr<PartitionedConvolver> convolver;
+    if (!impulseResponses.empty()) {
+        convolver = std::make_unique<PartitionedConvolver>(m_blockSize, m_tailBlockSize);
+        convolver->setImpulseResponses(impulseResponses);
+    }
+
+    m_mutex.lock();
+    m_convolver.swap(convolver);
+    m_rate = rate;
+    m_mutex.unlock();
+}
+
+std::size_t Convolver::latency() const
+{
+    return m_blockSize;
+}
+
+const char* Convolver::name() const
+{
+    return "Convolver";
+}
+
+void Convolver::onProcess(core::BufferPtr& buffer)
+{
+    const auto& conf = buffer->audioConf();
+    m_mutex.lock();
+    if (!m_convolver) {
+        m_mutex.unlock();
+        return;
+    }
+    const bool isMatching = m_convolver->channelCount() == audio::toInt(conf.channels) && m_rate == audio::toInt(conf.rate);
+    if (!isMatching) {
+        if (m_isMatching) {
+            LOG_F(WARNING, "%s> impulse responses do not match stream, bypassing", name());
+        }
+        m_isMatching = false;
+        m_mutex.unlock();
+        return;
+    }
+    m_isMatching = true;
+
+    const uint32_t frameCount = buffer->size()/conf.frameSize();
+    if (conf.isPlanar) {
+        m_convolver->processPlanar((float*)buffer->data(), (float*)buffer->data(), frameCount);
+    } else {
+        m_convolver->process((float*)buffer->data(), (float*)buffer->data(), frameCount);
+    }
+    m_mutex.unlock();
+}
+
+} // namespace audio
+} // namespace coro
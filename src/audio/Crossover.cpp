@@ -1,56 +1,88 @@
 #include "audio/Crossover.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
 namespace coro
 {
 namespace audio
 {
 
-Crossover::Crossover()
-    : m_filter( { FilterType::Crossover, 3000.0f, 0.0f, 0.5f } ),
-      m_lfe(false),
-      m_lp(2, 2),
-      m_hp(2, 2),
-      m_lfeLp(1, 2),
-      m_lfeHp(2, 2)
+template class TCrossover<float>;
+template class TCrossover<int16_t>;
+template class TCrossover<int32_t>;
+
+namespace {
+
+// LR2 (q <= 0.5) has one section per filter, LR4 two.
+void appendLinkwitzRiley(std::vector<Filter>& filters, FilterType type, const Filter& f)
 {
-    updateCrossover();
-    updateLfe();
+    const Filter filter { type, f.f, 0.0, f.q };
+    filters.push_back(filter);
+    if (f.q > 0.5f) {
+        filters.push_back(filter);
+    }
 }
 
-void Crossover::setFilter(const Filter& f)
+} // namespace
+
+template <typename T>
+TCrossover<T>::TCrossover()
+    : m_filters( { { FilterType::Crossover, 3000.0f, 0.0f, 0.5f } } )
 {
-    if (m_filter == f) {
-        return;
-    }
+    update();
+}
+
+template <typename T>
+void TCrossover<T>::setFilter(const Filter& f)
+{
+    setFilters({ f });
+}
+
+template <typename T>
+void TCrossover<T>::setFilters(const std::vector<Filter>& filters)
+{
+    std::vector<Filter> valid;
+    std::copy_if(filters.begin(), filters.end(), std::back_inserter(valid), [](const Filter& f) {
+        return f.isValid();
+    });
+    std::sort(valid.begin(), valid.end(), [](const Filter& a, const Filter& b) {
+        return a.f < b.f;
+    });
+    valid.resize(std::min(valid.size(), maxFilterCount));
 
     m_mutex.lock();
-    m_filter = f;
-    if (m_filter.isValid()) {
-        updateCrossover();
-    }
+    m_filters = valid;
+    update();
     m_mutex.unlock();
+    bumpRevision();
 }
 
-/*
-float Crossover::frequency()
+template <typename T>
+std::vector<Filter> TCrossover<T>::filters()
 {
     m_mutex.lock();
-    float freq = m_frequency;
+    const auto filters = m_filters;
     m_mutex.unlock();
 
-    return freq;
+    return filters;
 }
-*/
 
-void Crossover::setLfe(bool enable)
+template <typename T>
+void TCrossover<T>::setLfe(bool enable)
 {
     m_mutex.lock();
-    m_lfe = enable;
-    updateLfe();
+    if (m_lfe != enable) {
+        m_lfe = enable;
+        update();
+    }
     m_mutex.unlock();
+    bumpRevision();
 }
 
-bool Crossover::lfe()
+template <typename T>
+bool TCrossover<T>::lfe()
 {
     m_mutex.lock();
     bool l = m_lfe;
@@ -59,82 +91,98 @@ bool Crossover::lfe()
     return l;
 }
 
-const char* Crossover::name() const
+template <typename T>
+const char* TCrossover<T>::name() const
 {
     return "Crossover";
 }
 
-AudioConf Crossover::onProcess(const AudioConf& conf, core::Buffer& buffer)
+template <typename T>
+void TCrossover<T>::onProcess(core::BufferPtr& buffer)
 {
-    if (!m_filter.isValid()) {
-        return conf;
-    }
-
-    auto outData = buffer.acquire(buffer.size()*2);
-    auto inData = buffer.data();
-    const auto frameCount = buffer.size()/conf.frameSize();
-
+    auto& conf = buffer->audioConf();
     m_mutex.lock();
-    // Front channels
-    m_lp.process((float*)inData, (float*)outData, frameCount, 2, 4);
-    float* out = (float*)outData;
-    if (m_lowGain < 1.0f) {
-        for (uint i = 0; i < frameCount; ++i) {
-            for (uint c = 0; c < 2; ++c) {
-                *out *= m_lowGain;
-                ++out;
-            }
-            out += 4-2;
-        }
-    }
-    // Rear channels
-    m_hp.process((float*)inData, (float*)outData+2, frameCount, 2, 4);
-    out = (float*)outData+2;
-    if (m_highGain < 1.0f) {
-        for (uint i = 0; i < frameCount; ++i) {
-            for (uint c = 0; c < 2; ++c) {
-                *out *= m_highGain;
-                ++out;
-            }
-            out += 4-2;
-        }
+    if (!m_splitter.outputCount() || conf.channels != ChannelFlags(Channels::Stereo) || conf.isPlanar) {
+        m_mutex.unlock();
+        return;
     }
-    m_mutex.unlock();
 
-    buffer.commit(buffer.size()*2);
+    m_splitter.setRate(toInt(conf.rate));
+    const auto frameCount = buffer->size()/conf.frameSize();
+    const auto outSize = frameCount * m_splitter.outputCount() * sizeof(T);
+    auto outData = buffer->acquire(outSize, this);
+    auto inData = buffer->data();
+    m_splitter.process((const T*)inData, (T*)outData, frameCount);
+    conf.channels = m_channels;
+    m_mutex.unlock();
 
-    auto _conf = conf;
-    _conf.channels = Channels::Quad;
-    return _conf;
+    buffer->commit(outSize);
 }
 
-/*
-bool Crossover::isFrequencyValid() const
+template <typename T>
+void TCrossover<T>::update()
 {
-    return (m_filter >= 20.0 && m_filter <= 20000.0);
-}
-*/
+    if (m_filters.empty() && !m_lfe) {
+        m_splitter.setOutputs({});
+        return;
+    }
 
-void Crossover::updateCrossover()
-{
-    m_lowGain = m_filter.g > 0.0 ? pow(10, (-m_filter.g/20.0)) : 1.0;
-    m_highGain = m_filter.g < 0.0 ? pow(10, (m_filter.g/20.0)) : 1.0;
+    // Band i is high-passed by all points below, low-passed by the point
+    // above and all-passed by all points further up. So, all bands pass the
+    // same all-pass chain and sum up flat.
+    const std::size_t bandCount = m_filters.size() + 1;
+    std::vector<typename TBandSplitter<T>::Output> bands(bandCount);
+    for (std::size_t i = 0; i < bandCount; ++i) {
+        auto& band = bands.at(i);
+        if (i == 0 && m_lfe) {
+            appendLinkwitzRiley(band.filters, FilterType::HighPass, { FilterType::Crossover, lfeFrequency, 0.0f, M_SQRT1_2 });
+        }
+        for (std::size_t j = 0; j < m_filters.size(); ++j) {
+            const auto& f = m_filters.at(j);
+            if (j < i) {
+                appendLinkwitzRiley(band.filters, FilterType::HighPass, f);
+            } else if (j == i) {
+                appendLinkwitzRiley(band.filters, FilterType::LowPass, f);
+            } else {
+                band.filters.push_back({ FilterType::AllPass, f.f, 0.0f, f.q });
+            }
 
-    // If we are a LR2 crossover, we invert the high signal
-    if (m_filter.q <= 0.5) {
-        m_highGain *= -1.0;
+            // Gain attenuates band below (positive) or above (negative)
+            if (j == i && f.g > 0.0f) {
+                band.gain *= pow(10, -f.g/20.0);
+            } else if (j+1 == i && f.g < 0.0f) {
+                band.gain *= pow(10, f.g/20.0);
+            }
+            // LR2 inverts each high-passed signal
+            if (j < i && f.q <= 0.5f) {
+                band.gain *= -1.0f;
+            }
+        }
     }
 
-    m_lp.setCascadeCount(m_filter.q <= 0.5f ? 1 : 2);
-    m_lp.setFilter({ FilterType::LowPass, m_filter.f, 0.0, m_filter.q });
-    m_hp.setCascadeCount(m_filter.q <= 0.5f ? 1 : 2);
-    m_hp.setFilter({ FilterType::HighPass, m_filter.f, 0.0, m_filter.q });
-}
+    std::vector<typename TBandSplitter<T>::Output> outputs;
+    for (const auto& band : bands) {
+        outputs.push_back({ { 1.0f, 0.0f }, band.filters, band.gain });
+        outputs.push_back({ { 0.0f, 1.0f }, band.filters, band.gain });
+    }
+    if (m_lfe) {
+        typename TBandSplitter<T>::Output lfe { { float(M_SQRT1_2), float(M_SQRT1_2) }, {}, 1.0f };
+        appendLinkwitzRiley(lfe.filters, FilterType::LowPass, { FilterType::Crossover, lfeFrequency, 0.0f, M_SQRT1_2 });
+        outputs.push_back(lfe);
+    }
+    m_splitter.setOutputs(outputs);
 
-void Crossover::updateLfe()
-{
-    m_lfeLp.setFilter({ FilterType::LowPass, 80.0, 0.0, M_SQRT1_2 });
-    m_lfeHp.setFilter({ FilterType::HighPass, 80.0, 0.0, M_SQRT1_2 });
+    static constexpr Channels bandChannels[] = { Channels::Stereo, Channels::RearStereo, Channels::SideStereo, Channels::TopStereo };
+    m_channels = Channels::Invalid;
+    for (std::size_t i = 0; i < bandCount; ++i) {
+        m_channels |= bandChannels[i];
+    }
+    if (m_lfe) {
+        m_channels |= Channels::Lfe;
+    }
+
+    // Bands are written behind the incoming frames.
+    setTailroom(outputs.size()/2.0f);
 }
 
 } // namespace audio
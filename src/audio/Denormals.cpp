@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/Denormals.h"
+
+#include <atomic>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace coro {
+namespace audio {
+
+namespace {
+
+std::atomic<DenormalMode> s_mode { DenormalMode::FlushToZero };
+
+// -400 dB, far above the smallest normal float (~1.2e-38).
+constexpr float dcOffset = 1e-20f;
+
+#if defined(__SSE__)
+// MXCSR: flush to zero (bit 15) and denormals are zero (bit 6)
+constexpr uint64_t flushBits = 0x8040;
+
+inline uint64_t controlRegister()
+{
+    return _mm_getcsr();
+}
+
+inline void setControlRegister(uint64_t state)
+{
+    _mm_setcsr(static_cast<unsigned int>(state));
+}
+#elif defined(__aarch64__)
+// FPCR: flush to zero (bit 24), also applies to inputs
+constexpr uint64_t flushBits = 1 << 24;
+
+inline uint64_t controlRegister()
+{
+    uint64_t state;
+    asm volatile("mrs %0, fpcr" : "=r"(state));
+    return state;
+}
+
+inline void setControlRegister(uint64_t state)
+{
+    asm volatile("msr fpcr, %0" : : "r"(state));
+}
+#elif defined(__arm__) && defined(__ARM_FP)
+// FPSCR: flush to zero (bit 24), also applies to inputs. NEON always flushes.
+constexpr uint64_t flushBits = 1 << 24;
+
+inline uint64_t controlRegister()
+{
+    uint32_t state;
+    asm volatile("vmrs %0, fpscr" : "=r"(state));
+    return state;
+}
+
+inline void setControlRegister(uint64_t state)
+{
+    asm volatile("vmsr fpscr, %0" : : "r"(static_cast<uint32_t>(state)));
+}
+#else
+#define CORO_NO_DENORMAL_FLUSH
+#endif
+
+} // namespace
+
+void setDenormalMode(DenormalMode mode)
+{
+    s_mode = mode;
+}
+
+DenormalMode denormalMode()
+{
+    return s_mode;
+}
+
+bool canFlushDenormals()
+{
+#if defined(CORO_NO_DENORMAL_FLUSH)
+    return false;
+#else
+    return true;
+#endif
+}
+
+float denormalOffset()
+{
+    switch (s_mode.load(std::memory_order_relaxed)) {
+    case DenormalMode::Off:
+        return 0.0f;
+    case DenormalMode::FlushToZero:
+        return canFlushDenormals() ? 0.0f : dcOffset;
+    case DenormalMode::DcOffset:
+        return dcOffset;
+    }
+    return 0.0f;
+}
+
+ScopedDenormalFlush::ScopedDenormalFlush()
+{
+#if !defined(CORO_NO_DENORMAL_FLUSH)
+    if (s_mode.load(std::memory_order_relaxed) != DenormalMode::FlushToZero) {
+        return;
+    }
+
+    m_state = controlRegister();
+    if ((m_state & flushBits) != flushBits) {
+        setControlRegister(m_state | flushBits);
+        m_restore = true;
+    }
+#endif
+}
+
+ScopedDenormalFlush::~ScopedDenormalFlush()
+{
+#if !defined(CORO_NO_DENORMAL_FLUSH)
+    if (m_restore) {
+        setControlRegister(m_state);
+    }
+#endif
+}
+
+} // namespace audio
+} // namespace coro
@@ -48,15 +48,33 @@ void FileSink::onStop()
     }
 }
 
-AudioConf FileSink::onProcess(const AudioConf& conf, core::Buffer& buffer)
+void FileSink::onProcess(core::BufferPtr& buffer)
 {
     if (!m_file.is_open()) {
         onStart();
     }
 
-    m_file.write(buffer.data(), buffer.size());
-    buffer.clear();
-    return conf;
+    // Files store interleaved frames only
+    if (buffer->audioConf().isPlanar) {
+        if (!m_isRejected) {
+            LOG_F(WARNING, "%s does not take planar buffers", name());
+            m_isRejected = true;
+        }
+        buffer->clear();
+        return;
+    }
+    m_isRejected = false;
+
+    // Write segments one by one, so buffer does not need to be flattened.
+    struct iovec segments[8];
+    const auto count = buffer->segments(segments, 8);
+    if (count < buffer->segmentCount()) {
+        LOG_F(WARNING, "Too many segments: %zu", buffer->segmentCount());
+    }
+    for (size_t i = 0; i < count; ++i) {
+        m_file.write(static_cast<const char*>(segments[i].iov_base), segments[i].iov_len);
+    }
+    buffer->clear();
 }
 
 } // namespace audio
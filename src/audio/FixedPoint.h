@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+
+namespace coro {
+namespace audio {
+namespace fixed {
+
+// Fixed point helpers of the int16_t/int32_t DSP paths. Samples and history
+// are Q31 (int16_t is promoted).
+
+inline int32_t saturate(int64_t v)
+{
+    return int32_t(std::clamp<int64_t>(v, INT32_MIN, INT32_MAX));
+}
+
+// Whether v fits into int32_t with the given fractional bits.
+inline bool fits(double v, int bits)
+{
+    return std::abs(std::ldexp(v, bits)) <= INT32_MAX;
+}
+
+// Rounds v to the given fractional bits. Saturates, if it does not fit.
+inline int32_t toFixed(double v, int bits)
+{
+    return saturate(std::llround(std::ldexp(v, bits)));
+}
+
+template <typename T> inline int32_t toQ31(T v);
+template <> inline int32_t toQ31(int16_t v) { return int32_t(v) * 65536; }
+template <> inline int32_t toQ31(int32_t v) { return v; }
+
+template <typename T> inline T fromQ31(int32_t v);
+template <> inline int16_t fromQ31(int32_t v) { return int16_t(std::min<int64_t>((int64_t(v) + 0x8000) >> 16, INT16_MAX)); }
+template <> inline int32_t fromQ31(int32_t v) { return v; }
+
+} // namespace fixed
+} // namespace audio
+} // namespace coro
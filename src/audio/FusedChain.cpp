@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/FusedChain.h"
+
+#include "audio/AudioConverter.h"
+#include "audio/CoefficientBank.h"
+#include "audio/Crossover.h"
+#include "audio/Denormals.h"
+#include "audio/Loudness.h"
+#include "audio/Peq.h"
+#include "Simd.h"
+
+#include <loguru/loguru.hpp>
+
+#include <algorithm>
+
+namespace coro {
+namespace audio {
+
+FusedChain::FusedChain()
+{
+}
+
+FusedChain::~FusedChain()
+{
+}
+
+std::size_t FusedChain::compile()
+{
+    m_stages.clear();
+    m_cascades.clear();
+    m_splitter.setOutputs({});
+
+    auto node = m_head;
+    auto append = [&](Kind kind) {
+        m_stages.push_back({ static_cast<AudioNode*>(node), kind });
+        node = node->next();
+    };
+
+    // Bypassed converters would change formats within the run
+    if (auto converter = dynamic_cast<AudioConverter<int16_t,float>*>(node); converter && !converter->isBypassed()) {
+        append(Kind::ConverterIn);
+    }
+    while (node) {
+        if (dynamic_cast<Loudness*>(node)) {
+            append(Kind::Loudness);
+        } else if (dynamic_cast<Peq*>(node)) {
+            append(Kind::Peq);
+        } else {
+            break;
+        }
+    }
+    // Crossover changes channels, so it ends the filter stages
+    if (dynamic_cast<Crossover*>(node)) {
+        append(Kind::Crossover);
+    }
+    if (auto converter = dynamic_cast<AudioConverter<float,int16_t>*>(node); converter && !converter->isBypassed()) {
+        append(Kind::ConverterOut);
+    }
+
+    if (m_stages.size() < 2) {
+        m_stages.clear();
+        Node::setNext(m_head);
+        setTailroom(0.0f);
+        return 0;
+    }
+
+    m_isInt16In = m_stages.front().kind == Kind::ConverterIn;
+    m_isInt16Out = m_stages.back().kind == Kind::ConverterOut;
+    for (auto& stage : m_stages) {
+        // Force rebuild of all stages
+        stage.revision = stage.node->revision() - 1;
+    }
+    rebuild();
+
+    LOG_F(INFO, "%s fused %zu nodes", name(), m_stages.size());
+    Node::setNext(node);
+    return m_stages.size();
+}
+
+std::vector<AudioNode*> FusedChain::nodes() const
+{
+    std::vector<AudioNode*> nodes;
+    for (const auto& stage : m_stages) {
+        nodes.push_back(stage.node);
+    }
+    return nodes;
+}
+
+const char* FusedChain::name() const
+{
+    return "FusedChain";
+}
+
+void FusedChain::setNext(core::Node* next)
+{
+    m_head = next;
+    m_stages.clear();
+    setTailroom(0.0f);
+    Node::setNext(next);
+}
+
+void FusedChain::onProcess(core::BufferPtr& buffer)
+{
+    if (m_stages.empty()) {
+        return;
+    }
+    if (isDirty()) {
+        rebuild();
+    }
+
+    auto& conf = buffer->audioConf();
+    if (conf.codec != (m_isInt16In ? AudioCodec::RawInt16 : AudioCodec::RawFloat32) || conf.isPlanar) {
+        return;
+    }
+
+    const uint8_t channelCount = toInt(conf.channels);
+    const bool isSplit = m_splitter.outputCount() && conf.channels == ChannelFlags(Channels::Stereo);
+    const std::size_t outChannelCount = isSplit ? m_splitter.outputCount() : channelCount;
+    const std::size_t inFrameSize = channelCount * (m_isInt16In ? sizeof(int16_t) : sizeof(float));
+    const std::size_t outFrameSize = outChannelCount * (m_isInt16Out ? sizeof(int16_t) : sizeof(float));
+    const uint32_t frameCount = buffer->size()/inFrameSize;
+    const std::size_t outSize = frameCount*outFrameSize;
+
+    for (auto& cascade : m_cascades) {
+        cascade->setRate(toInt(conf.rate));
+        cascade->setChannelCount(channelCount);
+    }
+    m_splitter.setRate(toInt(conf.rate));
+    if (m_block.size() < blockSize*channelCount) {
+        m_block.resize(blockSize*channelCount);
+    }
+    if (m_bands.size() < blockSize*outChannelCount) {
+        m_bands.resize(blockSize*outChannelCount);
+    }
+
+    // Output which does not grow is written in place: each block is read
+    // before it gets overwritten and output never runs ahead of input.
+    const bool isInPlace = outFrameSize <= inFrameSize;
+    char* outData = isInPlace ? nullptr : buffer->acquire(outSize, this);
+    const char* inData = buffer->data();
+    if (isInPlace) {
+        outData = buffer->data();
+    }
+
+    ScopedDenormalFlush flush;
+    for (uint32_t offset = 0; offset < frameCount; offset += blockSize) {
+        const uint32_t count = std::min(blockSize, frameCount - offset);
+        const char* in = inData + offset*inFrameSize;
+        char* out = outData + offset*outFrameSize;
+
+        // Conversion in (same kernels as AudioConverter)
+        const float* x = (const float*)in;
+        if (m_isInt16In) {
+            simd::int16ToFloat(m_block.data(), (const int16_t*)in, count*channelCount);
+            x = m_block.data();
+        }
+
+        // Sections. Filtered straight into output, if nothing follows.
+        float* y = (isSplit || m_isInt16Out) ? m_block.data() : (float*)out;
+        for (auto& cascade : m_cascades) {
+            cascade->process(x, y, count, channelCount, channelCount);
+            x = y;
+        }
+
+        // Bands and conversion out
+        if (isSplit) {
+            float* bands = m_isInt16Out ? m_bands.data() : (float*)out;
+            m_splitter.process(x, bands, count);
+            if (m_isInt16Out) {
+                simd::floatToInt16((int16_t*)out, bands, count*outChannelCount);
+            }
+        } else if (m_isInt16Out) {
+            simd::floatToInt16((int16_t*)out, x, count*channelCount);
+        } else if (x != (const float*)out) {
+            std::copy(x, x + count*channelCount, (float*)out);
+        }
+    }
+
+    if (isInPlace) {
+        buffer->shrink(outSize);
+    } else {
+        buffer->commit(outSize);
+    }
+    conf.codec = m_isInt16Out ? AudioCodec::RawInt16 : AudioCodec::RawFloat32;
+    if (isSplit) {
+        conf.channels = m_channels;
+    }
+}
+
+bool FusedChain::isDirty() const
+{
+    for (const auto& stage : m_stages) {
+        if (stage.node->revision() != stage.revision || stage.node->isBypassed() != stage.isBypassed) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FusedChain::rebuild()
+{
+    std::vector<Filter> filters;
+    float gain = 1.0f;
+    for (auto& stage : m_stages) {
+        const bool isDirty = stage.node->revision() != stage.revision || stage.node->isBypassed() != stage.isBypassed;
+        // Read revision first, so changes while reading trigger another rebuild.
+        stage.revision = stage.node->revision();
+        stage.isBypassed = stage.node->isBypassed();
+
+        switch (stage.kind) {
+        case Kind::ConverterIn:
+        case Kind::ConverterOut:
+            break;
+        case Kind::Loudness: {
+            if (stage.isBypassed) {
+                break;
+            }
+            auto loudness = static_cast<Loudness*>(stage.node);
+            loudness->m_mutex.lock();
+            // Same as Loudness::onProcess()
+            const float volume = std::min(loudness->m_volume, loudness->m_headroom);
+            if (volume != 1.0f) {
+                gain *= volume;
+                if (loudness->m_headroom != 1.0f) {
+                    const auto& f = loudness->m_cascade.filters();
+                    filters.insert(filters.end(), f.begin(), f.end());
+                }
+            }
+            loudness->m_mutex.unlock();
+            break;
+        }
+        case Kind::Peq: {
+            if (stage.isBypassed) {
+                break;
+            }
+            auto peq = static_cast<Peq*>(stage.node);
+            peq->m_mutex.lock();
+            const auto& f = peq->m_cascade.filters();
+            filters.insert(filters.end(), f.begin(), f.end());
+            peq->m_mutex.unlock();
+            break;
+        }
+        case Kind::Crossover: {
+            // Splitter history is only reset, if crossover changed.
+            if (!isDirty) {
+                break;
+            }
+            auto crossover = static_cast<Crossover*>(stage.node);
+            crossover->m_mutex.lock();
+            m_splitter.setOutputs(stage.isBypassed ? std::vector<BandSplitter::Output>() : crossover->m_splitter.outputs());
+            m_channels = crossover->m_channels;
+            crossover->m_mutex.unlock();
+            break;
+        }
+        }
+    }
+
+    // Invalid filters would be skipped within cascades anyway
+    filters.erase(std::remove_if(filters.begin(), filters.end(), [](const Filter& f) {
+        return !f.isValid();
+    }), filters.end());
+
+    // Cascades keep their history, so parameter changes do not click.
+    std::size_t cascadeCount = (filters.size() + simd::maxCascadeSections - 1) / simd::maxCascadeSections;
+    if (!cascadeCount && gain != 1.0f) {
+        cascadeCount = 1;
+    }
+    while (m_cascades.size() > cascadeCount) {
+        m_cascades.pop_back();
+    }
+    while (m_cascades.size() < cascadeCount) {
+        m_cascades.push_back(std::make_unique<BiquadCascade>());
+    }
+    for (std::size_t i = 0; i < cascadeCount; ++i) {
+        const auto begin = filters.begin() + std::min(filters.size(), i*simd::maxCascadeSections);
+        const auto end = filters.begin() + std::min(filters.size(), (i+1)*simd::maxCascadeSections);
+        // Runs in audio thread, so only the current rate is computed.
+        m_cascades.at(i)->setFilters(std::make_shared<const CoefficientSet>(std::vector<Filter>(begin, end), SampleRates()));
+        m_cascades.at(i)->setGain(i == 0 ? gain : 1.0f);
+    }
+
+    // Stereo input, bands are written behind
+    const float inSize = 2.0f * (m_isInt16In ? sizeof(int16_t) : sizeof(float));
+    const float outSize = std::max<std::size_t>(2, m_splitter.outputCount()) * (m_isInt16Out ? sizeof(int16_t) : sizeof(float));
+    setTailroom(outSize > inSize ? outSize/inSize : 0.0f);
+}
+
+} // namespace audio
+} // namespace coro
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/Interleaver.h"
+
+#include "Simd.h"
+
+namespace coro {
+namespace audio {
+
+template class TDeinterleaver<float>;
+template class TDeinterleaver<int16_t>;
+template class TDeinterleaver<int32_t>;
+template class TInterleaver<float>;
+template class TInterleaver<int16_t>;
+template class TInterleaver<int32_t>;
+
+namespace {
+
+// Shuffles into memory behind the payload, since planes and frames overlap.
+template <typename T, bool toPlanar>
+void reorder(core::Buffer& buffer, const core::Node* caller)
+{
+    auto& conf = buffer.audioConf();
+    const auto channelCount = toInt(conf.channels);
+    if (!channelCount || conf.codec != rawCodec<T>() || conf.isPlanar == toPlanar) {
+        return;
+    }
+
+    const auto size = buffer.size();
+    const auto frameCount = size/conf.frameSize();
+    T* out = (T*)buffer.acquire(size, caller);
+    const T* in = (const T*)buffer.data();
+    if (toPlanar) {
+        simd::deinterleave(out, in, channelCount, frameCount);
+    } else {
+        simd::interleave(out, in, channelCount, frameCount);
+    }
+    buffer.commit(size);
+    conf.isPlanar = toPlanar;
+}
+
+} // namespace
+
+void interleave(core::Buffer& buffer, const core::Node* caller)
+{
+    switch (buffer.audioConf().codec) {
+    case AudioCodec::RawFloat32:
+        reorder<float, false>(buffer, caller);
+        break;
+    case AudioCodec::RawInt16:
+        reorder<int16_t, false>(buffer, caller);
+        break;
+    case AudioCodec::RawInt32:
+        reorder<int32_t, false>(buffer, caller);
+        break;
+    default:
+        break;
+    }
+}
+
+template <typename T>
+TDeinterleaver<T>::TDeinterleaver()
+{
+    setTailroom(1.0f);
+}
+
+template <typename T>
+const char* TDeinterleaver<T>::name() const
+{
+    return "Deinterleaver";
+}
+
+template <typename T>
+void TDeinterleaver<T>::onProcess(core::BufferPtr& buffer)
+{
+    reorder<T, true>(*buffer, this);
+}
+
+template <typename T>
+TInterleaver<T>::TInterleaver()
+{
+    setTailroom(1.0f);
+}
+
+template <typename T>
+const char* TInterleaver<T>::name() const
+{
+    return "Interleaver";
+}
+
+template <typename T>
+void TInterleaver<T>::onProcess(core::BufferPtr& buffer)
+{
+    reorder<T, false>(*buffer, this);
+}
+
+} // namespace audio
+} // namespace coro
@@ -1,78 +1,116 @@
 #include "audio/Loudness.h"
 
+#include "audio/CoefficientBank.h"
+
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 
 namespace coro
 {
 namespace audio
 {
 
-Loudness::Loudness()
-    : m_tpk1(2, 1),
-      m_tpk2(2, 1),
-      m_ths(2, 1)
+template class TLoudness<float>;
+template class TLoudness<int16_t>;
+template class TLoudness<int32_t>;
+
+namespace {
+
+void applyVolume(float* data, size_t count, float volume)
+{
+    simd::mul(data, data, volume, count);
+}
+
+// Fixed point (Q28), so no float math per sample.
+template <typename T>
+void applyVolume(T* data, size_t count, float volume)
 {
+    const int64_t gain = std::llround(volume * (1 << 28));
+    for (size_t i = 0; i < count; ++i) {
+        const int64_t v = (int64_t(data[i]) * gain + (1 << 27)) >> 28;
+        data[i] = T(std::clamp<int64_t>(v, std::numeric_limits<T>::min(), std::numeric_limits<T>::max()));
+    }
 }
 
-void Loudness::setLevel(uint8_t phon)
+} // namespace
+
+template <typename T>
+TLoudness<T>::TLoudness()
+{
+}
+
+template <typename T>
+void TLoudness<T>::setLevel(uint8_t phon)
 {
     // Filter 1> t: pk, f: 35.5, q: 0.56, g: <phon>/40 * 12db
     // Filter 2> t: pk, f: 100,  q: 0.25, g: <phon>/40 * 9db
     // Filter 3> t: hs, f: 1000, q: 0.8,  g: <phon>/40 * 9db
-    m_tpk1.setFilter({ FilterType::Peak,         35.5f, phon*0.3f,   0.56f });
-    m_tpk2.setFilter({ FilterType::Peak,        100.0f, phon*0.225f, 0.25f });
-    m_ths.setFilter( { FilterType::HighShelf, 10000.0f, phon*0.225f, 0.80f });
+    // Coefficients are computed outside of lock, so the audio thread is not held up.
+    auto filterSet = std::make_shared<const TCoefficientSet<T>>(std::vector<Filter> {
+        { FilterType::Peak,         35.5f, phon*0.3f,   0.56f },
+        { FilterType::Peak,        100.0f, phon*0.225f, 0.25f },
+        { FilterType::HighShelf, 10000.0f, phon*0.225f, 0.80f } });
+    m_mutex.lock();
+    m_cascade.setFilters(std::move(filterSet));
 
     // Headroom generator: <phon> * -0,425 (actually 0,475).
     m_headroom = pow(10, (phon*-0.425)/20.0);
+    m_mutex.unlock();
+    bumpRevision();
 }
 
-void Loudness::setVolume(float volume)
+template <typename T>
+void TLoudness<T>::setVolume(float volume)
 {
     m_volume = volume;
+    bumpRevision();
 }
 
-const char* Loudness::name() const
+template <typename T>
+const char* TLoudness<T>::name() const
 {
     return "Loudness";
 }
 
-audio::AudioConf Loudness::onProcess(const audio::AudioConf& conf, core::Buffer& buffer)
+template <typename T>
+void TLoudness<T>::onProcess(core::BufferPtr& buffer)
 {
+    const auto& conf = buffer->audioConf();
+
     // Loudness generates headroom, check which one is lower
     float volume = std::min(m_volume, m_headroom);
 
     // No volume, no headroom -> no processing.
     if (volume == 1.0f) {
-        return conf;
+        return;
     }
 
     auto channelCount = audio::toInt(conf.channels);
-    auto frameCount = buffer.size()/conf.frameSize();
-    float* data = (float*)buffer.data();
+    auto frameCount = buffer->size()/conf.frameSize();
+    T* data = (T*)buffer->data();
 
-    // Apply volume
-    for (uint32_t i = 0; i < frameCount*audio::toInt(conf.channels); ++i) {
-        data[i] *= volume;
-    }
-
-    // If there is no headroom, we do not have loudness set.
+    // If there is no headroom, we do not have loudness set. Only apply volume.
     if (m_headroom == 1.0f) {
-        return conf;
+        applyVolume(data, frameCount*channelCount, volume);
+        return;
     }
 
     m_mutex.lock();
 
-    m_tpk1.setRate(audio::toInt(conf.rate));
-    m_tpk2.setRate(audio::toInt(conf.rate));
-    m_ths.setRate(audio::toInt(conf.rate));
-    m_tpk1.process((float*)buffer.data(), (float*)buffer.data(), frameCount, channelCount, channelCount);
-    m_tpk2.process((float*)buffer.data(), (float*)buffer.data(), frameCount, channelCount, channelCount);
-    m_ths.process((float*)buffer.data(), (float*)buffer.data(), frameCount,  channelCount, channelCount);
+    m_cascade.setRate(audio::toInt(conf.rate));
+    m_cascade.setChannelCount(channelCount);
+    m_cascade.setGain(volume);
+    if (conf.isPlanar) {
+        m_cascade.processPlanar(data, data, frameCount);
+    } else {
+        m_cascade.process(data, data, frameCount, channelCount, channelCount);
+    }
 
     m_mutex.unlock();
-
-    return conf;
 }
 
 } // namespace audio
@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "audio/Mixer.h"
+
+#include "Simd.h"
+
+#include <loguru/loguru.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace coro {
+namespace audio {
+
+MixerInput::MixerInput(Mixer& mixer) :
+    m_mixer(mixer)
+{
+}
+
+void MixerInput::setGain(float gain)
+{
+    m_gain = gain;
+}
+
+float MixerInput::gain() const
+{
+    return m_gain;
+}
+
+const char* MixerInput::name() const
+{
+    return "MixerInput";
+}
+
+void MixerInput::onStop()
+{
+    m_mixer.stop(*this);
+}
+
+void MixerInput::onProcess(core::BufferPtr& buffer)
+{
+    m_mixer.push(*this, *buffer);
+    buffer->clear();
+}
+
+Mixer::Mixer(size_t inputCount, uint32_t blockFrames) :
+    m_blockFrames(std::max<uint32_t>(blockFrames, 1))
+{
+    for (size_t i = 0; i < inputCount; ++i) {
+        m_inputs.emplace_back(new MixerInput(*this));
+    }
+}
+
+Mixer::~Mixer()
+{
+}
+
+MixerInput& Mixer::input(size_t index)
+{
+    return *m_inputs.at(index);
+}
+
+size_t Mixer::inputCount() const
+{
+    return m_inputs.size();
+}
+
+uint32_t Mixer::blockFrames() const
+{
+    return m_blockFrames;
+}
+
+const char* Mixer::name() const
+{
+    return "Mixer";
+}
+
+void Mixer::push(MixerInput& input, const core::Buffer& buffer)
+{
+    const auto& conf = buffer.audioConf();
+
+    m_mutex.lock();
+
+    // Empty blocks would never fill up
+    if (toInt(conf.channels) == 0 || toInt(conf.rate) == 0) {
+        if (!input.m_isRejected) {
+            LOG_F(WARNING, "%s input format is invalid. rate: %u, channels: %u",
+                  name(), toInt(conf.rate), toInt(conf.channels));
+            input.m_isRejected = true;
+        }
+        m_mutex.unlock();
+        return;
+    }
+
+    // Inputs are summed frame by frame
+    if (conf.isPlanar) {
+        if (!input.m_isRejected) {
+            LOG_F(WARNING, "%s does not take planar buffers", name());
+            input.m_isRejected = true;
+        }
+        m_mutex.unlock();
+        return;
+    }
+
+    // First active input determines output format
+    const bool hasActiveInputs = std::any_of(m_inputs.begin(), m_inputs.end(), [](const auto& i) {
+        return i->m_isActive;
+    });
+    if (!hasActiveInputs) {
+        // Blocks of a previous format, which were not emitted yet, do not fit anymore.
+        if (conf.rate != m_conf.rate || conf.channels != m_conf.channels) {
+            m_pending.clear();
+        }
+        m_conf = conf;
+        m_conf.isRtpPayloaded = false;
+        // Playback resumed before downstream nodes got stopped
+        m_isStopPending = false;
+    } else if (conf.rate != m_conf.rate || conf.channels != m_conf.channels) {
+        if (!input.m_isRejected) {
+            LOG_F(WARNING, "%s input format does not match. rate: %u, channels: %u",
+                  name(), toInt(conf.rate), toInt(conf.channels));
+            input.m_isRejected = true;
+        }
+        m_mutex.unlock();
+        return;
+    }
+    input.m_isRejected = false;
+    input.m_isActive = true;
+
+    // Drop consumed samples and append new ones
+    input.m_samples.erase(input.m_samples.begin(), input.m_samples.begin() + input.m_readPos);
+    input.m_audibleEnd -= std::min(input.m_audibleEnd, input.m_readPos);
+    input.m_readPos = 0;
+    auto samples = reinterpret_cast<const float*>(buffer.constData());
+    const auto sampleCount = buffer.size()/sizeof(float);
+    // Track last audible sample, so silent blocks can be skipped while mixing.
+    for (size_t i = sampleCount; i > 0; --i) {
+        if (samples[i-1] != 0.0f) {
+            input.m_audibleEnd = input.m_samples.size() + i;
+            break;
+        }
+    }
+    input.m_samples.insert(input.m_samples.end(), samples, samples + sampleCount);
+
+    mix();
+
+    m_mutex.unlock();
+
+    emit();
+}
+
+void Mixer::stop(MixerInput& input)
+{
+    m_mutex.lock();
+    input.m_isActive = false;
+    input.m_samples.clear();
+    input.m_readPos = 0;
+    input.m_audibleEnd = 0;
+
+    const bool hasActiveInputs = std::any_of(m_inputs.begin(), m_inputs.end(), [](const auto& i) {
+        return i->m_isActive;
+    });
+    // Last input stopped, so stop downstream nodes as well (after pending blocks).
+    if (!hasActiveInputs) {
+        m_isStopPending = true;
+    }
+    m_mutex.unlock();
+
+    emit();
+}
+
+void Mixer::mix()
+{
+    const size_t blockSamples = m_blockFrames * toInt(m_conf.channels);
+
+    for (;;) {
+        size_t readyCount = 0;
+        size_t pendingCount = 0;
+        size_t maxAvailable = 0;
+        for (const auto& input : m_inputs) {
+            if (!input->m_isActive) {
+                continue;
+            }
+            const auto available = input->m_samples.size() - input->m_readPos;
+            if (available >= blockSamples) {
+                ++readyCount;
+                maxAvailable = std::max(maxAvailable, available);
+            } else {
+                ++pendingCount;
+            }
+        }
+
+        // Wait for pending inputs, unless they fell behind too much.
+        if (!readyCount || (pendingCount && maxAvailable < maxPendingBlocks * blockSamples)) {
+            return;
+        }
+
+        m_pending.resize(m_pending.size() + blockSamples);
+        auto out = m_pending.data() + m_pending.size() - blockSamples;
+        bool isEmpty = true;
+        for (const auto& input : m_inputs) {
+            if (!input->m_isActive) {
+                continue;
+            }
+            // Missing input, skip it until it delivers again.
+            if (input->m_samples.size() - input->m_readPos < blockSamples) {
+                LOG_F(1, "%s input missing", name());
+                input->m_isActive = false;
+                input->m_samples.clear();
+                input->m_readPos = 0;
+                input->m_audibleEnd = 0;
+                continue;
+            }
+
+            const float gain = input->gain();
+            const float* in = input->m_samples.data() + input->m_readPos;
+            const bool isSilent = input->m_readPos >= input->m_audibleEnd;
+            input->m_readPos += blockSamples;
+            if (gain == 0.0f || isSilent) {
+                continue;
+            }
+            if (isEmpty) {
+                simd::mul(out, in, gain, blockSamples);
+                isEmpty = false;
+            } else {
+                simd::mulAdd(out, in, gain, blockSamples);
+            }
+        }
+        if (isEmpty) {
+            std::memset(out, 0, blockSamples * sizeof(float));
+        }
+    }
+}
+
+void Mixer::emit()
+{
+    // Only one thread processes downstream nodes at a time.
+    bool isEmitting = false;
+    while (m_isEmitting.compare_exchange_strong(isEmitting, true, std::memory_order_acquire)) {
+        for (;;) {
+            m_mutex.lock();
+            if (m_pending.empty()) {
+                const bool isStopPending = m_isStopPending;
+                m_isStopPending = false;
+                m_mutex.unlock();
+                if (isStopPending && next()) {
+                    next()->stopChain();
+                }
+                break;
+            }
+
+            const size_t blockSamples = m_blockFrames * toInt(m_conf.channels);
+            const size_t blockBytes = blockSamples * sizeof(float);
+            // Downstream nodes might have taken the buffer and handed back another one.
+            if (!m_output) {
+                m_output = core::Buffer::create(blockBytes, this);
+            }
+            m_output->clear();
+            reserve(*m_output, blockBytes);
+            std::memcpy(m_output->acquire(blockBytes, this), m_pending.data(), blockBytes);
+            m_output->commit(blockBytes);
+            m_output->audioConf() = m_conf;
+            m_pending.erase(m_pending.begin(), m_pending.begin() + blockSamples);
+            m_mutex.unlock();
+
+            if (next()) {
+                next()->process(m_output);
+            }
+        }
+        m_isEmitting.store(false, std::memory_order_release);
+
+        // Another thread might have mixed a block meanwhile and left it to us.
+        m_mutex.lock();
+        const bool hasPending = !m_pending.empty() || m_isStopPending;
+        m_mutex.unlock();
+        if (!hasPending) {
+            return;
+        }
+        isEmitting = false;
+    }
+}
+
+} // namespace audio
+} // namespace coro
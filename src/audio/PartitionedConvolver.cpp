@@ -0,0 +1,449 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/PartitionedConvolver.h"
+
+#include "Simd.h"
+
+#include <kiss_fft.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace coro {
+namespace audio {
+
+// Uniformly partitioned overlap-save convolution of all channels with
+// partitions of blockSize taps. Input and output are planar blocks.
+class PartitionedConvolver::Stage
+{
+public:
+    // Takes taps [offset, offset+length) of each impulse response.
+    Stage(std::size_t blockSize, const std::vector<std::vector<float>>& impulseResponses,
+          std::size_t offset, std::size_t length);
+    ~Stage();
+
+    Stage(const Stage&) = delete;
+    Stage& operator=(const Stage&) = delete;
+
+    // Second half of the input window, blockSize frames
+    float* input(std::size_t channel) {
+        return m_window.data() + channel*m_fftSize + m_blockSize;
+    }
+    const float* output(std::size_t channel) const {
+        return m_output.data() + channel*m_blockSize;
+    }
+
+    std::size_t partitionCount() const {
+        return m_partitionCount;
+    }
+
+    // Steps of process(), so they can be spread across several calls:
+    // transform block in input window, multiply-accumulate next count
+    // partitions and transform result to output.
+    void transformInput();
+    void accumulate(std::size_t count);
+    void transformOutput();
+
+    void process();
+    void reset();
+
+private:
+    void transform(std::size_t channel, const std::vector<float>& taps, std::size_t partition);
+    void accumulate(std::size_t channel, std::size_t from, std::size_t to);
+
+    std::size_t m_blockSize;
+    std::size_t m_fftSize;
+    std::size_t m_binCount;
+    std::size_t m_channelCount;
+    std::size_t m_partitionCount = 1;
+    std::size_t m_fdlPos = 0;
+    // Partitions accumulated since last transformInput()
+    std::size_t m_accumulated = 0;
+
+    kiss_fft_cfg m_fft;
+    kiss_fft_cfg m_ifft;
+
+    // Partitions per channel, trailing silence is skipped
+    std::vector<std::size_t> m_partitions;
+
+    // Previous and current block per channel
+    std::vector<float> m_window;
+    std::vector<float> m_output;
+
+    // Spectra, split into real and imaginary parts, per channel and partition.
+    // Only bins up to fftSize/2 are stored, the rest is symmetric.
+    std::vector<float> m_filterRe;
+    std::vector<float> m_filterIm;
+    std::vector<float> m_fdlRe;
+    std::vector<float> m_fdlIm;
+
+    // Accumulators per channel (rounded up to pairs)
+    std::vector<float> m_accRe;
+    std::vector<float> m_accIm;
+
+    std::vector<kiss_fft_cpx> m_time;
+    std::vector<kiss_fft_cpx> m_freq;
+};
+
+PartitionedConvolver::Stage::Stage(std::size_t blockSize, const std::vector<std::vector<float>>& impulseResponses,
+                                   std::size_t offset, std::size_t length) :
+    m_blockSize(blockSize),
+    m_fftSize(blockSize*2),
+    m_binCount(blockSize+1),
+    m_channelCount(impulseResponses.size()),
+    m_fft(kiss_fft_alloc(m_fftSize, 0, nullptr, nullptr)),
+    m_ifft(kiss_fft_alloc(m_fftSize, 1, nullptr, nullptr)),
+    m_partitions(m_channelCount),
+    m_window(m_channelCount*m_fftSize),
+    m_output(m_channelCount*m_blockSize),
+    m_accRe((m_channelCount+1)/2*2*m_binCount),
+    m_accIm((m_channelCount+1)/2*2*m_binCount),
+    m_time(m_fftSize),
+    m_freq(m_fftSize)
+{
+    std::vector<std::vector<float>> taps(m_channelCount);
+    for (std::size_t ch = 0; ch < m_channelCount; ++ch) {
+        const auto& ir = impulseResponses.at(ch);
+        auto begin = ir.begin() + std::min(offset, ir.size());
+        auto end = ir.begin() + std::min(offset + std::min(length, ir.size()), ir.size());
+        // Trailing silence needs no partitions
+        while (end != begin && *(end-1) == 0.0f) {
+            --end;
+        }
+        taps[ch].assign(begin, end);
+        m_partitions[ch] = (taps[ch].size() + m_blockSize - 1)/m_blockSize;
+        m_partitionCount = std::max(m_partitionCount, m_partitions[ch]);
+    }
+
+    const std::size_t size = m_channelCount*m_partitionCount*m_binCount;
+    m_filterRe.resize(size);
+    m_filterIm.resize(size);
+    m_fdlRe.resize(size);
+    m_fdlIm.resize(size);
+    for (std::size_t ch = 0; ch < m_channelCount; ++ch) {
+        for (std::size_t p = 0; p < m_partitions[ch]; ++p) {
+            transform(ch, taps[ch], p);
+        }
+    }
+}
+
+PartitionedConvolver::Stage::~Stage()
+{
+    kiss_fft_free(m_fft);
+    kiss_fft_free(m_ifft);
+}
+
+void PartitionedConvolver::Stage::transform(std::size_t channel, const std::vector<float>& taps, std::size_t partition)
+{
+    std::fill(m_time.begin(), m_time.end(), kiss_fft_cpx { 0.0f, 0.0f });
+    const std::size_t begin = partition*m_blockSize;
+    const std::size_t end = std::min(begin + m_blockSize, taps.size());
+    for (std::size_t i = begin; i < end; ++i) {
+        m_time[i-begin].r = taps[i];
+    }
+    kiss_fft(m_fft, m_time.data(), m_freq.data());
+
+    // Inverse FFT is not normalized and separation of channel pairs
+    // doubles the spectra. Both is compensated here.
+    const float scale = 0.5f/m_fftSize;
+    const std::size_t index = (channel*m_partitionCount + partition)*m_binCount;
+    for (std::size_t k = 0; k < m_binCount; ++k) {
+        m_filterRe[index+k] = m_freq[k].r*scale;
+        m_filterIm[index+k] = m_freq[k].i*scale;
+    }
+}
+
+void PartitionedConvolver::Stage::accumulate(std::size_t channel, std::size_t from, std::size_t to)
+{
+    // Partition p runs on spectrum of p blocks ago
+    const std::size_t bins = m_binCount;
+    float* accRe = m_accRe.data() + channel*bins;
+    float* accIm = m_accIm.data() + channel*bins;
+    for (std::size_t p = from; p < std::min(to, m_partitions[channel]); ++p) {
+        const std::size_t slot = (channel*m_partitionCount + (m_fdlPos + m_partitionCount - p) % m_partitionCount)*bins;
+        const std::size_t filter = (channel*m_partitionCount + p)*bins;
+        simd::complexMulAdd(accRe, accIm, m_fdlRe.data() + slot, m_fdlIm.data() + slot,
+                            m_filterRe.data() + filter, m_filterIm.data() + filter, bins);
+    }
+}
+
+void PartitionedConvolver::Stage::accumulate(std::size_t count)
+{
+    const std::size_t to = std::min(m_accumulated + count, m_partitionCount);
+    for (std::size_t ch = 0; ch < m_channelCount; ++ch) {
+        accumulate(ch, m_accumulated, to);
+    }
+    m_accumulated = to;
+}
+
+void PartitionedConvolver::Stage::transformInput()
+{
+    const std::size_t n = m_fftSize;
+    const std::size_t bins = m_binCount;
+
+    for (std::size_t a = 0; a < m_channelCount; a += 2) {
+        const std::size_t b = a+1;
+        const bool hasB = b < m_channelCount;
+
+        // Channel a is real part, channel b imaginary part
+        const float* wa = m_window.data() + a*n;
+        for (std::size_t i = 0; i < n; ++i) {
+            m_time[i].r = wa[i];
+            m_time[i].i = hasB ? wa[n+i] : 0.0f;
+        }
+        kiss_fft(m_fft, m_time.data(), m_freq.data());
+
+        // Separate spectra: A = Z(k) + conj(Z(n-k)), B = -i * (Z(k) - conj(Z(n-k)))
+        const std::size_t slotA = (a*m_partitionCount + m_fdlPos)*bins;
+        const std::size_t slotB = (b*m_partitionCount + m_fdlPos)*bins;
+        for (std::size_t k = 0; k < bins; ++k) {
+            const auto& z = m_freq[k];
+            const auto& zc = m_freq[k ? n-k : 0];
+            m_fdlRe[slotA+k] = z.r + zc.r;
+            m_fdlIm[slotA+k] = z.i - zc.i;
+            if (hasB) {
+                m_fdlRe[slotB+k] = z.i + zc.i;
+                m_fdlIm[slotB+k] = zc.r - z.r;
+            }
+        }
+    }
+
+    for (std::size_t ch = 0; ch < m_channelCount; ++ch) {
+        float* w = m_window.data() + ch*n;
+        std::memcpy(w, w + m_blockSize, m_blockSize*sizeof(float));
+    }
+}
+
+void PartitionedConvolver::Stage::transformOutput()
+{
+    const std::size_t n = m_fftSize;
+    const std::size_t bins = m_binCount;
+
+    // Partitions not accumulated yet
+    accumulate(m_partitionCount);
+
+    for (std::size_t a = 0; a < m_channelCount; a += 2) {
+        const bool hasB = a+1 < m_channelCount;
+
+        // Combine both (real) results to one spectrum: Z = A + i*B
+        float* aRe = m_accRe.data() + a*bins;
+        float* aIm = m_accIm.data() + a*bins;
+        const float* bRe = aRe + bins;
+        const float* bIm = aIm + bins;
+        for (std::size_t k = 0; k < bins; ++k) {
+            m_freq[k] = { aRe[k] - bIm[k], aIm[k] + bRe[k] };
+        }
+        for (std::size_t k = bins; k < n; ++k) {
+            const std::size_t m = n-k;
+            m_freq[k] = { aRe[m] + bIm[m], bRe[m] - aIm[m] };
+        }
+        kiss_fft(m_ifft, m_freq.data(), m_time.data());
+        // Accumulators start over for next block
+        std::fill(aRe, aRe + 2*bins, 0.0f);
+        std::fill(aIm, aIm + 2*bins, 0.0f);
+
+        // Second half is valid (overlap-save)
+        float* oa = m_output.data() + a*m_blockSize;
+        for (std::size_t i = 0; i < m_blockSize; ++i) {
+            oa[i] = m_time[m_blockSize+i].r;
+        }
+        if (hasB) {
+            float* ob = oa + m_blockSize;
+            for (std::size_t i = 0; i < m_blockSize; ++i) {
+                ob[i] = m_time[m_blockSize+i].i;
+            }
+        }
+    }
+
+    m_fdlPos = (m_fdlPos + 1) % m_partitionCount;
+    m_accumulated = 0;
+}
+
+void PartitionedConvolver::Stage::process()
+{
+    transformInput();
+    transformOutput();
+}
+
+void PartitionedConvolver::Stage::reset()
+{
+    std::fill(m_window.begin(), m_window.end(), 0.0f);
+    std::fill(m_output.begin(), m_output.end(), 0.0f);
+    std::fill(m_fdlRe.begin(), m_fdlRe.end(), 0.0f);
+    std::fill(m_fdlIm.begin(), m_fdlIm.end(), 0.0f);
+    std::fill(m_accRe.begin(), m_accRe.end(), 0.0f);
+    std::fill(m_accIm.begin(), m_accIm.end(), 0.0f);
+    m_fdlPos = 0;
+    m_accumulated = 0;
+}
+
+PartitionedConvolver::PartitionedConvolver(std::size_t blockSize, std::size_t tailBlockSize) :
+    m_blockSize(std::max(blockSize, std::size_t(1))),
+    m_tailBlockSize(tailBlockSize > m_blockSize ? tailBlockSize - tailBlockSize % m_blockSize : 0)
+{
+}
+
+PartitionedConvolver::~PartitionedConvolver()
+{
+}
+
+void PartitionedConvolver::setImpulseResponses(const std::vector<std::vector<float>>& impulseResponses)
+{
+    m_channelCount = impulseResponses.size();
+    m_head.reset();
+    m_tail.reset();
+    if (m_channelCount) {
+        m_head = std::make_unique<Stage>(m_blockSize, impulseResponses, 0, m_tailBlockSize ? 2*m_tailBlockSize : SIZE_MAX);
+    }
+    const bool hasTail = std::any_of(impulseResponses.begin(), impulseResponses.end(), [this](const auto& ir) {
+        return ir.size() > 2*m_tailBlockSize;
+    });
+    if (m_tailBlockSize && hasTail) {
+        m_tail = std::make_unique<Stage>(m_tailBlockSize, impulseResponses, 2*m_tailBlockSize, SIZE_MAX);
+    }
+
+    m_input.assign(m_channelCount*m_blockSize, 0.0f);
+    m_output.assign(m_channelCount*m_blockSize, 0.0f);
+    m_pos = 0;
+    m_tailPos = 0;
+}
+
+std::size_t PartitionedConvolver::channelCount() const
+{
+    return m_channelCount;
+}
+
+std::size_t PartitionedConvolver::blockSize() const
+{
+    return m_blockSize;
+}
+
+std::size_t PartitionedConvolver::tailBlockSize() const
+{
+    return m_tailBlockSize;
+}
+
+std::size_t PartitionedConvolver::latency() const
+{
+    return m_blockSize;
+}
+
+void PartitionedConvolver::reset()
+{
+    if (m_head) {
+        m_head->reset();
+    }
+    if (m_tail) {
+        m_tail->reset();
+    }
+    std::fill(m_input.begin(), m_input.end(), 0.0f);
+    std::fill(m_output.begin(), m_output.end(), 0.0f);
+    m_pos = 0;
+    m_tailPos = 0;
+}
+
+void PartitionedConvolver::process(const float* in, float* out, uint32_t frameCount)
+{
+    const std::size_t channelCount = m_channelCount;
+    while (frameCount) {
+        const std::size_t n = std::min<std::size_t>(m_blockSize - m_pos, frameCount);
+        // Input is read before output is written, so in and out might be the same.
+        for (std::size_t ch = 0; ch < channelCount; ++ch) {
+            float* input = m_input.data() + ch*m_blockSize + m_pos;
+            for (std::size_t i = 0; i < n; ++i) {
+                input[i] = in[i*channelCount + ch];
+            }
+        }
+        for (std::size_t ch = 0; ch < channelCount; ++ch) {
+            const float* output = m_output.data() + ch*m_blockSize + m_pos;
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i*channelCount + ch] = output[i];
+            }
+        }
+        in += n*channelCount;
+        out += n*channelCount;
+        frameCount -= n;
+        m_pos += n;
+
+        if (m_pos == m_blockSize) {
+            processBlock();
+            m_pos = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::processPlanar(const float* in, float* out, uint32_t frameCount)
+{
+    const std::size_t channelCount = m_channelCount;
+    std::size_t offset = 0;
+    while (offset < frameCount) {
+        const std::size_t n = std::min<std::size_t>(m_blockSize - m_pos, frameCount - offset);
+        // Input is read before output is written, so in and out might be the same.
+        for (std::size_t ch = 0; ch < channelCount; ++ch) {
+            std::memcpy(m_input.data() + ch*m_blockSize + m_pos, in + ch*frameCount + offset, n*sizeof(float));
+        }
+        for (std::size_t ch = 0; ch < channelCount; ++ch) {
+            std::memcpy(out + ch*frameCount + offset, m_output.data() + ch*m_blockSize + m_pos, n*sizeof(float));
+        }
+        offset += n;
+        m_pos += n;
+
+        if (m_pos == m_blockSize) {
+            processBlock();
+            m_pos = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::processBlock()
+{
+    for (std::size_t ch = 0; ch < m_channelCount; ++ch) {
+        std::memcpy(m_head->input(ch), m_input.data() + ch*m_blockSize, m_blockSize*sizeof(float));
+    }
+    m_head->process();
+    for (std::size_t ch = 0; ch < m_channelCount; ++ch) {
+        std::memcpy(m_output.data() + ch*m_blockSize, m_head->output(ch), m_blockSize*sizeof(float));
+    }
+
+    if (!m_tail) {
+        return;
+    }
+
+    // Tail starts at tap 2*tailBlockSize, so its output is due one tail block
+    // after its input completed. Its work is spread across the blocks of that
+    // tail block: input transform first, partitions in between, output
+    // transform last (after the previous output was read).
+    const std::size_t blockCount = m_tailBlockSize/m_blockSize;
+    const std::size_t index = m_tailPos/m_blockSize;
+    if (index == 0) {
+        m_tail->transformInput();
+    }
+    for (std::size_t ch = 0; ch < m_channelCount; ++ch) {
+        std::memcpy(m_tail->input(ch) + m_tailPos, m_input.data() + ch*m_blockSize, m_blockSize*sizeof(float));
+        simd::mulAdd(m_output.data() + ch*m_blockSize, m_tail->output(ch) + m_tailPos, 1.0f, m_blockSize);
+    }
+    if (index == blockCount - 1) {
+        m_tail->transformOutput();
+    } else {
+        m_tail->accumulate((m_tail->partitionCount() + blockCount - 2)/(blockCount - 1));
+    }
+    m_tailPos = (m_tailPos + m_blockSize) % m_tailBlockSize;
+}
+
+} // namespace audio
+} // namespace coro
@@ -5,55 +5,72 @@
 namespace coro {
 namespace audio {
 
-Peq::Peq()
+template class TPeq<float>;
+template class TPeq<int16_t>;
+template class TPeq<int32_t>;
+
+template <typename T>
+TPeq<T>::TPeq()
 {
 }
 
-void Peq::setVolume(float volume)
+template <typename T>
+void TPeq<T>::setVolume(float volume)
 {
     m_volume = volume;
+    bumpRevision();
 }
 
-void Peq::setFilters(const std::vector<Filter> filters)
+template <typename T>
+void TPeq<T>::setFilters(const std::vector<Filter> filters)
 {
+    // Coefficients are computed outside of lock, so the audio thread is not held up.
+    auto filterSet = std::make_shared<const TCoefficientSet<T>>(filters);
     m_mutex.lock();
-    m_tBiquads.resize(filters.size(), TBiquad<float, float>(2, 1, toInt(m_conf.rate)));
-    for (size_t i = 0; i < filters.size(); ++i) {
-        m_tBiquads.at(i).setFilter(filters.at(i));
-    }
+    m_cascade.setFilters(std::move(filterSet));
     m_mutex.unlock();
+    bumpRevision();
 }
 
-std::vector<Filter> Peq::filters()
+template <typename T>
+std::vector<Filter> TPeq<T>::filters()
 {
     m_mutex.lock();
-    std::vector<Filter> filters;
-    filters.reserve(m_tBiquads.size());
-    for (const auto& biquad : m_tBiquads) {
-        filters.push_back(biquad.m_filter);
-    }
+    const auto filters = m_cascade.filters();
     m_mutex.unlock();
 
     return filters;
 }
 
-const char* Peq::name() const
+template <typename T>
+void TPeq<T>::setPreset(std::shared_ptr<const TCoefficientSet<T>> preset)
+{
+    m_cascade.setPreset(std::move(preset));
+    bumpRevision();
+}
+
+template <typename T>
+const char* TPeq<T>::name() const
 {
     return "PEQ";
 }
 
-audio::AudioConf Peq::onProcess(const audio::AudioConf& conf, core::Buffer& buffer)
+template <typename T>
+void TPeq<T>::onProcess(core::BufferPtr& buffer)
 {
-    uint frameCount = buffer.size()/conf.frameSize();
+    const auto& conf = buffer->audioConf();
+    uint frameCount = buffer->size()/conf.frameSize();
     m_mutex.lock();
     m_conf = conf;
-    for (auto& biquad : m_tBiquads) {
-        biquad.setRate(toInt(conf.rate));
-        biquad.process((float*)buffer.data(), (float*)buffer.data(), frameCount, audio::toInt(conf.channels), audio::toInt(conf.channels));
+    m_cascade.setRate(toInt(conf.rate));
+    m_cascade.setChannelCount(audio::toInt(conf.channels));
+    // All bands run fused, so the buffer is streamed through cache once.
+    if (conf.isPlanar) {
+        m_cascade.processPlanar((T*)buffer->data(), (T*)buffer->data(), frameCount);
+    } else {
+        m_cascade.process((T*)buffer->data(), (T*)buffer->data(), frameCount, audio::toInt(conf.channels), audio::toInt(conf.channels));
     }
     m_mutex.unlock();
-
-    return conf;
 }
 
 } // namespace audio
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/PolyphaseResampler.h"
+
+#include "Simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace coro {
+namespace audio {
+
+namespace {
+
+// Half taps at ratio 1:1, scaled up for downsampling
+constexpr std::size_t baseHalfTapCount = 64;
+// Cutoff relative to Nyquist of the lower rate
+constexpr double cutoff = 0.95;
+// Kaiser window, about 80 dB stopband attenuation
+constexpr double kaiserBeta = 8.0;
+
+// Modified Bessel function of first kind, order 0
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; term > 1e-12 * sum; ++k) {
+        term *= (x / (2.0*k)) * (x / (2.0*k));
+        sum += term;
+    }
+    return sum;
+}
+
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler(uint32_t inRate, uint32_t outRate, uint8_t channelCount) :
+    m_inRate(inRate),
+    m_outRate(outRate),
+    m_channelCount(channelCount)
+{
+    update();
+}
+
+void PolyphaseResampler::setRates(uint32_t inRate, uint32_t outRate)
+{
+    if (m_inRate == inRate && m_outRate == outRate) {
+        return;
+    }
+
+    m_inRate = inRate;
+    m_outRate = outRate;
+    update();
+}
+
+uint32_t PolyphaseResampler::inRate() const
+{
+    return m_inRate;
+}
+
+uint32_t PolyphaseResampler::outRate() const
+{
+    return m_outRate;
+}
+
+void PolyphaseResampler::setChannelCount(uint8_t channelCount)
+{
+    if (m_channelCount == channelCount) {
+        return;
+    }
+
+    m_channelCount = channelCount;
+    reset();
+}
+
+uint8_t PolyphaseResampler::channelCount() const
+{
+    return m_channelCount;
+}
+
+std::size_t PolyphaseResampler::tapCount() const
+{
+    return m_tapCount;
+}
+
+uint32_t PolyphaseResampler::latency() const
+{
+    // Look-ahead of second half of window
+    return m_tapCount/2 + 1;
+}
+
+uint32_t PolyphaseResampler::maxOutputFrames(uint32_t frameCount) const
+{
+    if (m_inRate == m_outRate) {
+        return frameCount;
+    }
+
+    // Less than tapCount frames are left over from previous call
+    return uint64_t(frameCount) * m_up / m_down + 1;
+}
+
+void PolyphaseResampler::reset()
+{
+    // Leading silence, so first output is centered on first input frame
+    m_historySize = m_tapCount/2 - 1;
+    m_stride = std::max(m_stride, m_tapCount);
+    m_history.assign(m_channelCount*m_stride, 0.0f);
+    m_pos = 0;
+    m_phase = 0;
+}
+
+uint32_t PolyphaseResampler::process(const float* in, uint32_t frameCount, float* out)
+{
+    const std::size_t channelCount = m_channelCount;
+    if (m_inRate == m_outRate) {
+        std::memcpy(out, in, frameCount*channelCount*sizeof(float));
+        return frameCount;
+    }
+
+    // Grow history (only if needed, to not allocate in steady state)
+    if (m_historySize + frameCount > m_stride) {
+        const std::size_t stride = m_historySize + frameCount;
+        std::vector<float> history(channelCount*stride);
+        for (std::size_t ch = 0; ch < channelCount; ++ch) {
+            std::memcpy(history.data() + ch*stride, m_history.data() + ch*m_stride, m_historySize*sizeof(float));
+        }
+        m_history.swap(history);
+        m_stride = stride;
+    }
+
+    for (std::size_t ch = 0; ch < channelCount; ++ch) {
+        float* history = m_history.data() + ch*m_stride + m_historySize;
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            history[i] = in[i*channelCount + ch];
+        }
+    }
+    m_historySize += frameCount;
+
+    uint32_t outCount = 0;
+    while (m_pos + m_tapCount <= m_historySize) {
+        const float* coeffs = m_bank.data() + m_phase*m_tapCount;
+        for (std::size_t ch = 0; ch < channelCount; ++ch) {
+            *out++ = simd::dotProduct(coeffs, m_history.data() + ch*m_stride + m_pos, m_tapCount);
+        }
+        ++outCount;
+        m_phase += m_down;
+        m_pos += m_phase / m_up;
+        m_phase %= m_up;
+    }
+
+    // Keep frames, which are still needed
+    const std::size_t consumed = std::min(m_pos, m_historySize);
+    for (std::size_t ch = 0; ch < channelCount; ++ch) {
+        float* history = m_history.data() + ch*m_stride;
+        std::memmove(history, history + consumed, (m_historySize - consumed)*sizeof(float));
+    }
+    m_historySize -= consumed;
+    m_pos -= consumed;
+
+    return outCount;
+}
+
+void PolyphaseResampler::update()
+{
+    const uint32_t divisor = std::gcd(m_inRate, m_outRate);
+    m_up = divisor ? m_outRate/divisor : 1;
+    m_down = divisor ? m_inRate/divisor : 1;
+
+    // Filter runs at input rate, scaled by the lower of both rates.
+    const double scale = std::min(1.0, double(m_up)/m_down);
+    const std::size_t halfTapCount = (std::size_t(std::ceil(baseHalfTapCount/scale)) + 3) & ~std::size_t(3);
+    m_tapCount = 2*halfTapCount;
+
+    const double fc = 0.5*cutoff*scale;
+    const double i0Beta = besselI0(kaiserBeta);
+    m_bank.resize(m_up*m_tapCount);
+    for (uint32_t p = 0; p < m_up; ++p) {
+        const double fraction = double(p)/m_up;
+        float* coeffs = m_bank.data() + p*m_tapCount;
+        double sum = 0.0;
+        for (std::size_t t = 0; t < m_tapCount; ++t) {
+            // Distance of tap t to output position in input frames
+            const double x = fraction + halfTapCount - 1 - t;
+            const double r = x/halfTapCount;
+            const double window = std::fabs(r) < 1.0 ? besselI0(kaiserBeta*std::sqrt(1.0 - r*r))/i0Beta : 0.0;
+            const double sinc = x == 0.0 ? 1.0 : std::sin(2.0*M_PI*fc*x)/(2.0*M_PI*fc*x);
+            const double h = 2.0*fc*sinc*window;
+            coeffs[t] = h;
+            sum += h;
+        }
+        // Unity gain at DC for each phase
+        for (std::size_t t = 0; t < m_tapCount; ++t) {
+            coeffs[t] /= sum;
+        }
+    }
+
+    reset();
+}
+
+} // namespace audio
+} // namespace coro
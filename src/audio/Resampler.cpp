@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "audio/Resampler.h"
+
+namespace coro {
+namespace audio {
+
+Resampler::Resampler(SampleRate rate) :
+    m_rate(rate),
+    m_resampler(toInt(rate), toInt(rate))
+{
+}
+
+void Resampler::setRate(SampleRate rate)
+{
+    m_mutex.lock();
+    m_rate = rate;
+    m_mutex.unlock();
+}
+
+SampleRate Resampler::rate() const
+{
+    m_mutex.lock();
+    const auto rate = m_rate;
+    m_mutex.unlock();
+
+    return rate;
+}
+
+const char* Resampler::name() const
+{
+    return "Resampler";
+}
+
+void Resampler::onProcess(core::BufferPtr& buffer)
+{
+    auto& conf = buffer->audioConf();
+    m_mutex.lock();
+    if (conf.rate == m_rate || !rates().testFlag(conf.rate) || conf.isPlanar) {
+        m_mutex.unlock();
+        return;
+    }
+
+    if (m_resampler.inRate() != toInt(conf.rate) || m_resampler.outRate() != toInt(m_rate)) {
+        m_resampler.setRates(toInt(conf.rate), toInt(m_rate));
+        // Resampled frames are written behind the incoming ones.
+        setTailroom(float(toInt(m_rate))/toInt(conf.rate));
+    }
+    m_resampler.setChannelCount(toInt(conf.channels));
+
+    const uint32_t frameCount = buffer->size()/conf.frameSize();
+    float* out = (float*)buffer->acquire(m_resampler.maxOutputFrames(frameCount)*conf.frameSize(), this);
+    const float* in = (const float*)buffer->data();
+    const uint32_t outCount = m_resampler.process(in, frameCount, out);
+    buffer->commit(outCount*conf.frameSize());
+    conf.rate = m_rate;
+    m_mutex.unlock();
+}
+
+} // namespace audio
+} // namespace coro
@@ -60,8 +60,8 @@ public:
 
 ScreamSource::ScreamSource()
     : core::UdpSource( { 4010,
-                       3, // 3 padding,
-                       5+(1152*7), // 5 header, 1152 payload, +2*payload (int to float), +2*2*payload (float to crossover
+                       core::Buffer::alignment-5, // align payload behind 5 byte header
+                       1492, // 5 header, 1152 payload (conversions are covered by tailroom of downstream nodes)
                        boost::asio::ip::address_v4::from_string("239.255.77.77").to_uint() } )
 {
 }
@@ -70,25 +70,25 @@ ScreamSource::~ScreamSource()
 {
 }
 
-AudioConf ScreamSource::onProcess(const AudioConf&, core::Buffer& buffer)
+void ScreamSource::onProcess(core::BufferPtr& buffer)
 {
-    if (buffer.size() != (5+1152)) {
-        LOG_F(ERROR, "invalid bytes count: %zu", buffer.size());
-        buffer.clear();
-        return {};
+    if (buffer->size() != (5+1152)) {
+        LOG_F(ERROR, "invalid bytes count: %zu", buffer->size());
+        buffer->clear();
+        return;
     }
 
-    auto header = (ScreamHeader*)(buffer.data());
+    auto header = (const ScreamHeader*)(buffer->constData());
     if (!header->isValid()) {
         LOG_F(ERROR, "invalid scream header: we only support 44.1/48 khz, S16, Stereo");
-        buffer.clear();
-        return {};
+        buffer->clear();
+        return;
     }
 
-    buffer.trimFront(header->size());
-    return { audio::AudioCodec::RawInt16,
-                header->baseRate ? SampleRate::Rate44100 : SampleRate::Rate48000,
-                audio::Channels::Stereo };
+    buffer->audioConf() = { audio::AudioCodec::RawInt16,
+                            header->baseRate ? SampleRate::Rate44100 : SampleRate::Rate48000,
+                            audio::Channels::Stereo };
+    buffer->trimFront(header->size());
 }
 
 const char* ScreamSource::name() const
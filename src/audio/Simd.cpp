@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Simd.h"
+
+#include <cstring>
+
+namespace coro {
+namespace audio {
+namespace simd {
+
+namespace {
+
+template <size_t N>
+struct Lanes {
+    typedef float Vec __attribute__((vector_size(N*sizeof(float))));
+};
+
+template <>
+struct Lanes<1> {
+    typedef float Vec;
+};
+
+// Load/store M lanes of a vector, remaining lanes are zero.
+template <size_t M, typename Vec>
+__attribute__((always_inline)) inline void load(Vec& v, const float* p)
+{
+    if constexpr (M*sizeof(float) < sizeof(Vec)) {
+        v = Vec {};
+        for (size_t i = 0; i < M; ++i) {
+            v[i] = p[i];
+        }
+    } else {
+        std::memcpy(&v, p, sizeof(Vec));
+    }
+}
+
+template <size_t M, typename Vec>
+__attribute__((always_inline)) inline void store(float* p, const Vec& v)
+{
+    if constexpr (M*sizeof(float) < sizeof(Vec)) {
+        for (size_t i = 0; i < M; ++i) {
+            p[i] = v[i];
+        }
+    } else {
+        std::memcpy(p, &v, sizeof(Vec));
+    }
+}
+
+// Runs M channels in N lanes through all sections, frame by frame. Written with
+// vector extensions, so the same code compiles to AVX2, SSE2 or NEON.
+// Operation order matches TBiquad and no FMA is used.
+//
+// Sections share state: y1/y2 of a section is x1/x2 of the next one. So,
+// history holds sectionCount+1 taps, each with z1 and z2.
+//
+// With a fixed section count S (> 0) the state is kept in registers.
+// Offset (against denormals) is only added, if O is set.
+template <size_t N, size_t M, size_t S, bool O>
+__attribute__((always_inline)) inline void cascade(const float* in, float* out, uint32_t frameCount,
+                                                   size_t inSpacing, size_t outSpacing,
+                                                   const float* c, size_t _sectionCount,
+                                                   float* history, size_t stride, float offset)
+{
+    using Vec = typename Lanes<N>::Vec;
+
+    const size_t sectionCount = S ? S : _sectionCount;
+    Vec z[2*((S ? S : maxCascadeSections)+1)];
+    for (size_t i = 0; i < 2*(sectionCount+1); ++i) {
+        load<M>(z[i], history + i*stride);
+    }
+
+    for (uint32_t i = 0; i < frameCount; ++i) {
+        Vec x;
+        load<M>(x, in);
+        for (size_t s = 0; s < sectionCount; ++s) {
+            const float* cs = c + s*5;
+            Vec* zs = z + s*2;
+            Vec acc = cs[0]*x;
+            if constexpr (O) {
+                acc += offset;
+            }
+            acc += cs[1]*zs[0];
+            acc += cs[2]*zs[1];
+            acc -= cs[3]*zs[2];
+            acc -= cs[4]*zs[3];
+            zs[1] = zs[0];
+            zs[0] = x;
+            x = acc;
+        }
+        z[2*sectionCount+1] = z[2*sectionCount];
+        z[2*sectionCount] = x;
+        store<M>(out, x);
+        in += inSpacing;
+        out += outSpacing;
+    }
+
+    for (size_t i = 0; i < 2*(sectionCount+1); ++i) {
+        store<M>(history + i*stride, z[i]);
+    }
+}
+
+template <size_t N, size_t M, bool O>
+__attribute__((always_inline)) inline void cascade(const float* in, float* out, uint32_t frameCount,
+                                                   size_t inSpacing, size_t outSpacing,
+                                                   const float* c, size_t sectionCount,
+                                                   float* history, size_t stride, float offset)
+{
+    // Single biquads and Linkwitz-Riley crossovers are common.
+    switch (sectionCount) {
+    case 1:
+        cascade<N, M, 1, O>(in, out, frameCount, inSpacing, outSpacing, c, 1, history, stride, offset);
+        break;
+    case 2:
+        cascade<N, M, 2, O>(in, out, frameCount, inSpacing, outSpacing, c, 2, history, stride, offset);
+        break;
+    default:
+        cascade<N, M, 0, O>(in, out, frameCount, inSpacing, outSpacing, c, sectionCount, history, stride, offset);
+        break;
+    }
+}
+
+template <size_t N, size_t M = N>
+__attribute__((always_inline)) inline void cascade(const float* in, float* out, uint32_t frameCount,
+                                                   size_t inSpacing, size_t outSpacing,
+                                                   const float* c, size_t sectionCount,
+                                                   float* history, size_t stride, float offset)
+{
+    if (offset == 0.0f) {
+        cascade<N, M, false>(in, out, frameCount, inSpacing, outSpacing, c, sectionCount, history, stride, offset);
+    } else {
+        cascade<N, M, true>(in, out, frameCount, inSpacing, outSpacing, c, sectionCount, history, stride, offset);
+    }
+}
+
+template <size_t N>
+__attribute__((always_inline)) inline size_t complexMulAdd(float* accRe, float* accIm, const float* xRe, const float* xIm,
+                                                           const float* hRe, const float* hIm, size_t count)
+{
+    using Vec = typename Lanes<N>::Vec;
+
+    size_t i = 0;
+    for (; i + N <= count; i += N) {
+        Vec ar, ai, xr, xi, hr, hi;
+        load<N>(ar, accRe+i);
+        load<N>(ai, accIm+i);
+        load<N>(xr, xRe+i);
+        load<N>(xi, xIm+i);
+        load<N>(hr, hRe+i);
+        load<N>(hi, hIm+i);
+        ar += xr*hr - xi*hi;
+        ai += xr*hi + xi*hr;
+        store<N>(accRe+i, ar);
+        store<N>(accIm+i, ai);
+    }
+    return i;
+}
+
+// Returns number of processed products, sum is added to acc.
+template <size_t N>
+__attribute__((always_inline)) inline size_t dotProduct(const float* a, const float* b, size_t count, float& acc)
+{
+    using Vec = typename Lanes<N>::Vec;
+
+    Vec sum {};
+    size_t i = 0;
+    for (; i + N <= count; i += N) {
+        Vec va, vb;
+        load<N>(va, a+i);
+        load<N>(vb, b+i);
+        sum += va*vb;
+    }
+    for (size_t j = 0; j < N; ++j) {
+        acc += sum[j];
+    }
+    return i;
+}
+
+// Like cascade(), but each lane has its own coefficients and mixes its input
+// from all input channels. Coefficients are loaded per frame from L1, state
+// is kept in registers.
+template <size_t N, size_t M, bool O>
+__attribute__((always_inline)) inline void lanes(const float* in, float* out, uint32_t frameCount,
+                                                 size_t inChannelCount, size_t laneCount,
+                                                 const float* mix, const float* c, size_t sectionCount,
+                                                 float* history, size_t stride, float offset)
+{
+    using Vec = typename Lanes<N>::Vec;
+
+    Vec m[maxLaneInputs];
+    for (size_t i = 0; i < inChannelCount; ++i) {
+        load<M>(m[i], mix + i*stride);
+    }
+    Vec z[2*(maxLaneSections+1)];
+    for (size_t i = 0; i < 2*(sectionCount+1); ++i) {
+        load<M>(z[i], history + i*stride);
+    }
+
+    for (uint32_t i = 0; i < frameCount; ++i) {
+        Vec x = m[0]*in[0];
+        if (inChannelCount > 1) {
+            x += m[1]*in[1];
+        }
+        for (size_t s = 0; s < sectionCount; ++s) {
+            const float* cs = c + s*5*stride;
+            Vec* zs = z + s*2;
+            Vec c0, c1, c2, c3, c4;
+            load<M>(c0, cs);
+            load<M>(c1, cs + stride);
+            load<M>(c2, cs + 2*stride);
+            load<M>(c3, cs + 3*stride);
+            load<M>(c4, cs + 4*stride);
+            Vec acc = c0*x;
+            if constexpr (O) {
+                acc += offset;
+            }
+            acc += c1*zs[0];
+            acc += c2*zs[1];
+            acc -= c3*zs[2];
+            acc -= c4*zs[3];
+            zs[1] = zs[0];
+            zs[0] = x;
+            x = acc;
+        }
+        z[2*sectionCount+1] = z[2*sectionCount];
+        z[2*sectionCount] = x;
+        store<M>(out, x);
+        in += inChannelCount;
+        out += laneCount;
+    }
+
+    for (size_t i = 0; i < 2*(sectionCount+1); ++i) {
+        store<M>(history + i*stride, z[i]);
+    }
+}
+
+template <size_t N, size_t M = N>
+__attribute__((always_inline)) inline void lanes(const float* in, float* out, uint32_t frameCount,
+                                                 size_t inChannelCount, size_t laneCount,
+                                                 const float* mix, const float* c, size_t sectionCount,
+                                                 float* history, size_t stride, float offset)
+{
+    if (offset == 0.0f) {
+        lanes<N, M, false>(in, out, frameCount, inChannelCount, laneCount, mix, c, sectionCount, history, stride, offset);
+    } else {
+        lanes<N, M, true>(in, out, frameCount, inChannelCount, laneCount, mix, c, sectionCount, history, stride, offset);
+    }
+}
+
+#define CORO_SIMD_LANES(...) \
+    lanes<__VA_ARGS__>(in, out+lane, frameCount, inChannelCount, laneCount, mix+lane, coeffs+lane, sectionCount, history+lane, stride, offset)
+
+#define CORO_SIMD_CASCADE(...) \
+    cascade<__VA_ARGS__>(in+ch, out+ch, frameCount, inSpacing, outSpacing, coeffs, sectionCount, history+ch, stride, offset)
+
+#if defined(__x86_64__) || defined(__i386__)
+// Returns number of processed channels
+__attribute__((target("avx2")))
+size_t cascadeAvx2(const float* in, float* out, uint32_t frameCount, size_t channelCount,
+                   size_t inSpacing, size_t outSpacing,
+                   const float* coeffs, size_t sectionCount, float* history, size_t stride, float offset)
+{
+    size_t ch = 0;
+    for (; ch + 8 <= channelCount; ch += 8) {
+        CORO_SIMD_CASCADE(8);
+    }
+    return ch;
+}
+
+__attribute__((target("avx2")))
+size_t complexMulAddAvx2(float* accRe, float* accIm, const float* xRe, const float* xIm,
+                         const float* hRe, const float* hIm, size_t count)
+{
+    return complexMulAdd<8>(accRe, accIm, xRe, xIm, hRe, hIm, count);
+}
+
+__attribute__((target("avx2")))
+size_t dotProductAvx2(const float* a, const float* b, size_t count, float& acc)
+{
+    return dotProduct<8>(a, b, count, acc);
+}
+
+// Returns number of processed lanes
+__attribute__((target("avx2")))
+size_t lanesAvx2(const float* in, float* out, uint32_t frameCount, size_t inChannelCount, size_t laneCount,
+                 const float* mix, const float* coeffs, size_t sectionCount, float* history, size_t stride, float offset)
+{
+    size_t lane = 0;
+    for (; lane + 8 <= laneCount; lane += 8) {
+        CORO_SIMD_LANES(8);
+    }
+    return lane;
+}
+
+bool hasAvx2()
+{
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+#endif
+
+} // namespace
+
+void biquadCascade(const float* in, float* out, uint32_t frameCount, size_t channelCount,
+                   size_t inSpacing, size_t outSpacing,
+                   const float* coeffs, size_t sectionCount, float* history, size_t stride, float offset)
+{
+    // Channels are independent, so each group of lanes runs over all frames.
+    size_t ch = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    if (hasAvx2()) {
+        ch = cascadeAvx2(in, out, frameCount, channelCount, inSpacing, outSpacing, coeffs, sectionCount, history, stride, offset);
+    }
+#endif
+    for (; ch + 4 <= channelCount; ch += 4) {
+        CORO_SIMD_CASCADE(4);
+    }
+    // Remaining channels run in one (partially used) vector.
+    switch (channelCount - ch) {
+    case 3:
+        CORO_SIMD_CASCADE(4, 3);
+        break;
+    case 2:
+        CORO_SIMD_CASCADE(2);
+        break;
+    case 1:
+        CORO_SIMD_CASCADE(1);
+        break;
+    }
+}
+
+#undef CORO_SIMD_CASCADE
+
+void biquad(const float* in, float* out, uint32_t frameCount, size_t channelCount,
+            size_t inSpacing, size_t outSpacing,
+            const float* coeffs, float* history, size_t stride)
+{
+    biquadCascade(in, out, frameCount, channelCount, inSpacing, outSpacing, coeffs, 1, history, stride);
+}
+
+void complexMulAdd(float* accRe, float* accIm, const float* xRe, const float* xIm,
+                   const float* hRe, const float* hIm, size_t count)
+{
+    size_t i = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    if (hasAvx2()) {
+        i = complexMulAddAvx2(accRe, accIm, xRe, xIm, hRe, hIm, count);
+    }
+#endif
+    i += complexMulAdd<4>(accRe+i, accIm+i, xRe+i, xIm+i, hRe+i, hIm+i, count-i);
+    for (; i < count; ++i) {
+        accRe[i] += xRe[i]*hRe[i] - xIm[i]*hIm[i];
+        accIm[i] += xRe[i]*hIm[i] + xIm[i]*hRe[i];
+    }
+}
+
+float dotProduct(const float* a, const float* b, size_t count)
+{
+    float acc = 0.0f;
+    size_t i = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    if (hasAvx2()) {
+        i = dotProductAvx2(a, b, count, acc);
+    }
+#endif
+    i += dotProduct<4>(a+i, b+i, count-i, acc);
+    for (; i < count; ++i) {
+        acc += a[i]*b[i];
+    }
+    return acc;
+}
+
+void biquadLanes(const float* in, float* out, uint32_t frameCount, size_t inChannelCount, size_t laneCount,
+                 const float* mix, const float* coeffs, size_t sectionCount, float* history, size_t stride,
+                 float offset)
+{
+    size_t lane = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    if (hasAvx2()) {
+        lane = lanesAvx2(in, out, frameCount, inChannelCount, laneCount, mix, coeffs, sectionCount, history, stride, offset);
+    }
+#endif
+    for (; lane + 4 <= laneCount; lane += 4) {
+        CORO_SIMD_LANES(4);
+    }
+    switch (laneCount - lane) {
+    case 3:
+        CORO_SIMD_LANES(4, 3);
+        break;
+    case 2:
+        CORO_SIMD_LANES(2);
+        break;
+    case 1:
+        CORO_SIMD_LANES(1);
+        break;
+    }
+}
+
+#undef CORO_SIMD_LANES
+
+} // namespace simd
+} // namespace audio
+} // namespace coro
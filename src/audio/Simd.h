@@ -0,0 +1,421 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace coro {
+namespace audio {
+namespace simd {
+
+// Vectorized float kernels. Pointers do not need to be aligned.
+
+/// dst[i] = src[i] * gain
+inline void mul(float* dst, const float* src, float gain, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const auto g = _mm_set1_ps(gain);
+    for (; i + 8 <= count; i += 8) {
+        _mm_storeu_ps(dst+i, _mm_mul_ps(_mm_loadu_ps(src+i), g));
+        _mm_storeu_ps(dst+i+4, _mm_mul_ps(_mm_loadu_ps(src+i+4), g));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        vst1q_f32(dst+i, vmulq_n_f32(vld1q_f32(src+i), gain));
+        vst1q_f32(dst+i+4, vmulq_n_f32(vld1q_f32(src+i+4), gain));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = src[i] * gain;
+    }
+}
+
+/// dst[i] += src[i] * gain
+inline void mulAdd(float* dst, const float* src, float gain, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const auto g = _mm_set1_ps(gain);
+    for (; i + 8 <= count; i += 8) {
+        _mm_storeu_ps(dst+i, _mm_add_ps(_mm_loadu_ps(dst+i), _mm_mul_ps(_mm_loadu_ps(src+i), g)));
+        _mm_storeu_ps(dst+i+4, _mm_add_ps(_mm_loadu_ps(dst+i+4), _mm_mul_ps(_mm_loadu_ps(src+i+4), g)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        vst1q_f32(dst+i, vmlaq_n_f32(vld1q_f32(dst+i), vld1q_f32(src+i), gain));
+        vst1q_f32(dst+i+4, vmlaq_n_f32(vld1q_f32(dst+i+4), vld1q_f32(src+i+4), gain));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] += src[i] * gain;
+    }
+}
+
+// Sample conversion kernels. Integers are full scale fixed point (Q15 and
+// Q31), float is +-1.0. Narrowing conversions round to nearest and saturate.
+// dst and src might be the same, if dst samples are not wider than src ones.
+
+/// int16_t -> float
+inline void int16ToFloat(float* dst, const int16_t* src, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const auto scale = _mm_set1_ps(1.0f/32768.0f);
+    for (; i + 8 <= count; i += 8) {
+        const auto x = _mm_loadu_si128((const __m128i*)(src+i));
+        const auto lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+        const auto hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+        _mm_storeu_ps(dst+i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst+i+4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        const auto x = vld1q_s16(src+i);
+        vst1q_f32(dst+i, vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(x)), 15));
+        vst1q_f32(dst+i+4, vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(x)), 15));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = src[i] * (1.0f/32768.0f);
+    }
+}
+
+/// float -> int16_t
+inline void floatToInt16(int16_t* dst, const float* src, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const auto scale = _mm_set1_ps(32768.0f);
+    const auto min = _mm_set1_ps(-32768.0f);
+    const auto max = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= count; i += 8) {
+        // Clamped before conversion, since overflow would yield INT32_MIN
+        const auto lo = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src+i), scale), min), max);
+        const auto hi = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src+i+4), scale), min), max);
+        _mm_storeu_si128((__m128i*)(dst+i), _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        // Saturating conversion (truncating) and saturating narrow
+        const auto lo = vcvtq_n_s32_f32(vld1q_f32(src+i), 31);
+        const auto hi = vcvtq_n_s32_f32(vld1q_f32(src+i+4), 31);
+        vst1q_s16(dst+i, vcombine_s16(vqrshrn_n_s32(lo, 16), vqrshrn_n_s32(hi, 16)));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = int16_t(std::lrintf(std::fmin(std::fmax(src[i] * 32768.0f, -32768.0f), 32767.0f)));
+    }
+}
+
+/// int32_t -> float
+inline void int32ToFloat(float* dst, const int32_t* src, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const auto scale = _mm_set1_ps(1.0f/2147483648.0f);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(dst+i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(src+i))), scale));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(dst+i, vcvtq_n_f32_s32(vld1q_s32(src+i), 31));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = float(src[i]) * (1.0f/2147483648.0f);
+    }
+}
+
+/// float -> int32_t
+inline void floatToInt32(int32_t* dst, const float* src, size_t count)
+{
+    // Largest float below 2^31
+    constexpr float maxValue = 2147483520.0f;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const auto scale = _mm_set1_ps(2147483648.0f);
+    const auto min = _mm_set1_ps(-2147483648.0f);
+    const auto max = _mm_set1_ps(maxValue);
+    for (; i + 4 <= count; i += 4) {
+        const auto x = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src+i), scale), min), max);
+        _mm_storeu_si128((__m128i*)(dst+i), _mm_cvtps_epi32(x));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_s32(dst+i, vcvtq_n_s32_f32(vld1q_f32(src+i), 31));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = int32_t(std::lrintf(std::fmin(std::fmax(src[i] * 2147483648.0f, -2147483648.0f), maxValue)));
+    }
+}
+
+/// int16_t -> int32_t
+inline void int16ToInt32(int32_t* dst, const int16_t* src, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 8 <= count; i += 8) {
+        const auto x = _mm_loadu_si128((const __m128i*)(src+i));
+        _mm_storeu_si128((__m128i*)(dst+i), _mm_unpacklo_epi16(_mm_setzero_si128(), x));
+        _mm_storeu_si128((__m128i*)(dst+i+4), _mm_unpackhi_epi16(_mm_setzero_si128(), x));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        const auto x = vld1q_s16(src+i);
+        vst1q_s32(dst+i, vshll_n_s16(vget_low_s16(x), 16));
+        vst1q_s32(dst+i+4, vshll_n_s16(vget_high_s16(x), 16));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = int32_t(src[i]) * 65536;
+    }
+}
+
+/// int32_t -> int16_t
+inline void int32ToInt16(int16_t* dst, const int32_t* src, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    // Rounds without overflow: ((x >> 15) + 1) >> 1, saturating pack
+    const auto one = _mm_set1_epi32(1);
+    for (; i + 8 <= count; i += 8) {
+        auto lo = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(src+i)), 15);
+        auto hi = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(src+i+4)), 15);
+        lo = _mm_srai_epi32(_mm_add_epi32(lo, one), 1);
+        hi = _mm_srai_epi32(_mm_add_epi32(hi, one), 1);
+        _mm_storeu_si128((__m128i*)(dst+i), _mm_packs_epi32(lo, hi));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        vst1q_s16(dst+i, vcombine_s16(vqrshrn_n_s32(vld1q_s32(src+i), 16), vqrshrn_n_s32(vld1q_s32(src+i+4), 16)));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = int16_t(std::min<int64_t>((int64_t(src[i]) + 0x8000) >> 16, INT16_MAX));
+    }
+}
+
+/// int32_t -> 24 bit, LSB aligned in int32_t (sign extended)
+inline void int32ToInt24(int32_t* dst, const int32_t* src, size_t count)
+{
+    constexpr int32_t maxValue = (1 << 23) - 1;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const auto one = _mm_set1_epi32(1);
+    const auto max = _mm_set1_epi32(maxValue);
+    for (; i + 4 <= count; i += 4) {
+        auto x = _mm_srai_epi32(_mm_loadu_si128((const __m128i*)(src+i)), 7);
+        x = _mm_srai_epi32(_mm_add_epi32(x, one), 1);
+        // Only rounding up can exceed the range
+        const auto isOver = _mm_cmpgt_epi32(x, max);
+        _mm_storeu_si128((__m128i*)(dst+i), _mm_or_si128(_mm_andnot_si128(isOver, x), _mm_and_si128(isOver, max)));
+    }
+#elif defined(__ARM_NEON)
+    const auto max = vdupq_n_s32(maxValue);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_s32(dst+i, vminq_s32(vrshrq_n_s32(vld1q_s32(src+i), 8), max));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = int32_t(std::min<int64_t>((int64_t(src[i]) + 0x80) >> 8, maxValue));
+    }
+}
+
+/// 24 bit, LSB aligned in int32_t -> int32_t. Upper byte is ignored.
+inline void int24ToInt32(int32_t* dst, const int32_t* src, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(dst+i), _mm_slli_epi32(_mm_loadu_si128((const __m128i*)(src+i)), 8));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_s32(dst+i, vshlq_n_s32(vld1q_s32(src+i), 8));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = int32_t(uint32_t(src[i]) << 8);
+    }
+}
+
+// Layout kernels. Planar buffers hold one plane of frameCount samples per
+// channel. Stereo frames of 4 byte samples are shuffled in SIMD, all others
+// are copied one by one. dst and src must not overlap.
+
+/// Interleaved frames -> planar
+template <typename T>
+inline void deinterleave(T* dst, const T* src, size_t channelCount, size_t frameCount)
+{
+    size_t i = 0;
+    if constexpr (sizeof(T) == 4) {
+        if (channelCount == 2) {
+            float* l = (float*)dst;
+            float* r = l + frameCount;
+            const float* in = (const float*)src;
+#if defined(__SSE2__)
+            // Samples are only moved, so int32_t passes bitwise as well.
+            for (; i + 4 <= frameCount; i += 4) {
+                const auto a = _mm_loadu_ps(in + 2*i);
+                const auto b = _mm_loadu_ps(in + 2*i + 4);
+                _mm_storeu_ps(l+i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+                _mm_storeu_ps(r+i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+            }
+#elif defined(__ARM_NEON)
+            for (; i + 4 <= frameCount; i += 4) {
+                const auto lr = vld2q_f32(in + 2*i);
+                vst1q_f32(l+i, lr.val[0]);
+                vst1q_f32(r+i, lr.val[1]);
+            }
+#endif
+        }
+    }
+    for (size_t ch = 0; ch < channelCount; ++ch) {
+        T* plane = dst + ch*frameCount;
+        for (size_t f = i; f < frameCount; ++f) {
+            plane[f] = src[f*channelCount + ch];
+        }
+    }
+}
+
+/// Planar -> interleaved frames
+template <typename T>
+inline void interleave(T* dst, const T* src, size_t channelCount, size_t frameCount)
+{
+    size_t i = 0;
+    if constexpr (sizeof(T) == 4) {
+        if (channelCount == 2) {
+            const float* l = (const float*)src;
+            const float* r = l + frameCount;
+            float* out = (float*)dst;
+#if defined(__SSE2__)
+            for (; i + 4 <= frameCount; i += 4) {
+                const auto a = _mm_loadu_ps(l+i);
+                const auto b = _mm_loadu_ps(r+i);
+                _mm_storeu_ps(out + 2*i, _mm_unpacklo_ps(a, b));
+                _mm_storeu_ps(out + 2*i + 4, _mm_unpackhi_ps(a, b));
+            }
+#elif defined(__ARM_NEON)
+            for (; i + 4 <= frameCount; i += 4) {
+                vst2q_f32(out + 2*i, float32x4x2_t { { vld1q_f32(l+i), vld1q_f32(r+i) } });
+            }
+#endif
+        }
+    }
+    for (size_t ch = 0; ch < channelCount; ++ch) {
+        const T* plane = src + ch*frameCount;
+        for (size_t f = i; f < frameCount; ++f) {
+            dst[f*channelCount + ch] = plane[f];
+        }
+    }
+}
+
+/// Maximum number of sections for biquadCascade()
+constexpr size_t maxCascadeSections = 64;
+
+/**
+ * @brief Cascade of biquads (direct form I) over interleaved frames.
+ *
+ * Each frame runs through all sections back to back, so data is streamed
+ * once. Channels are processed in lanes of 8 (AVX2, dispatched at runtime),
+ * 4, 2 and 1. Order of operations matches the scalar implementation of
+ * TBiquad (no FMA), so results are the same on all code paths.
+ *
+ * Sections share state: y1 and y2 of a section are x1 and x2 of the next
+ * one. So, history holds sectionCount+1 taps with two states (z1, z2) each.
+ *
+ * @param coeffs b0, b1, b2, a1, a2 of each section
+ * @param history z1 and z2 of all taps and channels, each state @p stride
+ *        floats apart.
+ * @param offset added to each section's output, keeps history away from
+ *        denormals (see audio::denormalOffset()).
+ */
+void biquadCascade(const float* in, float* out, uint32_t frameCount, size_t channelCount,
+                   size_t inSpacing, size_t outSpacing,
+                   const float* coeffs, size_t sectionCount, float* history, size_t stride,
+                   float offset = 0.0f);
+
+/**
+ * @brief Single biquad section.
+ *
+ * @param coeffs b0, b1, b2, a1, a2
+ * @param history x1, x2, y1 and y2 of all channels, each state @p stride
+ *        floats apart.
+ */
+void biquad(const float* in, float* out, uint32_t frameCount, size_t channelCount,
+            size_t inSpacing, size_t outSpacing,
+            const float* coeffs, float* history, size_t stride);
+
+/// Maximum number of sections and input channels for biquadLanes()
+constexpr size_t maxLaneSections = 16;
+constexpr size_t maxLaneInputs = 2;
+
+/**
+ * @brief Biquad cascades with coefficients per lane (e.g. crossover bands).
+ *
+ * Each lane (output channel) mixes its input from the input channels and
+ * runs through its own sections. Frames are read once per group of lanes
+ * and lanes are written contiguously, so one call splits interleaved input
+ * into any number of bands. Shorter cascades are padded with identity
+ * sections.
+ *
+ * Arrays are lane-major, with lanes padded to @p stride (multiple of 8):
+ *
+ * @param mix weight of each input channel: mix[c*stride + lane]
+ * @param coeffs b0, b1, b2, a1, a2 of each section: coeffs[(s*5 + k)*stride + lane]
+ * @param history z1 and z2 of sectionCount+1 taps: history[(tap*2 + z)*stride + lane]
+ * @param offset see biquadCascade()
+ */
+void biquadLanes(const float* in, float* out, uint32_t frameCount, size_t inChannelCount, size_t laneCount,
+                 const float* mix, const float* coeffs, size_t sectionCount, float* history, size_t stride,
+                 float offset = 0.0f);
+
+/**
+ * @brief Complex multiply-accumulate on split (real and imaginary) arrays.
+ *
+ * accRe[i] += xRe[i]*hRe[i] - xIm[i]*hIm[i]
+ * accIm[i] += xRe[i]*hIm[i] + xIm[i]*hRe[i]
+ *
+ * Used for frequency domain convolution. Runs 8 (AVX2, dispatched at
+ * runtime) or 4 bins at once.
+ */
+void complexMulAdd(float* accRe, float* accIm, const float* xRe, const float* xIm,
+                   const float* hRe, const float* hIm, size_t count);
+
+/**
+ * @brief Dot product of a and b.
+ *
+ * Used for polyphase FIR filters. Runs 8 (AVX2, dispatched at runtime) or 4
+ * products at once, so the order of summation differs from a scalar loop.
+ */
+float dotProduct(const float* a, const float* b, size_t count);
+
+} // namespace simd
+} // namespace audio
+} // namespace coro
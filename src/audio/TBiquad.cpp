@@ -1,6 +1,10 @@
 #include "TBiquad.h"
 
+#include "Simd.h"
+
 #include <assert.h>
+#include <iterator>
+#include <type_traits>
 
 namespace coro
 {
@@ -9,14 +13,17 @@ template <typename T, typename U>
 TBiquad<T,U>::TBiquad(std::uint8_t channelCount, std::uint8_t cascadeCount, std::uint32_t rate)
     : m_channelCount(channelCount),
       m_rate(rate),
-      m_history(cascadeCount, std::vector<History>(channelCount))
+      m_cascadeCount(cascadeCount),
+      m_lanesPerState((channelCount + std::size(Lanes().v) - 1) / std::size(Lanes().v)),
+      m_history(cascadeCount * 4 * m_lanesPerState)
 {
 }
 
 template <typename T, typename U>
 void TBiquad<T,U>::setCascadeCount(std::uint8_t count)
 {
-    m_history.resize(count, std::vector<History>(m_channelCount));
+    m_cascadeCount = count;
+    m_history.resize(count * 4 * m_lanesPerState);
 }
 
 template <typename T, typename U>
@@ -46,56 +53,72 @@ void TBiquad<T,U>::process(T* const _in, T* const _out, std::uint32_t frameCount
         return;
     }
 
-    // Inner history size reflects channels (and spacing).
-    assert(m_history.front().size() == inSpacing);
+    // History size reflects channels (and spacing).
+    assert(m_channelCount == inSpacing);
 
     // http://www.olliw.eu/2016/digital-filters/
     // https://dsp.stackexchange.com/questions/21792/best-implementation-of-a-real-time-fixed-point-iir-filter-with-constant-coeffic
     // https://web.archive.org/web/20181212024857/http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt
-    for (std::size_t i = 0; i < m_history.size(); ++i) {
+    for (std::size_t i = 0; i < m_cascadeCount; ++i) {
         // After first run, we have to process result and not again the input data
         T* in = (i == 0) ? _in : _out;
         T* out = _out;
 
-        // Ch1|Ch2|Ch3|Ch4 || Ch1|Ch2|Ch3|Ch4 || Ch1|Ch2|Ch3|Ch4    -> 4 Channels, 3 frames -> 12 samples
-        for (std::uint32_t j = 0; j < frameCount; ++j) {
-            for (auto& channel : m_history.at(i)) {
-
-                U acc = 0.0;
-                acc += m_coeffs.b0**in;
-                acc += m_coeffs.b1*channel.x1;
-                acc += m_coeffs.b2*channel.x2;
-                acc -= m_coeffs.a1*channel.y1;
-                acc -= m_coeffs.a2*channel.y2;
-
-                scaleDown(acc);
-
-                channel.y2 = channel.y1;
-                channel.y1 = acc;
-                channel.x2 = channel.x1;
-                channel.x1 = *in;
-
-                *out = acc;
-
-                ++in;
-                ++out;
+        T* x1 = history(i, X1);
+        T* x2 = history(i, X2);
+        T* y1 = history(i, Y1);
+        T* y2 = history(i, Y2);
+
+        if constexpr (std::is_same<T, float>::value && std::is_same<U, float>::value) {
+            // Float kernel holds the history of all channels in registers.
+            const float coeffs[5] = { m_coeffs.b0, m_coeffs.b1, m_coeffs.b2, m_coeffs.a1, m_coeffs.a2 };
+            audio::simd::biquad(in, out, frameCount, m_channelCount, inSpacing, outSpacing,
+                                coeffs, x1, m_lanesPerState * std::size(Lanes().v));
+        } else {
+            // Ch1|Ch2|Ch3|Ch4 || Ch1|Ch2|Ch3|Ch4 || Ch1|Ch2|Ch3|Ch4    -> 4 Channels, 3 frames -> 12 samples
+            for (std::uint32_t j = 0; j < frameCount; ++j) {
+                for (std::size_t c = 0; c < m_channelCount; ++c) {
+                    U acc = 0.0;
+                    acc += m_coeffs.b0**in;
+                    acc += m_coeffs.b1*x1[c];
+                    acc += m_coeffs.b2*x2[c];
+                    acc -= m_coeffs.a1*y1[c];
+                    acc -= m_coeffs.a2*y2[c];
+
+                    scaleDown(acc);
+
+                    y2[c] = y1[c];
+                    y1[c] = acc;
+                    x2[c] = x1[c];
+                    x1[c] = *in;
+
+                    *out = acc;
+
+                    ++in;
+                    ++out;
+                }
+                in += inSpacing-m_channelCount;
+                out += outSpacing-m_channelCount;
             }
-            in += inSpacing-m_history.at(i).size();
-            out += outSpacing-m_history.at(i).size();
         }
         // After first run, we operate on out instead of in. So, we have to use outSpacing for inSpacing
         inSpacing = outSpacing;
     }
 }
 
+template <typename T, typename U>
+T* TBiquad<T,U>::history(std::size_t cascade, State state)
+{
+    return m_history[(cascade * 4 + state) * m_lanesPerState].v;
+}
+
 template <typename T, typename U>
 bool TBiquad<T,U>::isValid() const
 {
     return (m_rate >= 0 && m_filter.isValid());
 }
 
-template <typename T, typename U>
-bool TBiquad<T,U>::update()
+bool biquadCoeffs(const Filter& filter, std::uint32_t rate, double* coeffs)
 {
     double b0 = 0.0;
     double b1 = 0.0;
@@ -104,11 +127,11 @@ bool TBiquad<T,U>::update()
     double a1 = 0.0;
     double a2 = 0.0;
 
-    switch (m_filter.type) {
+    switch (filter.type) {
     case FilterType::Peak: {
-        double A = pow(10, m_filter.g/40.0);
-        double w0 = 2*M_PI*m_filter.f/m_rate;
-        double alpha = sin(w0)*0.5/m_filter.q;
+        double A = pow(10, filter.g/40.0);
+        double w0 = 2*M_PI*filter.f/rate;
+        double alpha = sin(w0)*0.5/filter.q;
         double alpha1 = alpha*A;
         double alpha2 = alpha/A;
 
@@ -121,8 +144,8 @@ bool TBiquad<T,U>::update()
         break;
     }
     case FilterType::LowPass: {
-        double w0 = 2*M_PI*m_filter.f/m_rate;
-        double alpha = sin(w0)*0.5/m_filter.q;
+        double w0 = 2*M_PI*filter.f/rate;
+        double alpha = sin(w0)*0.5/filter.q;
 
         a0 = 1.0 + alpha;
         b1 = ( 1.0 - cos(w0) ) / a0;
@@ -133,8 +156,8 @@ bool TBiquad<T,U>::update()
         break;
     }
     case FilterType::HighPass: {
-        double w0 = 2*M_PI*m_filter.f/m_rate;
-        double alpha = sin(w0)*0.5/m_filter.q;
+        double w0 = 2*M_PI*filter.f/rate;
+        double alpha = sin(w0)*0.5/filter.q;
 
         a0    = 1.0 + alpha;
         b1 = -( 1.0 + cos(w0) ) / a0;
@@ -145,10 +168,10 @@ bool TBiquad<T,U>::update()
         break;
     }
     case FilterType::LowShelf: {
-        double A = pow(10, m_filter.g/40.0);
-        double w0 = 2*M_PI*m_filter.f/m_rate;
+        double A = pow(10, filter.g/40.0);
+        double w0 = 2*M_PI*filter.f/rate;
         double cosW0 = cos(w0);
-        double alpha = sin(w0)*0.5/m_filter.q;
+        double alpha = sin(w0)*0.5/filter.q;
         double sqrtAalpha2 = 2.0*sqrt(A)*alpha;
 
         a0 = (A+1) + (A-1)*cosW0 + sqrtAalpha2;
@@ -160,10 +183,10 @@ bool TBiquad<T,U>::update()
         break;
     }
     case FilterType::HighShelf: {
-        double A = pow(10, m_filter.g/40.0);
-        double w0 = 2*M_PI*m_filter.f/m_rate;
+        double A = pow(10, filter.g/40.0);
+        double w0 = 2*M_PI*filter.f/rate;
         double cosW0 = cos(w0);
-        double alpha = sin(w0)*0.5/m_filter.q;
+        double alpha = sin(w0)*0.5/filter.q;
         double sqrtAalpha2 = 2.0*sqrt(A)*alpha;
 
         a0 = (A+1) - (A-1)*cosW0 + sqrtAalpha2;
@@ -174,17 +197,53 @@ bool TBiquad<T,U>::update()
         a2 =      ( (A+1) - (A-1)*cosW0 - sqrtAalpha2) / a0;
         break;
     }
+    case FilterType::AllPass: {
+        // First order for q <= 0.5 (like LR2 crossovers, which sum up to it)
+        if (filter.q <= 0.5) {
+            double K = tan(M_PI*filter.f/rate);
+            b0 = (K - 1.0) / (K + 1.0);
+            b1 = 1.0;
+            a1 = b0;
+            break;
+        }
+        double w0 = 2*M_PI*filter.f/rate;
+        double alpha = sin(w0)*0.5/filter.q;
+
+        a0 = 1.0 + alpha;
+        b0 = ( 1.0 - alpha ) / a0;
+        b1 = (-2.0 * cos(w0)) / a0;
+        b2 = 1.0;
+        a1 = b1;
+        a2 = b0;
+        break;
+    }
     case FilterType::Invalid:
-    case FilterType::AllPass:
     case FilterType::Crossover:
         return false;
     }
 
-    m_coeffs.b0 = scaleUp(b0);
-    m_coeffs.b1 = scaleUp(b1);
-    m_coeffs.b2 = scaleUp(b2);
-    m_coeffs.a1 = scaleUp(a1);
-    m_coeffs.a2 = scaleUp(a2);
+    coeffs[0] = b0;
+    coeffs[1] = b1;
+    coeffs[2] = b2;
+    coeffs[3] = a1;
+    coeffs[4] = a2;
+
+    return true;
+}
+
+template <typename T, typename U>
+bool TBiquad<T,U>::update()
+{
+    double coeffs[5];
+    if (!biquadCoeffs(m_filter, m_rate, coeffs)) {
+        return false;
+    }
+
+    m_coeffs.b0 = scaleUp(coeffs[0]);
+    m_coeffs.b1 = scaleUp(coeffs[1]);
+    m_coeffs.b2 = scaleUp(coeffs[2]);
+    m_coeffs.a1 = scaleUp(coeffs[3]);
+    m_coeffs.a2 = scaleUp(coeffs[4]);
 
     return true;
 }
@@ -52,13 +52,11 @@ const char* AppSink::name() const
     return "AppSink";
 }
 
-audio::AudioConf AppSink::onProcess(const audio::AudioConf& conf, core::Buffer& buffer)
+void AppSink::onProcess(core::BufferPtr& buffer)
 {
     if (d->processCallback) {
-        d->processCallback(conf, buffer);
+        d->processCallback(buffer->audioConf(), *buffer);
     }
-
-    return {};
 }
 
 void AppSink::onStop()
@@ -21,20 +21,146 @@
 #include <core/BufferPool.h>
 #include <loguru/loguru.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
-#include <iostream>
-#include <vector>
+#include <new>
 
 namespace coro {
 namespace core {
 
+static size_t alignUp(size_t size)
+{
+    return (size + Buffer::alignment - 1) & ~(Buffer::alignment - 1);
+}
+
+// Zero padding segments point into this block.
+static const char s_zeros[8192] = {};
+
+// Reference counted storage, which can be shared by multiple buffers (slices).
+// The header sits in front of the actual memory, so memory stays aligned.
+class BufferStorage {
+public:
+    static BufferStorage* create(size_t capacity) {
+        auto memory = std::aligned_alloc(Buffer::alignment, Buffer::alignment + capacity);
+        return new (memory) BufferStorage;
+    }
+
+    void ref() {
+        refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void unref() {
+        if (refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            this->~BufferStorage();
+            std::free(this);
+        }
+    }
+
+    char* data() {
+        return reinterpret_cast<char*>(this) + Buffer::alignment;
+    }
+
+    std::atomic<uint32_t> refCount = 1;
+};
+static_assert(sizeof(BufferStorage) <= Buffer::alignment, "BufferStorage header too big");
+
 class BufferPrivate {
 public:
-    mutable std::vector<int32_t> buffer; // use int32_t internally to align to 4 byte borders
+    ~BufferPrivate() {
+        release();
+    }
+
+    bool isShared() const {
+        return storage && storage->refCount.load(std::memory_order_acquire) > 1;
+    }
+
+    // Reallocate storage with given capacity and move payload to given offset.
+    void reallocate(size_t newCapacity, size_t newOffset) {
+        newCapacity = alignUp(newCapacity);
+        auto newStorage = BufferStorage::create(newCapacity);
+        if (storage) {
+            std::memcpy(newStorage->data() + newOffset, memory + offset, size);
+            storage->unref();
+        }
+        storage = newStorage;
+        memory = newStorage->data();
+        capacity = newCapacity;
+        offset = newOffset;
+    }
+
+    // Take a private copy of shared storage before writing to it.
+    void detach() {
+        if (isShared()) {
+            reallocate(capacity, offset);
+        }
+    }
+
+    // Copy header and zero padding next to payload, so buffer becomes contiguous.
+    void flatten() {
+        if (!headerSize && !paddingSize) {
+            return;
+        }
+
+        detach();
+        if (offset < headerSize || capacity - offset - size < paddingSize) {
+            reallocate(headerSize + size + paddingSize, headerSize);
+        }
+        std::memcpy(memory + offset - headerSize, header.data() + header.size() - headerSize, headerSize);
+        std::memset(memory + offset + size, 0, paddingSize);
+        offset -= headerSize;
+        size += headerSize + paddingSize;
+        headerSize = 0;
+        paddingSize = 0;
+    }
+
+    void assign(const BufferPrivate& other) {
+        release();
+        if (other.storage) {
+            other.storage->ref();
+        }
+        storage = other.storage;
+        memory = other.memory;
+        capacity = other.capacity;
+        size = other.size;
+        offset = other.offset;
+        headerSize = other.headerSize;
+        paddingSize = other.paddingSize;
+        std::memcpy(header.data() + header.size() - headerSize, other.header.data() + header.size() - headerSize, headerSize);
+        audioConf = other.audioConf;
+    }
+
+    void release() {
+        if (storage) {
+            storage->unref();
+        }
+        storage = nullptr;
+        memory = nullptr;
+        capacity = 0;
+        size = 0;
+        offset = 0;
+        headerSize = 0;
+        paddingSize = 0;
+    }
+
+    BufferStorage* storage = nullptr;
+    char*    memory = nullptr;  // aligned to Buffer::alignment, uninitialized
+    size_t   capacity = 0;
     size_t   size = 0;
     size_t   offset = 0;
-    mutable size_t  acquiredOffset = 0;
+    size_t   acquiredOffset = 0;
+
+    // Header segment is filled back to front. Padding segment consists of zeros.
+    std::array<char, Buffer::maxHeaderSize> header;
+    size_t   headerSize = 0;
+    size_t   paddingSize = 0;
+
     audio::AudioConf audioConf;
+
+    // Not reset on release(), buffer stays in its class of BufferPool.
+    size_t   poolClass = SIZE_MAX;
 };
 
 BufferPtr Buffer::create(size_t reservedSize, const Node* caller)
@@ -45,16 +171,16 @@ BufferPtr Buffer::create(size_t reservedSize, const Node* caller)
 Buffer::Buffer(size_t size)
     : d(new BufferPrivate)
 {
-    // Add 3 to round up to next multiple of 4.
-    d->buffer.resize((size + 3) / 4);
+    if (size) {
+        d->reallocate(size, 0);
+    }
 }
 
 Buffer::Buffer(const char* data, size_t size, size_t reservedSize, size_t offset) :
     d(new BufferPrivate)
 {
-    d->buffer.resize(std::max(size+offset, reservedSize)/4+1);
+    d->reallocate(std::max(size+offset, reservedSize), offset);
     d->size = size;
-    d->offset = offset;
     std::memcpy(this->data(), data, size);
 }
 
@@ -63,6 +189,11 @@ Buffer::~Buffer()
     delete d;
 }
 
+void Buffer::swap(Buffer& other)
+{
+    std::swap(d, other.d);
+}
+
 bool Buffer::isValid() const
 {
     // @TODO(mawe): also check conf here, as soon as we pass conf with buffer.
@@ -71,106 +202,248 @@ bool Buffer::isValid() const
 
 char* Buffer::data()
 {
-    return (char*)(d->buffer.data())+d->offset;
+    d->flatten();
+    d->detach();
+    return d->memory + d->offset;
 }
 
 const char* Buffer::data() const
 {
-    return (const char*)(d->buffer.data())+d->offset;
+    return constData();
+}
+
+const char* Buffer::constData() const
+{
+    d->flatten();
+    return d->memory + d->offset;
+}
+
+BufferPtr Buffer::slice(size_t offset, size_t size) const
+{
+    auto buffer = BufferPool::instance().acquireShell();
+    buffer->d->assign(*d);
+    buffer->trimFront(std::min(offset, this->size()));
+    buffer->shrink(size);
+    return buffer;
+}
+
+bool Buffer::isShared() const
+{
+    return d->isShared();
+}
+
+void Buffer::dropStorage()
+{
+    d->release();
+}
+
+void Buffer::resetStorage(size_t capacity)
+{
+    d->release();
+    d->reallocate(capacity, 0);
+}
+
+size_t Buffer::poolClass() const
+{
+    return d->poolClass;
+}
+
+void Buffer::setPoolClass(size_t poolClass)
+{
+    d->poolClass = poolClass;
 }
 
 size_t Buffer::size() const
 {
-    return d->size;
+    return d->headerSize + d->size + d->paddingSize;
 }
 
 size_t Buffer::capacity() const
 {
-    return d->buffer.capacity() * 4;
+    return d->capacity;
+}
+
+bool Buffer::isContiguous() const
+{
+    return !d->headerSize && !d->paddingSize;
+}
+
+size_t Buffer::segmentCount() const
+{
+    return (d->headerSize > 0) + (d->size > 0) + (d->paddingSize + sizeof(s_zeros) - 1) / sizeof(s_zeros);
+}
+
+size_t Buffer::segments(struct iovec* segments, size_t count) const
+{
+    size_t i = 0;
+    if (d->headerSize && i < count) {
+        segments[i].iov_base = d->header.data() + d->header.size() - d->headerSize;
+        segments[i].iov_len = d->headerSize;
+        ++i;
+    }
+    if (d->size && i < count) {
+        segments[i].iov_base = d->memory + d->offset;
+        segments[i].iov_len = d->size;
+        ++i;
+    }
+    for (size_t padding = d->paddingSize; padding && i < count; ++i) {
+        segments[i].iov_base = const_cast<char*>(s_zeros);
+        segments[i].iov_len = std::min(padding, sizeof(s_zeros));
+        padding -= segments[i].iov_len;
+    }
+    return i;
+}
+
+size_t Buffer::headroom() const
+{
+    return d->offset;
+}
+
+size_t Buffer::tailroom() const
+{
+    return d->capacity - d->offset - d->size;
+}
+
+void Buffer::reserve(size_t headroom, size_t tailroom, const core::Node* caller)
+{
+    d->flatten();
+    d->detach();
+    const auto offset = std::max(d->offset, headroom);
+    // Capacity never shrinks, so space beyond the requested one is kept anyway.
+    const auto capacity = offset + d->size + tailroom;
+    if (capacity > d->capacity) {
+        LOG_F(INFO, "%s reserved buffer. %zu -> %zu bytes", caller ? caller->name() : "unknown", d->capacity, alignUp(capacity));
+        d->reallocate(capacity, offset);
+    } else if (offset != d->offset) {
+        std::memmove(d->memory + offset, d->memory + d->offset, d->size);
+        d->offset = offset;
+    }
 }
 
 char* Buffer::acquire(size_t size, const core::Node* caller) const
 {
+    // Space around payload might belong to other slices.
+    d->flatten();
+    d->detach();
+
     // If we have space in front
     if (d->offset >= size) {
         d->acquiredOffset = 0;
-        return (char*)d->buffer.data();
+        return d->memory;
     }
 
     // If we have space at back
-    const auto sizeAtBack = d->buffer.size() * 4 - d->offset - d->size - 3;
-    if (sizeAtBack >= size) {
-        d->acquiredOffset = d->offset + d->size;
-        d->acquiredOffset += d->acquiredOffset % 4;
-        return (char*)d->buffer.data() + d->acquiredOffset;
+    d->acquiredOffset = alignUp(d->offset + d->size);
+    if (d->acquiredOffset + size <= d->capacity) {
+        return d->memory + d->acquiredOffset;
     }
 
-    // Create space
-    auto orgSize = d->buffer.capacity() * 4;    // size in bytes
-    auto newSize = d->buffer.size() + (size - sizeAtBack) / 4 + 1;
-    auto isReallocated = d->buffer.capacity() < newSize;
-    d->buffer.resize(newSize);
-    d->acquiredOffset = d->offset + d->size;
-    d->acquiredOffset += d->acquiredOffset % 4;
-    if (caller && isReallocated) {
-        LOG_F(INFO, "%s reallocated buffer. %zu -> %zu bytes", caller->name(), orgSize, d->buffer.capacity()*4);
-    } else if (isReallocated) {
-        LOG_F(INFO, "buffer reallocated. %zu -> %zu bytes", orgSize, d->buffer.capacity()*4);
+    // Create space. Grow by at least 50 percent to not reallocate on every call.
+    auto orgSize = d->capacity;
+    d->reallocate(std::max(d->acquiredOffset + size, d->capacity + d->capacity/2), d->offset);
+    if (caller) {
+        LOG_F(INFO, "%s reallocated buffer. %zu -> %zu bytes", caller->name(), orgSize, d->capacity);
+    } else {
+        LOG_F(INFO, "buffer reallocated. %zu -> %zu bytes", orgSize, d->capacity);
     }
-    return (char*)d->buffer.data() + d->acquiredOffset;
+    return d->memory + d->acquiredOffset;
 }
 
 void Buffer::commit(size_t size)
 {
     d->offset = d->acquiredOffset;
     d->size = size;
+    d->headerSize = 0;
+    d->paddingSize = 0;
 }
 
 void Buffer::prepend(const char* data, uint32_t size)
 {
-    if (d->offset >= size) {
+    // Write in front of payload if possible (headroom of shared storage belongs to other slices)
+    if (!d->headerSize && d->offset >= size && !d->isShared()) {
         d->offset -= size;
         d->size += size;
-        std::memcpy(d->buffer.data()+d->offset, data, size);
+        std::memcpy(d->memory+d->offset, data, size);
+    } else if (d->headerSize + size <= d->header.size()) {
+        d->headerSize += size;
+        std::memcpy(d->header.data() + d->header.size() - d->headerSize, data, size);
     } else {
-        auto dest = acquire(d->size+size);
-        std::memcpy(dest, data, size);
-        std::memcpy(dest+size, d->buffer.data()+d->offset, d->size);
-        commit(d->size+size);
+        d->flatten();
+        reserve(size, 0);
+        d->offset -= size;
+        d->size += size;
+        std::memcpy(d->memory+d->offset, data, size);
+    }
+}
+
+void Buffer::pad(size_t size)
+{
+    if (size > this->size()) {
+        d->paddingSize += size - this->size();
     }
 }
 
 void Buffer::grow(size_t size)
 {
-    d->size = std::min(d->buffer.size()*4, size);
+    d->flatten();
+    d->detach();
+    d->size = std::min(d->capacity - d->offset, size);
 }
 
 void Buffer::shrink(size_t size)
 {
-    d->size = std::min(d->size, size);
+    if (size < this->size()) {
+        trimBack(this->size() - size);
+    }
 }
 
 void Buffer::clear()
 {
     d->offset = 0;
     d->size = 0;
+    d->headerSize = 0;
+    d->paddingSize = 0;
 }
 
 void Buffer::trimFront(size_t size)
 {
-    if (size > d->size) {
+    if (size > this->size()) {
         return;
     }
-    d->offset += size;
-    d->size -= size;
+
+    // Header is at front of header segment
+    auto count = std::min(d->headerSize, size);
+    d->headerSize -= count;
+    size -= count;
+
+    count = std::min(d->size, size);
+    d->offset += count;
+    d->size -= count;
+    size -= count;
+
+    d->paddingSize -= size;
 }
 
 void Buffer::trimBack(size_t size)
 {
-    if (size > d->size) {
+    if (size > this->size()) {
         return;
     }
-    d->size -= size;
+
+    auto count = std::min(d->paddingSize, size);
+    d->paddingSize -= count;
+    size -= count;
+
+    count = std::min(d->size, size);
+    d->size -= count;
+    size -= count;
+
+    // Header segment is aligned to back, so move remaining bytes
+    if (size) {
+        auto end = d->header.data() + d->header.size();
+        std::memmove(end - d->headerSize + size, end - d->headerSize, d->headerSize - size);
+        d->headerSize -= size;
+    }
 }
 
 audio::AudioConf& Buffer::audioConf()
@@ -178,5 +451,10 @@ audio::AudioConf& Buffer::audioConf()
     return d->audioConf;
 }
 
+const audio::AudioConf& Buffer::audioConf() const
+{
+    return d->audioConf;
+}
+
 } // namespace core
 } // namespace coro
@@ -17,25 +17,38 @@
 
 #include "core/BufferPool.h"
 
-#include "core/Buffer.h"
+#include "core/Node.h"
 #include "loguru/loguru.hpp"
 
-#include <functional>
-#include <list>
+#include <algorithm>
 
 namespace coro {
 namespace core {
 
-using namespace std::placeholders;
+// Per-thread free lists. These are only touched by the owning thread, so no
+// synchronization is needed.
+class BufferPoolCache
+{
+public:
+    ~BufferPoolCache() {
+        // Hand remaining buffers to depot, so other threads can still use them.
+        for (size_t i = 0; i < lists.size(); ++i) {
+            if (!lists[i].empty()) {
+                BufferPool::instance().drain(i, lists[i], lists[i].size());
+            }
+        }
+    }
+
+    std::array<std::vector<Buffer*>, BufferPool::sizeClassCount+1> lists;
+};
 
-static std::list<Buffer*> s_buffers;
+static thread_local BufferPoolCache t_cache;
 
 void BufferDeleter::operator()(Buffer* buffer) {
     if (!buffer) {
         return;
     }
-    buffer->clear();
-    s_buffers.push_back(buffer);
+    BufferPool::instance().release(buffer);
 }
 
 BufferPool::BufferPool()
@@ -44,6 +57,11 @@ BufferPool::BufferPool()
 
 BufferPool::~BufferPool()
 {
+    for (auto& depot : m_depots) {
+        for (auto buffer : depot.buffers) {
+            delete buffer;
+        }
+    }
 }
 
 BufferPool& BufferPool::instance()
@@ -52,25 +70,135 @@ BufferPool& BufferPool::instance()
     return bufferPool;
 }
 
-BufferPtr BufferPool::acquire(size_t size, const core::Node* caller) const
+BufferPtr BufferPool::acquire(size_t size, const core::Node* caller)
 {
-    Buffer* buffer = nullptr;
-    for (auto b : s_buffers) {
-        // @TODO(mawe): for now simple strategy: use first element that can hold the desired size.
-        if (b->capacity() >= size) {
-            buffer = b;
-            s_buffers.remove(b);
-            break;
-        }
+    const auto index = sizeClass(size);
+
+    // Oversized buffers are not pooled.
+    if (index >= sizeClassCount) {
+        LOG_F(WARNING, "%s requested unpooled buffer. size: %zu", caller ? caller->name() : "unknown", size);
+        return BufferPtr(new Buffer(size), BufferDeleter());
     }
-    // If no valid buffer found, acquire new one.
-    if (!buffer) {
-        LOG_F(INFO, "New buffer created. size: %zu", size);
-        buffer = new Buffer(size);
+
+    auto& list = t_cache.lists[index];
+    if (list.empty()) {
+        refill(index, list);
     }
 
+    // If no buffer available, acquire new one with full size of its class.
+    if (list.empty()) {
+        LOG_F(INFO, "%s created new buffer. size: %zu", caller ? caller->name() : "unknown", classSize(index));
+        auto buffer = new Buffer(classSize(index));
+        buffer->setPoolClass(index);
+        return BufferPtr(buffer, BufferDeleter());
+    }
+
+    auto buffer = list.back();
+    list.pop_back();
     return BufferPtr(buffer, BufferDeleter());
 }
 
+BufferPtr BufferPool::acquireShell()
+{
+    auto& list = t_cache.lists[shellClass];
+    if (list.empty()) {
+        refill(shellClass, list);
+    }
+
+    if (list.empty()) {
+        return BufferPtr(new Buffer, BufferDeleter());
+    }
+
+    auto buffer = list.back();
+    list.pop_back();
+    return BufferPtr(buffer, BufferDeleter());
+}
+
+void BufferPool::release(Buffer* buffer)
+{
+    buffer->clear();
+    buffer->audioConf() = {};
+
+    // Storage still used by other slices stays with them.
+    if (buffer->isShared()) {
+        buffer->dropStorage();
+    }
+
+    // Buffer goes back to the class it was handed out from. Storage, which
+    // grew too much, is shrunk back.
+    size_t index = buffer->poolClass();
+    if (index < sizeClassCount && buffer->capacity() >= classSize(index)) {
+        if (buffer->capacity() > maxGrowthFactor * classSize(index)) {
+            buffer->resetStorage(classSize(index));
+        }
+        push(index, buffer);
+        return;
+    }
+
+    // Otherwise, buffer goes to the largest class it can fully serve.
+    const auto capacity = buffer->capacity();
+    index = shellClass;
+    if (capacity >= (size_t(1) << minSizeClassShift)) {
+        index = (63 - __builtin_clzll(capacity)) - minSizeClassShift;
+        if (index >= sizeClassCount) {
+            delete buffer;
+            return;
+        }
+    } else if (capacity > 0) {
+        buffer->dropStorage();
+    }
+    buffer->setPoolClass(index);
+    push(index, buffer);
+}
+
+void BufferPool::push(size_t index, Buffer* buffer)
+{
+    auto& list = t_cache.lists[index];
+    if (list.size() >= maxCachedCount) {
+        drain(index, list);
+    }
+    if (list.capacity() < maxCachedCount) {
+        list.reserve(maxCachedCount);
+    }
+    list.push_back(buffer);
+}
+
+size_t BufferPool::classSize(size_t sizeClass)
+{
+    return size_t(1) << (sizeClass + minSizeClassShift);
+}
+
+size_t BufferPool::sizeClass(size_t size)
+{
+    // Round up to next power of two.
+    const size_t shift = (size <= 1) ? 0 : (64 - __builtin_clzll(size - 1));
+    return (shift <= minSizeClassShift) ? 0 : (shift - minSizeClassShift);
+}
+
+void BufferPool::refill(size_t sizeClass, std::vector<Buffer*>& buffers)
+{
+    auto& depot = m_depots[sizeClass];
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    const auto count = std::min(batchCount, depot.buffers.size());
+    buffers.insert(buffers.end(), depot.buffers.end() - count, depot.buffers.end());
+    depot.buffers.resize(depot.buffers.size() - count);
+}
+
+void BufferPool::drain(size_t sizeClass, std::vector<Buffer*>& buffers, size_t count)
+{
+    count = std::min(count, buffers.size());
+    auto& depot = m_depots[sizeClass];
+    depot.mutex.lock();
+    const auto kept = std::min(count, maxDepotCount - std::min(maxDepotCount, depot.buffers.size()));
+    depot.buffers.insert(depot.buffers.end(), buffers.end() - count, buffers.end() - count + kept);
+    depot.mutex.unlock();
+
+    // Depot is full, delete excess buffers outside of lock
+    for (auto it = buffers.end() - count + kept; it != buffers.end(); ++it) {
+        delete *it;
+    }
+    buffers.resize(buffers.size() - count);
+}
+
 } // namespace core
 } // namespace coro
@@ -19,19 +19,77 @@
 
 #include <coro/core/Buffer.h>
 
+#include <array>
+#include <mutex>
+#include <vector>
+
 namespace coro {
 namespace core {
 
+/**
+ * Pool of recycled buffers.
+ *
+ * Buffers are bucketed by power-of-two size classes. Each thread keeps its own
+ * free list per size class, so acquire and release do not need any locking in
+ * the common case. Whenever a thread cache runs full (e.g. buffers are created
+ * by a decoding thread and released by an output thread), a batch of buffers
+ * is moved to a shared depot, from which other threads refill their caches.
+ *
+ * A buffer is released into the class it was handed out from, even if a node
+ * grew it meanwhile. So, the next request of the same size gets the grown
+ * buffer and does not have to grow it again. Storage grown beyond
+ * maxGrowthFactor times its class is shrunk back. Depots are capped at
+ * maxDepotCount buffers per class, excess buffers are deleted.
+ */
 class BufferPool
 {
 public:
     static BufferPool& instance();
 
-    BufferPtr acquire(size_t size, const core::Node* caller = nullptr) const;
+    BufferPtr acquire(size_t size, const core::Node* caller = nullptr);
+    void release(Buffer* buffer);
+
+    // Acquire a buffer without storage (to be used for slices).
+    BufferPtr acquireShell();
+
+    // Smallest size class is 64 bytes, largest is 32 MiB.
+    static constexpr size_t minSizeClassShift = 6;
+    static constexpr size_t sizeClassCount = 20;
+    // Buffers without (or with shared) storage are kept in an extra class.
+    static constexpr size_t shellClass = sizeClassCount;
+
+    // Max buffers per size class in a thread cache and count of buffers moved
+    // between thread cache and depot at once.
+    static constexpr size_t maxCachedCount = 32;
+    static constexpr size_t batchCount = maxCachedCount / 2;
+    // Max buffers per size class in depot
+    static constexpr size_t maxDepotCount = 8 * maxCachedCount;
+    // Max capacity of a released buffer relative to its class
+    static constexpr size_t maxGrowthFactor = 4;
 
 private:
     BufferPool();
     ~BufferPool();
+
+    friend class BufferPoolCache;
+
+    static size_t sizeClass(size_t size);
+    static size_t classSize(size_t sizeClass);
+
+    // Put buffer into thread cache of given class.
+    void push(size_t sizeClass, Buffer* buffer);
+
+    // Move up to batchCount buffers from depot into given list.
+    void refill(size_t sizeClass, std::vector<Buffer*>& buffers);
+    // Move up to batchCount buffers from given list into depot. Buffers
+    // exceeding maxDepotCount are deleted.
+    void drain(size_t sizeClass, std::vector<Buffer*>& buffers, size_t count = batchCount);
+
+    struct Depot {
+        std::mutex mutex;
+        std::vector<Buffer*> buffers;
+    };
+    std::array<Depot, sizeClassCount+1> m_depots;
 };
 
 } // namespace core
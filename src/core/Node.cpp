@@ -17,8 +17,13 @@
 
 #include "core/Node.h"
 
+#include "BufferPool.h"
+
 #include <loguru/loguru.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 namespace coro {
 namespace core {
 
@@ -27,28 +32,98 @@ Node* Node::next() const
     return m_next;
 }
 
-audio::AudioConf Node::process(const audio::AudioConf& _conf, core::Buffer& buffer)
+void Node::process(core::BufferPtr& buffer)
 {
-    if (_conf.codec == audio::AudioCodec::Invalid || !buffer.size()) {
-        buffer.clear();
-        return {};
+    if (!buffer->isValid() || buffer->audioConf().codec == audio::AudioCodec::Invalid) {
+        buffer->clear();
+        return;
     }
 
-    if (isBypassed() && next()) {
-        return next()->process(_conf, buffer);
-    } else if (isBypassed() && !next()) {
-        buffer.clear();
-        return {};
+    // Only interleaved raw audio with known layout can be split into frames
+    const auto frameSize = buffer->audioConf().frameSize();
+    if (m_blockSize && audio::isRaw(buffer->audioConf().codec) && frameSize && !buffer->audioConf().isPlanar &&
+        buffer->size() > m_blockSize * frameSize) {
+        processBlocks(buffer);
+        return;
     }
 
-    auto conf = onProcess(_conf, buffer);
+    processBuffer(buffer);
+}
+
+void Node::processBuffer(core::BufferPtr& buffer)
+{
+    if (!isBypassed()) {
+        const size_t sizeHint = buffer->capacity();
+
+#ifdef CORO_NODE_STATS
+        const bool isStatsEnabled = this->isStatsEnabled();
+        const auto inConf = buffer->audioConf();
+        const auto inBytes = buffer->size();
+        const auto start = isStatsEnabled ? NodeStats::Clock::now() : NodeStats::Clock::time_point();
+#endif
+
+        onProcess(buffer);
+
+#ifdef CORO_NODE_STATS
+        if (isStatsEnabled) {
+            const auto duration = NodeStats::Clock::now() - start;
+            m_stats.add(inConf, inBytes, buffer ? buffer->audioConf() : inConf, buffer ? buffer->size() : 0, duration);
+        }
+#endif
+
+        // If buffer consumed (from e.g. some encoder), return a size hinted buffer
+        if (!buffer) {
+            buffer = Buffer::create(sizeHint, this);
+            return;
+        }
+    }
 
     if (!next()) {
-        buffer.clear();
-        return {};
+        buffer->clear();
+        return;
     }
 
-    return next()->process(conf, buffer);
+    next()->process(buffer);
+}
+
+void Node::processBlocks(core::BufferPtr& buffer)
+{
+    const auto conf = buffer->audioConf();
+    const size_t blockBytes = m_blockSize * conf.frameSize();
+    if (!m_block) {
+        m_block = Buffer::create(blockBytes, this);
+    }
+
+    const char* data = buffer->constData();
+    for (size_t offset = 0; offset < buffer->size(); offset += blockBytes) {
+        const size_t size = std::min(blockBytes, buffer->size() - offset);
+        // Clearing drops the headroom. Downstream nodes might also have taken
+        // the block and handed back an unreserved one, so reserve again (this
+        // only moves the offset, once the block is large enough).
+        m_block->clear();
+        reserve(*m_block, blockBytes);
+        std::memcpy(m_block->acquire(size, this), data + offset, size);
+        m_block->commit(size);
+        m_block->audioConf() = conf;
+
+        // Downstream nodes might take the block and hand back another one.
+        processBuffer(m_block);
+    }
+
+    // Payload was passed on block by block
+    buffer->clear();
+}
+
+audio::AudioConf Node::process(const audio::AudioConf& conf, core::Buffer& buffer)
+{
+    auto ptr = BufferPool::instance().acquireShell();
+    ptr->swap(buffer);
+    ptr->audioConf() = conf;
+
+    process(ptr);
+
+    buffer.swap(*ptr);
+    return buffer.audioConf();
 }
 
 bool Node::isBypassed() const
@@ -61,6 +136,84 @@ void Node::setIsBypassed(bool bypass)
     m_isBypassed = bypass;
 }
 
+size_t Node::headroom() const
+{
+    return m_headroom;
+}
+
+float Node::tailroom() const
+{
+    return m_tailroom;
+}
+
+void Node::reserve(core::Buffer& buffer, size_t payloadSize) const
+{
+    size_t headroom = 0;
+    // Payload still to be written is placed behind the current one.
+    size_t tailroom = payloadSize - std::min(payloadSize, buffer.size());
+
+    // Headers get prepended in front of the current payload, so the largest one
+    // counts. Nodes writing behind the payload stack up (e.g. int16 -> float ->
+    // crossover), so we sum these while tracking the payload size.
+    for (auto node = this; node; node = node->next()) {
+        headroom = std::max(headroom, node->headroom());
+        if (node->tailroom() > 0.0f) {
+            payloadSize = payloadSize * node->tailroom();
+            tailroom += payloadSize + Buffer::alignment;
+        }
+    }
+
+    buffer.reserve(headroom, tailroom, this);
+}
+
+void Node::setBlockSize(uint32_t frames)
+{
+    m_blockSize = frames ? std::clamp(frames, minBlockSize, maxBlockSize) : 0;
+    m_block.reset();
+}
+
+uint32_t Node::blockSize() const
+{
+    return m_blockSize;
+}
+
+void Node::setNext(Node* next)
+{
+    m_next = next;
+}
+
+#ifdef CORO_NODE_STATS
+void Node::setStatsEnabled(bool enabled)
+{
+    m_isStatsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Node::isStatsEnabled() const
+{
+    return m_isStatsEnabled.load(std::memory_order_relaxed);
+}
+
+const NodeStats& Node::stats() const
+{
+    return m_stats;
+}
+
+NodeStats& Node::stats()
+{
+    return m_stats;
+}
+#endif
+
+void Node::setHeadroom(size_t bytes)
+{
+    m_headroom = bytes;
+}
+
+void Node::setTailroom(float factor)
+{
+    m_tailroom = factor;
+}
+
 void Node::onStart()
 {
 }
@@ -75,30 +228,18 @@ audio::AudioConf Node::onProcess(const audio::AudioConf& conf, core::Buffer&)
     return conf;
 }
 
-void Node::onProcess(core::BufferPtr&)
+void Node::onProcess(core::BufferPtr& buffer)
 {
+    // Back compatibility for nodes, which are not migrated yet.
+    buffer->audioConf() = onProcess(buffer->audioConf(), *buffer);
 }
 
-void Node::process(core::BufferPtr& buffer)
+void Node::stopChain()
 {
-    size_t sizeHint = buffer->capacity();
-
-    // Process buffer
-    if (!isBypassed()) {
-        onProcess(buffer);
-        // @TOOD(mawe): this is for back compatibility
-        onProcess(buffer->audioConf(), *buffer.get());
-    }
-
-    // If buffer consumed (from e.g. some encoder), return a size hinted buffer
-    if (!buffer) {
-        buffer = Buffer::create(sizeHint, this);
-        return;
-    }
-
-    // If buffer not consumed and still valid, pass to next node
-    if (buffer->isValid() && next()) {
-        next()->process(buffer);
+    for (auto node = this; node; node = node->next()) {
+        if (!node->isBypassed()) {
+            node->onStop();
+        }
     }
 }
 
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "core/NodeStats.h"
+
+#include <coro/audio/AudioConf.h>
+
+#include <algorithm>
+
+namespace coro {
+namespace core {
+
+void NodeStats::add(const audio::AudioConf& inConf, size_t inBytes,
+                    const audio::AudioConf& outConf, size_t outBytes,
+                    Clock::duration duration)
+{
+    const uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+
+    add(m_count, 1);
+    add(m_bytes, inBytes);
+    add(m_processingNs, ns);
+    if (ns > m_maxProcessingNs.load(std::memory_order_relaxed)) {
+        m_maxProcessingNs.store(ns, std::memory_order_relaxed);
+    }
+
+    const size_t bucket = ns ? std::min<size_t>(63 - __builtin_clzll(ns), histogramSize - 1) : 0;
+    add(m_histogram[bucket], 1);
+
+    // Encoded audio has no fixed frame size
+    uint64_t frames = 0;
+    uint32_t rate = 0;
+    if (audio::isRaw(inConf.codec) && !inConf.isRtpPayloaded && inConf.frameSize()) {
+        frames = inBytes / inConf.frameSize();
+        rate = audio::toInt(inConf.rate);
+    } else if (audio::isRaw(outConf.codec) && !outConf.isRtpPayloaded && outConf.frameSize()) {
+        frames = outBytes / outConf.frameSize();
+        rate = audio::toInt(outConf.rate);
+    }
+    if (frames && rate) {
+        add(m_frames, frames);
+        add(m_audioNs, frames * 1000000000 / rate);
+    }
+}
+
+uint64_t NodeStats::count() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+uint64_t NodeStats::bytes() const
+{
+    return m_bytes.load(std::memory_order_relaxed);
+}
+
+uint64_t NodeStats::frames() const
+{
+    return m_frames.load(std::memory_order_relaxed);
+}
+
+uint64_t NodeStats::processingNs() const
+{
+    return m_processingNs.load(std::memory_order_relaxed);
+}
+
+uint64_t NodeStats::maxProcessingNs() const
+{
+    return m_maxProcessingNs.load(std::memory_order_relaxed);
+}
+
+uint64_t NodeStats::audioNs() const
+{
+    return m_audioNs.load(std::memory_order_relaxed);
+}
+
+float NodeStats::dspLoad() const
+{
+    const auto audio = audioNs();
+    return audio ? float(processingNs()) / audio : 0.0f;
+}
+
+std::array<uint64_t, NodeStats::histogramSize> NodeStats::histogram() const
+{
+    std::array<uint64_t, histogramSize> histogram;
+    for (size_t i = 0; i < histogramSize; ++i) {
+        histogram[i] = m_histogram[i].load(std::memory_order_relaxed);
+    }
+    return histogram;
+}
+
+void NodeStats::reset()
+{
+    m_count = 0;
+    m_bytes = 0;
+    m_frames = 0;
+    m_processingNs = 0;
+    m_maxProcessingNs = 0;
+    m_audioNs = 0;
+    for (auto& bucket : m_histogram) {
+        bucket = 0;
+    }
+}
+
+} // namespace core
+} // namespace coro
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "core/Queue.h"
+
+#include "RingBuffer.h"
+
+#include <loguru/loguru.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace coro {
+namespace core {
+
+class QueuePrivate
+{
+public:
+    QueuePrivate(Queue& _p, size_t depth, Queue::OverflowPolicy _policy) :
+        p(_p),
+        ring(std::max(depth, size_t(1))),
+        policy(_policy) {
+    }
+
+    void start() {
+        if (isRunning) {
+            return;
+        }
+        isRunning = true;
+        thread = std::thread(&QueuePrivate::run, this);
+    }
+
+    void stop() {
+        isRunning = false;
+        wake();
+        if (thread.joinable()) {
+            thread.join();
+        }
+
+        // Discard pending buffers
+        BufferPtr buffer;
+        while (ring.pop(buffer)) {
+            buffer.reset();
+        }
+    }
+
+    // Return false if a buffer got dropped
+    bool push(BufferPtr& buffer) {
+        if (ring.push(buffer)) {
+            wakeWorker();
+            return true;
+        }
+
+        switch (policy) {
+        case Queue::OverflowPolicy::DropOldest: {
+            BufferPtr oldest;
+            if (ring.pop(oldest)) {
+                ++droppedCount;
+            }
+            if (ring.push(buffer)) {
+                wakeWorker();
+                return !oldest;
+            }
+            break;
+        }
+        case Queue::OverflowPolicy::DropNewest:
+            break;
+        case Queue::OverflowPolicy::Block:
+            while (isRunning) {
+                std::unique_lock<std::mutex> lock(mutex);
+                isProducerWaiting = true;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                cv.wait(lock, [this] { return !ring.isFull() || !isRunning; });
+                isProducerWaiting = false;
+                lock.unlock();
+
+                if (ring.push(buffer)) {
+                    wakeWorker();
+                    return true;
+                }
+            }
+            break;
+        }
+
+        ++droppedCount;
+        return false;
+    }
+
+    void run() {
+        BufferPtr buffer;
+        while (isRunning) {
+            if (ring.pop(buffer)) {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (isProducerWaiting) {
+                    wake();
+                }
+                if (p.next()) {
+                    p.next()->process(buffer);
+                }
+                buffer.reset();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            isWorkerWaiting = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            cv.wait(lock, [this] { return !ring.isEmpty() || !isRunning; });
+            isWorkerWaiting = false;
+        }
+    }
+
+    // Condition variable is only used for sleeping, so only notify if other side waits.
+    void wakeWorker() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (isWorkerWaiting) {
+            wake();
+        }
+    }
+
+    void wake() {
+        mutex.lock();
+        mutex.unlock();
+        cv.notify_all();
+    }
+
+    Queue& p;
+    RingBuffer<BufferPtr> ring;
+    const Queue::OverflowPolicy policy;
+
+    std::thread thread;
+    std::atomic_bool isRunning = false;
+    std::atomic_size_t droppedCount = 0;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic_bool isWorkerWaiting = false;
+    std::atomic_bool isProducerWaiting = false;
+};
+
+Queue::Queue(size_t depth, OverflowPolicy policy) :
+    d(new QueuePrivate(*this, depth, policy))
+{
+}
+
+Queue::~Queue()
+{
+    d->stop();
+    delete d;
+}
+
+size_t Queue::depth() const
+{
+    return d->ring.capacity();
+}
+
+Queue::OverflowPolicy Queue::overflowPolicy() const
+{
+    return d->policy;
+}
+
+size_t Queue::droppedCount() const
+{
+    return d->droppedCount;
+}
+
+const char* Queue::name() const
+{
+    return "Queue";
+}
+
+void Queue::onStop()
+{
+    // Downstream nodes get stopped after this, so worker has to be finished.
+    d->stop();
+    LOG_F(2, "%s stopped. dropped buffers: %zu", name(), d->droppedCount.load());
+}
+
+void Queue::onProcess(core::BufferPtr& buffer)
+{
+    d->start();
+
+    // Take ownership of buffer. Upstream gets a pooled one of same size.
+    if (!d->push(buffer)) {
+        LOG_F(2, "%s overflow. dropped buffers: %zu", name(), d->droppedCount.load());
+    }
+
+    // Dropped buffer must not be processed on this thread
+    if (buffer) {
+        buffer->clear();
+    }
+}
+
+} // namespace core
+} // namespace coro
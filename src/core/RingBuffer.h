@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace coro {
+namespace core {
+
+/**
+ * Bounded, lock-free ring buffer.
+ *
+ * It is meant for a single producer and a single consumer. Each slot carries
+ * a sequence number, which tells whether it is ready to be written or read.
+ * This way, the producer can also pop elements (e.g. to drop the oldest one
+ * on overflow) without racing the consumer.
+ */
+template<class T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(size_t capacity) :
+        m_slots(new Slot[capacity]),
+        m_capacity(capacity)
+    {
+        for (size_t i = 0; i < capacity; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity() const {
+        return m_capacity;
+    }
+
+    // Move value into ring. Value is untouched if ring is full. Producer only.
+    bool push(T& value) {
+        const auto pos = m_head.load(std::memory_order_relaxed);
+        auto& slot = m_slots[pos % m_capacity];
+        if (slot.sequence.load(std::memory_order_acquire) != pos) {
+            return false;
+        }
+
+        slot.value = std::move(value);
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        m_head.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Move oldest element out of ring.
+    bool pop(T& value) {
+        auto pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& slot = m_slots[pos % m_capacity];
+            const auto diff = static_cast<std::ptrdiff_t>(slot.sequence.load(std::memory_order_acquire) - (pos + 1));
+            // Empty
+            if (diff < 0) {
+                return false;
+            }
+            // Taken by another thread meanwhile
+            if (diff > 0) {
+                pos = m_tail.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                value = std::move(slot.value);
+                slot.sequence.store(pos + m_capacity, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    bool isEmpty() const {
+        const auto pos = m_tail.load(std::memory_order_acquire);
+        return m_slots[pos % m_capacity].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    bool isFull() const {
+        const auto pos = m_head.load(std::memory_order_acquire);
+        return m_slots[pos % m_capacity].sequence.load(std::memory_order_acquire) != pos;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    const size_t m_capacity;
+
+    // Keep write and read positions on separate cache lines
+    alignas(64) std::atomic<size_t> m_head = 0;
+    alignas(64) std::atomic<size_t> m_tail = 0;
+};
+
+} // namespace core
+} // namespace coro
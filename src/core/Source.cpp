@@ -38,13 +38,7 @@ void Source::stop()
 {
     m_isStarted = false;
 
-    Node* _next = this;
-    while (_next) {
-        if (!_next->isBypassed()) {
-            _next->onStop();
-        }
-        _next = _next->next();
-    }
+    stopChain();
 
     setReady(false);
 }
@@ -76,6 +70,17 @@ void Source::setReadyCallback(ReadyCallback callback)
     m_mutex.unlock();
 }
 
+void Source::pushBuffer(core::BufferPtr& buffer)
+{
+    // If source wants to push buffers, we consider it ready.
+    setReady(true);
+
+    // @TODO(mawe): currently, sources are started per default. This will change.
+    if (isStarted() || !m_isControlled) {
+        process(buffer);
+    }
+}
+
 void Source::pushBuffer(const audio::AudioConf& _conf, core::Buffer& buffer)
 {
     // If source wants to push buffers, we consider it ready.
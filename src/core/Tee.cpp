@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2020 Manuel Weichselbaumer <mincequi@web.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "core/Tee.h"
+
+namespace coro {
+namespace core {
+
+Tee::Tee()
+{
+}
+
+Tee::~Tee()
+{
+}
+
+const std::vector<Node*>& Tee::branches() const
+{
+    return m_branches;
+}
+
+const char* Tee::name() const
+{
+    return "Tee";
+}
+
+void Tee::setNext(Node* next)
+{
+    m_branches.push_back(next);
+}
+
+void Tee::onStop()
+{
+    // Source only stops nodes along next(), so stop branches here.
+    for (auto branch : m_branches) {
+        branch->stopChain();
+    }
+}
+
+void Tee::onProcess(core::BufferPtr& buffer)
+{
+    if (m_branches.empty()) {
+        return;
+    }
+
+    for (size_t i = 0; i < m_branches.size() - 1; ++i) {
+        auto slice = buffer->slice();
+        m_branches.at(i)->process(slice);
+    }
+
+    // Last branch gets original buffer. If previous branches are done with
+    // their slices, storage is not shared anymore and can be written in place.
+    m_branches.back()->process(buffer);
+}
+
+} // namespace core
+} // namespace coro
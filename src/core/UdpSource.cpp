@@ -54,7 +54,7 @@ UdpSource::UdpSource(const Config& config) :
     m_socket(d->ioContext),
     m_localEndpoint(ip::udp::v4(), config.port),
     m_timeout(d->ioContext, std::chrono::seconds(1)),
-    m_buffer(config.prePadding + m_config.mtu)
+    m_buffer(core::Buffer::create(core::Buffer::alignment + config.prePadding + m_config.mtu, this))
 {
     m_socket.open(m_localEndpoint.protocol());
     m_socket.set_option(ip::udp::socket::reuse_address(true));
@@ -107,11 +107,16 @@ void UdpSource::doReceive()
     }
     m_isReceiving = true;
 
-    const auto size = m_config.prePadding + m_config.mtu;
-    auto data = m_buffer.acquire(size, this);
-    //m_buffer.commit(m_config.prePadding + m_config.mtu);
+    // Payload starts prePadding bytes behind an aligned address, so it is
+    // aligned again after sources strip their headers. Behind it, reserve
+    // space for the packet and all downstream nodes.
+    m_buffer->clear();
+    reserve(*m_buffer, m_config.mtu);
+    const auto alignedHeadroom = (m_buffer->headroom() + core::Buffer::alignment - 1) & ~(core::Buffer::alignment - 1);
+    m_buffer->reserve(alignedHeadroom + m_config.prePadding, 0, this);
+    reserve(*m_buffer, m_config.mtu);
     m_socket.async_receive_from(
-                buffer(data + m_config.prePadding, m_config.mtu),
+                buffer(m_buffer->data(), m_config.mtu),
                 d->remoteEndpoint,
                 std::bind(&UdpSource::onReceived, this, ph::_1, ph::_2));
 }
@@ -130,13 +135,12 @@ void UdpSource::onReceived(const boost::system::error_code& ec, std::size_t byte
     m_isReceiving = false;
 
     ++m_bufferCount;
-    m_buffer.commit(m_config.prePadding + bytesTransferred);
-    m_buffer.trimFront(m_config.prePadding);
-    //m_buffer.shrink(bytesTransferred);
+    m_buffer->grow(bytesTransferred);
+    m_buffer->audioConf() = { audio::AudioCodec::Unknown,
+                              audio::SampleRate::RateUnknown,
+                              audio::ChannelFlags::Any };
 
-    pushBuffer(audio::AudioConf { audio::AudioCodec::Unknown,
-                                  audio::SampleRate::RateUnknown,
-                                  audio::ChannelFlags::Any }, m_buffer);
+    pushBuffer(m_buffer);
 
     doReceive();
 }
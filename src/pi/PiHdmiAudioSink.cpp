@@ -55,7 +55,7 @@ audio::AudioConf PiHdmiAudioSink::onProcess(const audio::AudioConf& conf, core::
     }
 
     auto data = audioplay_get_buffer(m_handle);
-    std::memcpy(data, buffer.data(), buffer.size());
+    std::memcpy(data, buffer.constData(), buffer.size());
 
     // try and wait for a minimum latency time (in ms) before sending the next packet.
 #define CTTW_SLEEP_TIME 10
@@ -48,33 +48,33 @@ const char* RtpDecoder<codec>::name() const
 }
 
 template<audio::AudioCodec codec>
-audio::AudioConf RtpDecoder<codec>::onProcess(const audio::AudioConf& conf, core::Buffer& buffer)
+void RtpDecoder<codec>::onProcess(core::BufferPtr& buffer)
 {
-    if (buffer.size() < 12) { // RtpHeader 12 bytes
-        buffer.clear();
+    if (buffer->size() < 12) { // RtpHeader 12 bytes
+        buffer->clear();
         LOG_F(WARNING, "Header invalid");
-        return {};
+        return;
     }
 
-    coro::rtp::RtpHeader* rtpHeader = (coro::rtp::RtpHeader*)(buffer.data());
-    rtpHeader->sequenceNumber = boost::endian::big_to_native(rtpHeader->sequenceNumber);
-    rtpHeader->timestamp = boost::endian::big_to_native(rtpHeader->timestamp);
+    // Header is only read (and stripped by trimming), so a shared buffer is never copied.
+    const auto rtpHeader = (const coro::rtp::RtpHeader*)(buffer->constData());
+    const uint16_t sequenceNumber = boost::endian::big_to_native(rtpHeader->sequenceNumber);
     if (rtpHeader->payloadType < 96) {
-        buffer.clear();
+        buffer->clear();
         LOG_F(WARNING, "Header invalid");
-        return {};
+        return;
     }
 
     if (m_isFlushed) {
         m_isFlushed = false;
-        m_seq = rtpHeader->sequenceNumber;
+        m_seq = sequenceNumber;
         LOG_F(INFO, "Sequence starts at: %d", m_seq);
-    } else if (++m_seq != rtpHeader->sequenceNumber) {
-        LOG_F(WARNING, "Sequence discontinuous. %d, %d", m_seq, rtpHeader->sequenceNumber);
-        m_seq = rtpHeader->sequenceNumber;
+    } else if (++m_seq != sequenceNumber) {
+        LOG_F(WARNING, "Sequence discontinuous. %d, %d", m_seq, sequenceNumber);
+        m_seq = sequenceNumber;
     }
 
-    return onProcessCodec(*rtpHeader, buffer);
+    buffer->audioConf() = onProcessCodec(*rtpHeader, *buffer);
 }
 
 template<audio::AudioCodec codec>
@@ -98,7 +98,7 @@ audio::AudioConf RtpDecoder<audio::AudioCodec::Ac3>::onProcessCodec(const rtp::R
         return {};
     }
 
-    if ((buffer.data() + header.size())[0] != 0 || (buffer.data() + header.size())[1] != 1) {
+    if ((buffer.constData() + header.size())[0] != 0 || (buffer.constData() + header.size())[1] != 1) {
         buffer.clear();
         LOG_F(WARNING, "AC3 header invalid");
         return {};
@@ -122,7 +122,7 @@ audio::AudioConf RtpDecoder<audio::AudioCodec::Sbc>::onProcessCodec(const rtp::R
         return {};
     }
 
-    coro::rtp::RtpSbcHeader* rtpSbcHeader = (coro::rtp::RtpSbcHeader*)(buffer.data() + header.size());
+    auto rtpSbcHeader = (const coro::rtp::RtpSbcHeader*)(buffer.constData() + header.size());
     if (!rtpSbcHeader->isValid()) {
         LOG_F(WARNING, "SBC header invalid");
         return {};
@@ -1,9 +1,19 @@
 #include "../include/TBiquad.h"
 
+#include <coro/audio/BiquadCascade.h>
+#include <coro/audio/CoefficientBank.h>
+#include <coro/audio/Crossover.h>
+#include <coro/audio/Peq.h>
+
+#include <cassert>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <memory>
 #include <random>
 
 using namespace coro;
@@ -107,8 +117,398 @@ void runTest(std::string filename, std::uint16_t seconds = 100)
     std::cout << "Write time: " << diff.count() << std::endl;
 }
 
+// Previous scalar implementation: history in nested vectors, triple loop.
+struct ReferenceBiquad
+{
+    struct History {
+        float x1 = 0.0, x2 = 0.0;
+        float y1 = 0.0, y2 = 0.0;
+    };
+
+    ReferenceBiquad(const TBiquad<float,float>::Coeffs& coeffs, std::uint8_t channelCount, std::uint8_t cascadeCount)
+        : coeffs(coeffs),
+          history(cascadeCount, std::vector<History>(channelCount))
+    {
+    }
+
+    void process(float* _in, float* _out, std::uint32_t frameCount, std::uint8_t inSpacing, std::uint8_t outSpacing)
+    {
+        for (std::size_t i = 0; i < history.size(); ++i) {
+            float* in = (i == 0) ? _in : _out;
+            float* out = _out;
+            for (std::uint32_t j = 0; j < frameCount; ++j) {
+                for (auto& channel : history.at(i)) {
+                    float acc = 0.0;
+                    acc += coeffs.b0**in;
+                    acc += coeffs.b1*channel.x1;
+                    acc += coeffs.b2*channel.x2;
+                    acc -= coeffs.a1*channel.y1;
+                    acc -= coeffs.a2*channel.y2;
+                    channel.y2 = channel.y1;
+                    channel.y1 = acc;
+                    channel.x2 = channel.x1;
+                    channel.x1 = *in;
+                    *out = acc;
+                    ++in;
+                    ++out;
+                }
+                in += inSpacing-history.at(i).size();
+                out += outSpacing-history.at(i).size();
+            }
+            inSpacing = outSpacing;
+        }
+    }
+
+    TBiquad<float,float>::Coeffs coeffs;
+    std::vector<std::vector<History>> history;
+};
+
+// Best time of several runs over a fresh copy of input, since timing is noisy.
+// Filter history carries over between runs, output of last run is kept.
+template <class F>
+double bestTime(const std::vector<float>& input, std::vector<float>& data, F&& process)
+{
+    double best = 1e9;
+    for (int run = 0; run < 5; ++run) {
+        data = input;
+        const auto begin = std::chrono::steady_clock::now();
+        process(data);
+        const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - begin;
+        best = std::min(best, diff.count());
+    }
+    return best;
+}
+
+void runSimdBenchmark(std::uint8_t channelCount)
+{
+    const std::uint32_t blockSize = 512;
+    const std::uint32_t frameCount = blockSize*430; // ~5 s
+    const auto samples = generateWhiteNoise<float>(5*channelCount/2 + 1);
+    const std::vector<float> input(samples.begin(), samples.begin() + frameCount*channelCount);
+
+    TBiquad<float,float> biquad(channelCount, 2, 44100);
+    biquad.setFilter( { coro::FilterType::Peak, 2000.0, -6.0, 1.414 } );
+    ReferenceBiquad reference(biquad.m_coeffs, channelCount, 2);
+
+    // Process in blocks to also check history carried across calls
+    auto run = [&](auto& b) {
+        return [&](std::vector<float>& data) {
+            for (std::uint32_t i = 0; i < frameCount; i += blockSize) {
+                b.process(data.data() + i*channelCount, data.data() + i*channelCount, blockSize, channelCount, channelCount);
+            }
+        };
+    };
+
+    std::vector<float> refData;
+    std::vector<float> simdData;
+    const auto refTime = bestTime(input, refData, run(reference));
+    const auto simdTime = bestTime(input, simdData, run(biquad));
+
+    for (std::size_t i = 0; i < refData.size(); ++i) {
+        assert(std::fabs(refData[i] - simdData[i]) <= 1e-5f * (1.0f + std::fabs(refData[i])));
+    }
+
+    std::cout << "Channels: " << int(channelCount)
+              << ", scalar: " << refTime
+              << ", simd: " << simdTime
+              << ", speed-up: " << refTime/simdTime << std::endl;
+}
+
+void runCascadeBenchmark()
+{
+    const std::uint32_t blockSize = 512;
+    const std::uint32_t frameCount = blockSize*430; // ~5 s
+    const auto samples = generateWhiteNoise<float>(5);
+    const std::vector<float> input(samples.begin(), samples.begin() + frameCount*2);
+
+    std::vector<Filter> filters;
+    for (float f = 31.25f; f < 20000.0f; f *= 2.0f) {
+        filters.push_back({ coro::FilterType::Peak, f, -3.0, 1.414 });
+    }
+
+    std::vector<TBiquad<float,float>> biquads(filters.size(), TBiquad<float,float>(2, 1, 44100));
+    for (std::size_t i = 0; i < filters.size(); ++i) {
+        biquads[i].setFilter(filters[i]);
+    }
+    audio::BiquadCascade cascade(2, 44100);
+    cascade.setFilters(filters);
+    assert(cascade.sectionCount() == filters.size());
+
+    std::vector<float> seqData;
+    std::vector<float> fusedData;
+    const auto seqTime = bestTime(input, seqData, [&](std::vector<float>& data) {
+        for (std::uint32_t i = 0; i < frameCount; i += blockSize) {
+            for (auto& b : biquads) {
+                b.process(data.data() + i*2, data.data() + i*2, blockSize, 2, 2);
+            }
+        }
+    });
+    const auto fusedTime = bestTime(input, fusedData, [&](std::vector<float>& data) {
+        for (std::uint32_t i = 0; i < frameCount; i += blockSize) {
+            cascade.process(data.data() + i*2, data.data() + i*2, blockSize, 2, 2);
+        }
+    });
+
+    for (std::size_t i = 0; i < seqData.size(); ++i) {
+        assert(std::fabs(seqData[i] - fusedData[i]) <= 1e-5f * (1.0f + std::fabs(seqData[i])));
+    }
+
+    std::cout << "Sections: " << filters.size()
+              << ", sequential: " << seqTime
+              << ", fused: " << fusedTime
+              << ", speed-up: " << seqTime/fusedTime << std::endl;
+
+    // Gain is folded into the coefficients, no sections copies input.
+    audio::BiquadCascade gain(2, 44100);
+    gain.setGain(0.5f);
+    float in[4] = { 1.0f, -1.0f, 0.5f, 0.25f };
+    float out[4];
+    gain.process(in, out, 2, 2, 2);
+    assert(out[0] == 0.5f && out[1] == -0.5f && out[2] == 0.25f && out[3] == 0.125f);
+    gain.setFilters({ { coro::FilterType::LowPass, 1000.0, 0.0, 0.707 } });
+    assert(gain.sectionCount() == 1);
+}
+
+// Runs interleaved stereo samples through filters in double precision.
+void filterReference(const std::vector<Filter>& filters, std::vector<double>& samples)
+{
+    for (const auto& filter : filters) {
+        double c[5];
+        biquadCoeffs(filter, 44100, c);
+        for (std::size_t ch = 0; ch < 2; ++ch) {
+            double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+            for (std::size_t i = ch; i < samples.size(); i += 2) {
+                const double y = c[0]*samples[i] + c[1]*x1 + c[2]*x2 - c[3]*y1 - c[4]*y2;
+                x2 = x1;
+                x1 = samples[i];
+                y2 = y1;
+                y1 = y;
+                samples[i] = y;
+            }
+        }
+    }
+}
+
+// Fixed point cascades follow a double precision reference within rounding.
+void testFixedPoint()
+{
+    // Fixed point nodes only link to nodes of same sample type.
+    static_assert(core::Cap::canIntersect(audio::PeqInt16::caps(), audio::CrossoverInt16::caps()));
+    static_assert(core::Cap::canIntersect(audio::PeqInt32::caps(), audio::CrossoverInt32::caps()));
+    static_assert(!core::Cap::canIntersect(audio::PeqInt16::caps(), audio::Crossover::caps()));
+    static_assert(!core::Cap::canIntersect(audio::PeqInt16::caps(), audio::PeqInt32::caps()));
+
+    const std::vector<Filter> filters {
+        { coro::FilterType::HighPass, 40.0, 0.0, 0.707 },
+        { coro::FilterType::Peak, 100.0, 6.0, 1.414 },
+        { coro::FilterType::Peak, 1000.0, -6.0, 2.0 },
+        { coro::FilterType::HighShelf, 8000.0, 3.0, 0.707 }
+    };
+    const auto noise = generateWhiteNoise<float>(1);
+
+    audio::TBiquadCascade<int16_t> i16(2, 44100);
+    audio::TBiquadCascade<int32_t> i32(2, 44100);
+    i16.setFilters(filters);
+    i32.setFilters(filters);
+    assert(i16.sectionCount() == filters.size() && i32.sectionCount() == filters.size());
+
+    // -12 dBFS, so no stage clips
+    std::vector<double> reference(noise.size());
+    std::vector<int16_t> i16Data(noise.size());
+    std::vector<int32_t> i32Data(noise.size());
+    for (std::size_t i = 0; i < noise.size(); ++i) {
+        i16Data[i] = std::lround(noise[i] * 0.25f * 32768.0f);
+        i32Data[i] = i16Data[i] * 65536;
+        reference[i] = i16Data[i];
+    }
+    filterReference(filters, reference);
+    i16.process(i16Data.data(), i16Data.data(), noise.size()/2, 2, 2);
+    i32.process(i32Data.data(), i32Data.data(), noise.size()/2, 2, 2);
+
+    // In LSB of int16
+    for (std::size_t i = 0; i < noise.size(); ++i) {
+        assert(std::abs(i16Data[i] - reference[i]) <= 1.0);
+        assert(std::abs(i32Data[i] / 65536.0 - reference[i]) <= 0.25);
+    }
+
+    // Output saturates instead of wrapping around
+    audio::TBiquadCascade<int16_t> loud(1, 44100);
+    loud.setGain(4.0f);
+    int16_t samples[4] = { 32767, -32768, 10000, -10000 };
+    loud.process(samples, samples, 4, 1, 1);
+    assert(samples[0] == 32767 && samples[1] == -32768 && samples[2] == 32767 && samples[3] == -32768);
+
+    // Boosts beyond +18 dB fit into feed-forward coefficients (no clamping)
+    for (float g : { 20.0f, 24.0f, 28.0f }) {
+        const std::vector<Filter> shelf { { coro::FilterType::HighShelf, 2000.0, g, 0.707 } };
+        audio::TBiquadCascade<int32_t> boost(2, 44100);
+        boost.setFilters(shelf);
+        // -40 dBFS, so boosted output does not clip
+        std::vector<int32_t> boostData(noise.size());
+        for (std::size_t i = 0; i < noise.size(); ++i) {
+            boostData[i] = std::lround(noise[i] * 0.01f * 32768.0f) * 65536;
+            reference[i] = boostData[i] / 65536.0;
+        }
+        filterReference(shelf, reference);
+        boost.process(boostData.data(), boostData.data(), noise.size()/2, 2, 2);
+        for (std::size_t i = 0; i < noise.size(); ++i) {
+            assert(std::abs(boostData[i] / 65536.0 - reference[i]) <= 0.25);
+        }
+    }
+
+    // Clamped coefficients at full scale saturate instead of overflowing
+    audio::TBiquadCascade<int32_t> clamped(1, 44100);
+    clamped.setFilters({ { coro::FilterType::HighShelf, 2000.0, 48.0, 0.707 },
+                         { coro::FilterType::HighShelf, 2000.0, 48.0, 0.707 } });
+    std::vector<int32_t> nyquist(64);
+    for (std::size_t i = 0; i < nyquist.size(); ++i) {
+        nyquist[i] = i % 2 ? INT32_MIN : INT32_MAX;
+    }
+    clamped.process(nyquist.data(), nyquist.data(), nyquist.size(), 1, 1);
+    for (std::size_t i = 8; i < nyquist.size(); ++i) {
+        assert(nyquist[i] == (i % 2 ? INT32_MIN : INT32_MAX));
+    }
+}
+
+// Presets from the bank behave like filters set directly, without computing
+// coefficients on switch.
+template <typename T>
+void testCoefficientBank()
+{
+    const std::vector<Filter> presetA {
+        { coro::FilterType::Peak, 100.0, 6.0, 1.414 },
+        { coro::FilterType::HighShelf, 8000.0, -3.0, 0.707 }
+    };
+    const std::vector<Filter> presetB {
+        { coro::FilterType::HighPass, 40.0, 0.0, 0.707 },
+        { coro::FilterType::Peak, 1000.0, -6.0, 2.0 },
+        { coro::FilterType::LowShelf, 200.0, 4.0, 0.707 }
+    };
+    audio::TCoefficientBank<T> bank;
+    bank.setPreset("a", presetA);
+    bank.setPreset("b", presetB);
+    assert(bank.preset("c") == nullptr);
+    assert(bank.presetNames() == std::vector<std::string>({ "a", "b" }));
+
+    const auto noise = generateWhiteNoise<float>(1);
+    std::vector<T> input(noise.size());
+    for (std::size_t i = 0; i < noise.size(); ++i) {
+        if constexpr (std::is_floating_point<T>::value) {
+            input[i] = noise[i] * 0.25f;
+        } else {
+            input[i] = noise[i] * 0.25f * std::numeric_limits<T>::max();
+        }
+    }
+    // Frames per part, run with three settings
+    const uint32_t part = input.size()/6;
+
+    auto run = [&](auto&& switchPreset) {
+        audio::TBiquadCascade<T> cascade(2, 44100);
+        cascade.setFilters(presetA);
+        auto data = input;
+        cascade.process(data.data(), data.data(), part, 2, 2);
+        switchPreset(cascade);
+        cascade.process(data.data() + part*2, data.data() + part*2, part, 2, 2);
+        // Rate change picks precomputed coefficients as well
+        cascade.setRate(48000);
+        cascade.process(data.data() + part*4, data.data() + part*4, part, 2, 2);
+        return data;
+    };
+
+    // History is kept across switch, output matches setting filters directly.
+    const auto direct = run([&](audio::TBiquadCascade<T>& cascade) { cascade.setFilters(presetB); });
+    const auto preset = run([&](audio::TBiquadCascade<T>& cascade) {
+        cascade.setPreset(bank.preset("b"));
+        assert(cascade.filters().size() == presetB.size());
+    });
+    assert(direct == preset);
+
+    // Gain is folded into preset's first section
+    audio::TBiquadCascade<T> withGain(2, 44100);
+    audio::TBiquadCascade<T> withPreset(2, 44100);
+    withGain.setGain(0.5f);
+    withGain.setFilters(presetA);
+    withPreset.setGain(0.5f);
+    withPreset.setPreset(bank.preset("a"));
+    auto gainData = input;
+    auto presetData = input;
+    withGain.process(gainData.data(), gainData.data(), part, 2, 2);
+    withPreset.process(presetData.data(), presetData.data(), part, 2, 2);
+    // Gain is applied to quantized coefficients, so fixed point differs by rounding (-100 dB)
+    const double tolerance = std::is_floating_point<T>::value ? 1e-6 : std::max(1.0, 1e-5 * std::numeric_limits<T>::max());
+    for (std::size_t i = 0; i < part*2; ++i) {
+        assert(std::fabs(double(gainData[i]) - presetData[i]) <= tolerance);
+    }
+
+    // Replaced presets are released, once the cascade does not use them anymore.
+    audio::TCoefficientBank<T> otherBank;
+    std::weak_ptr<const audio::TCoefficientSet<T>> replaced = otherBank.setPreset("a", presetA);
+    otherBank.setPreset("b", presetB);
+    audio::TBiquadCascade<T> cascade(2, 44100);
+    T frame[2] = {};
+    cascade.setPreset(otherBank.preset("a"));
+    cascade.process(frame, frame, 1, 2, 2);
+    otherBank.setPreset("a", presetB);
+    assert(!replaced.expired());
+    cascade.setPreset(otherBank.preset("a"));
+    // Audio thread might not have picked up the new one yet
+    assert(!replaced.expired());
+    cascade.process(frame, frame, 1, 2, 2);
+    cascade.setPreset(otherBank.preset("b"));
+    assert(replaced.expired());
+}
+
+void runCoefficientBankBenchmark()
+{
+    std::vector<Filter> filters;
+    for (float f = 31.25f; f < 20000.0f; f *= 2.0f) {
+        filters.push_back({ FilterType::Peak, f, 6.0, 4.0 });
+    }
+    audio::CoefficientBank bank;
+    const auto preset = bank.setPreset("preset", filters);
+    audio::BiquadCascade cascade(2, 44100);
+    float frame[2] = { 0.0f, 0.0f };
+
+    const std::size_t count = 10000;
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        cascade.setFilters(filters);
+        cascade.setRate(i % 2 ? 48000 : 44100);
+    }
+    const std::chrono::duration<double> computeTime = std::chrono::steady_clock::now() - begin;
+    begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        cascade.setPreset(preset);
+        cascade.setRate(i % 2 ? 48000 : 44100);
+        cascade.process(frame, frame, 1, 2, 2);
+    }
+    const std::chrono::duration<double> presetTime = std::chrono::steady_clock::now() - begin;
+
+    std::cout << "Sections: " << filters.size()
+              << ", switch (compute): " << computeTime.count() * 1e6 / count << " us"
+              << ", switch (preset): " << presetTime.count() * 1e6 / count << " us"
+              << std::endl;
+}
+
 int main()
 {
+    std::cout << std::endl << "#### Fixed point test ####" << std::endl;
+    testFixedPoint();
+
+    std::cout << std::endl << "#### Coefficient bank test ####" << std::endl;
+    testCoefficientBank<float>();
+    testCoefficientBank<int16_t>();
+    testCoefficientBank<int32_t>();
+    runCoefficientBankBenchmark();
+
+    std::cout << std::endl << "#### Cascade benchmark ####" << std::endl;
+    runCascadeBenchmark();
+
+    std::cout << std::endl << "#### SIMD benchmark ####" << std::endl;
+    for (std::uint8_t channelCount : { 1, 2, 3, 4, 6, 8 }) {
+        runSimdBenchmark(channelCount);
+    }
+
     // Init
     std::cout << std::endl << "#### Float/Float test ####" << std::endl;
     runTest<float,float>("testFloatFloat.raw", 100);
@@ -1,4 +1,217 @@
+#include <coro/core/Buffer.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace coro;
+
+void testPool()
+{
+    // Buffers are served from power-of-two size classes
+    auto buffer = core::Buffer::create(100);
+    assert(buffer->capacity() >= 128);
+    auto ptr = buffer.get();
+
+    // Released buffer is reused by same thread
+    buffer.reset();
+    buffer = core::Buffer::create(128);
+    assert(buffer.get() == ptr);
+
+    // Released buffer is cleared
+    buffer->acquire(16);
+    buffer->commit(16);
+    buffer.reset();
+    buffer = core::Buffer::create(128);
+    assert(buffer.get() == ptr && buffer->size() == 0);
+}
+
+void testGrownBuffer()
+{
+    // Grown buffer goes back to its class and serves the original size again
+    auto buffer = core::Buffer::create(3840);
+    auto ptr = buffer.get();
+    buffer->reserve(0, 3*3840);
+    const auto grownCapacity = buffer->capacity();
+    assert(grownCapacity >= 3*3840);
+    buffer.reset();
+    buffer = core::Buffer::create(3840);
+    assert(buffer.get() == ptr);
+    assert(buffer->capacity() == grownCapacity);
+
+    // Storage grown too much is shrunk back to its class
+    buffer->reserve(0, 20*4096);
+    buffer.reset();
+    buffer = core::Buffer::create(3840);
+    assert(buffer.get() == ptr);
+    assert(buffer->capacity() == 4096);
+
+    // Many released buffers do not pile up in pool
+    std::vector<core::BufferPtr> buffers;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 2000; ++i) {
+            buffers.push_back(core::Buffer::create(3840));
+            buffers.back()->reserve(0, 3*3840);
+        }
+        buffers.clear();
+    }
+    std::size_t reused = 0;
+    for (int i = 0; i < 2000; ++i) {
+        buffers.push_back(core::Buffer::create(3840));
+        reused += buffers.back()->capacity() > 4096;
+    }
+    // Thread cache and depot are capped, remaining ones are new
+    assert(reused > 0 && reused < 1000);
+}
+
+void testCrossThread()
+{
+    // Buffers created on one thread and released on another one end up in
+    // depot and are picked up by the creating thread again.
+    std::vector<core::BufferPtr> buffers;
+    for (int i = 0; i < 64; ++i) {
+        buffers.push_back(core::Buffer::create(4096));
+    }
+    std::vector<core::Buffer*> ptrs;
+    for (const auto& b : buffers) {
+        ptrs.push_back(b.get());
+    }
+
+    std::thread consumer([&]() {
+        buffers.clear();
+    });
+    consumer.join();
+
+    for (int i = 0; i < 16; ++i) {
+        auto buffer = core::Buffer::create(4096);
+        assert(std::find(ptrs.begin(), ptrs.end(), buffer.get()) != ptrs.end());
+        buffers.push_back(std::move(buffer));
+    }
+}
+
+void testAlignment()
+{
+    core::Buffer buffer(100);
+    assert(reinterpret_cast<uintptr_t>(buffer.data()) % core::Buffer::alignment == 0);
+
+    // Memory acquired behind payload is aligned as well
+    buffer.acquire(10);
+    buffer.commit(10);
+    auto data = buffer.acquire(20);
+    assert(reinterpret_cast<uintptr_t>(data) % core::Buffer::alignment == 0);
+}
+
+void testHeadroom()
+{
+    core::Buffer buffer(256);
+    std::memcpy(buffer.acquire(4), "data", 4);
+    buffer.commit(4);
+
+    // Reserve moves payload once, afterwards prepend does not touch it
+    buffer.reserve(8, 64);
+    assert(buffer.headroom() >= 8 && buffer.tailroom() >= 64);
+    const auto payload = buffer.data();
+    buffer.prepend("head", 4);
+    assert(buffer.data() + 4 == payload);
+    assert(std::memcmp(buffer.data(), "headdata", 8) == 0);
+
+    // Reserving available space does not reallocate
+    const auto capacity = buffer.capacity();
+    buffer.reserve(4, 64);
+    assert(buffer.capacity() == capacity);
+
+    // Neither does reserving again for each new payload (like sources do)
+    for (int i = 0; i < 4; ++i) {
+        buffer.clear();
+        buffer.reserve(8, 64);
+        assert(buffer.capacity() == capacity && buffer.headroom() >= 8 && buffer.tailroom() >= 64);
+    }
+}
+
+void testSlice()
+{
+    auto buffer = core::Buffer::create(256);
+    std::memcpy(buffer->acquire(12), "headerpayld!", 12);
+    buffer->commit(12);
+
+    // Slices share storage
+    auto slice = buffer->slice(6);
+    assert(slice->isShared() && buffer->isShared());
+    assert(slice->constData() == buffer->constData() + 6);
+    assert(slice->size() == 6);
+
+    // Trimming does not copy
+    slice->trimBack(1);
+    assert(slice->constData() == buffer->constData() + 6 && slice->size() == 5);
+
+    // Writing copies
+    slice->data()[0] = 'P';
+    assert(!slice->isShared() && !buffer->isShared());
+    assert(std::memcmp(slice->constData(), "Payld", 5) == 0);
+    assert(std::memcmp(buffer->constData(), "headerpayld!", 12) == 0);
+
+    // Storage outlives origin buffer
+    slice = buffer->slice(0, 6);
+    buffer.reset();
+    assert(!slice->isShared());
+    assert(std::memcmp(slice->constData(), "header", 6) == 0);
+}
+
+void testSegments()
+{
+    auto buffer = core::Buffer::create(256);
+    std::memcpy(buffer->acquire(7), "payload", 7);
+    buffer->commit(7);
+    const auto payload = buffer->constData();
+
+    // No headroom: headers and padding become separate segments
+    buffer->prepend("hdr2", 4);
+    buffer->prepend("hdr1", 4);
+    buffer->pad(20);
+    assert(!buffer->isContiguous());
+    assert(buffer->size() == 20 && buffer->segmentCount() == 3);
+
+    struct iovec segments[4];
+    assert(buffer->segments(segments, 4) == 3);
+    assert(segments[0].iov_len == 8 && std::memcmp(segments[0].iov_base, "hdr1hdr2", 8) == 0);
+    assert(segments[1].iov_base == payload && segments[1].iov_len == 7);
+    assert(segments[2].iov_len == 5 && std::memcmp(segments[2].iov_base, "\0\0\0\0\0", 5) == 0);
+
+    // Trimming works across segments
+    buffer->trimFront(2);
+    buffer->trimBack(6);
+    assert(buffer->size() == 12 && buffer->segmentCount() == 2);
+
+    // Contiguous access flattens
+    assert(std::memcmp(buffer->constData(), "r1hdr2payloa", 12) == 0);
+    assert(buffer->isContiguous());
+
+    // Slices keep segments
+    buffer->pad(16);
+    auto slice = buffer->slice(10);
+    assert(slice->size() == 6 && slice->segmentCount() == 2);
+
+    // Prepending into headroom stays contiguous
+    buffer->clear();
+    buffer->reserve(8, 0);
+    std::memcpy(buffer->data(), "payload", 7);
+    buffer->grow(7);
+    buffer->prepend("hdr1", 4);
+    assert(buffer->isContiguous() && buffer->segmentCount() == 1);
+    assert(std::memcmp(buffer->constData(), "hdr1payload", 11) == 0);
+}
+
 int main()
 {
+    testPool();
+    testAlignment();
+    testHeadroom();
+    testSlice();
+    testSegments();
+    testCrossThread();
+    testGrownBuffer();
+
     return 0;
 }
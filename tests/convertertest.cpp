@@ -3,73 +3,173 @@
 #undef private
 
 #include <assert.h>
+#include <chrono>
+#include <cmath>
 #include <cstring>
+#include <iostream>
+#include <random>
 #include <vector>
 
 using namespace coro;
 using namespace coro::audio;
 
-int main()
+template <typename T>
+core::BufferPtr createBuffer(const std::vector<T>& samples)
 {
-    // Create converters
-    AudioConverter<int16_t, float> m_intToFloat;
-    AudioConverter<float, int16_t> m_floatToInt;
-
-    // Create buffer
-    core::Buffer buffer;
-    uint16_t* data = (uint16_t*)buffer.acquire(5*sizeof(int16_t));
-    int16_t intData[] = { 0, 16384, -16384, -32768, 8192, 4096, 2048, 1024, 512, 256 };
-    float   floatData[] = { 0.0, 0.5, -0.5, -1.0, 0.25, 0.125 };
-    for (int i = 0; i < 5; ++i) {
-        *data = intData[i];
-        ++data;
-    }
-    buffer.commit(5*sizeof(int16_t));
+    auto buffer = core::Buffer::create(samples.size()*sizeof(T));
+    std::memcpy(buffer->acquire(samples.size()*sizeof(T)), samples.data(), samples.size()*sizeof(T));
+    buffer->commit(samples.size()*sizeof(T));
+    buffer->audioConf() = { rawCodec<T>(), SampleRate::Rate44100, Channels::Stereo };
+    return buffer;
+}
 
-    // Process buffer
-    m_intToFloat.process(AudioConf{ AudioCodec::RawInt16 }, buffer);
+template <typename T>
+std::vector<T> samples(const core::Buffer& buffer)
+{
+    assert(buffer.audioConf().codec == rawCodec<T>());
+    auto data = (const T*)buffer.constData();
+    return std::vector<T>(data, data + buffer.size()/sizeof(T));
+}
 
-    // Test buffer after conversion to float
-    assert(buffer.size() == 5*sizeof(float));
-    volatile float* fdata = (float*)buffer.data();
-    for (int i = 0; i < 5; ++i) {
-        assert(*fdata == floatData[i]);
-        ++fdata;
+// Count covers vector bodies and scalar tails.
+std::vector<int16_t> generateNoise(std::size_t count)
+{
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int16_t> dist(INT16_MIN, INT16_MAX);
+    std::vector<int16_t> samples(count);
+    for (auto& s : samples) {
+        s = dist(gen);
     }
+    samples[0] = INT16_MIN;
+    samples[1] = INT16_MAX;
+    return samples;
+}
 
-    // Process float buffer
-    m_floatToInt.process(AudioConf{ AudioCodec::RawFloat32 }, buffer);
+void testInt16Float()
+{
+    AudioConverter<int16_t, float> intToFloat;
+    AudioConverter<float, int16_t> floatToInt;
 
-    // Test buffer after conversion to int16
-    assert(buffer.size() == 5*sizeof(int16_t));
-    volatile int16_t* idata = (int16_t*)buffer.data();
-    for (int i = 0; i < 5; ++i) {
-        assert((int16_t)*idata == intData[i]);
-        ++idata;
+    const std::vector<int16_t> intData = { 0, 16384, -16384, -32768, 8192, 4096, 2048, 1024, 512, 256, 32767 };
+    auto buffer = createBuffer(intData);
+    intToFloat.onProcess(buffer);
+    const auto floatData = samples<float>(*buffer);
+    assert(floatData.size() == intData.size());
+    for (std::size_t i = 0; i < intData.size(); ++i) {
+        assert(floatData[i] == intData[i]/32768.0f);
     }
 
+    // Round trip
+    floatToInt.onProcess(buffer);
+    assert(samples<int16_t>(*buffer) == intData);
 
-    // Fill float buffer
-    float* bData = (float*)buffer.acquire(5*sizeof(float));
-    float  fData[] = { 0.5, -0.5, -1.0, 1.1, -1.1 };
-    for (int i = 0; i < 5; ++i) {
-        *bData = fData[i];
-        ++bData;
-    }
-    buffer.commit(5*sizeof(float));
-
-    // Process float buffer
-    m_floatToInt.process(AudioConf{ AudioCodec::RawFloat32 }, buffer);
-
-    std::vector<int16_t> overShoots;
-    // Test buffer after conversion to int16
-    assert(buffer.size() == 5*sizeof(int16_t));
-    idata = (int16_t*)buffer.data();
-    for (int i = 0; i < 5; ++i) {
-        int16_t j = *idata;
-        overShoots.push_back(j);
-        ++idata;
+    // Saturation and rounding, in place
+    buffer = createBuffer<float>({ 0.5f, -0.5f, -1.0f, 1.0f, 1.1f, -1.1f, 1e10f, -1e10f, 0.4f/32768.0f, 0.6f/32768.0f, -0.6f/32768.0f });
+    const auto data = buffer->constData();
+    floatToInt.onProcess(buffer);
+    assert(buffer->constData() == data);
+    assert((samples<int16_t>(*buffer) == std::vector<int16_t> { 16384, -16384, -32768, 32767, 32767, -32768, 32767, -32768, 0, 1, -1 }));
+}
+
+void testInt32()
+{
+    AudioConverter<int32_t, int16_t> toInt16;
+    auto buffer = createBuffer<int32_t>({ INT32_MAX, INT32_MIN, 0x8000, 0x7fff, -0x8000, -0x8001, 0x12345678 });
+    toInt16.onProcess(buffer);
+    assert((samples<int16_t>(*buffer) == std::vector<int16_t> { 32767, -32768, 1, 0, 0, -1, 0x1234 }));
+
+    AudioConverter<float, int32_t> toInt32;
+    buffer = createBuffer<float>({ 1.0f, -1.0f, 0.5f, 0.0f, 2.0f });
+    toInt32.onProcess(buffer);
+    assert((samples<int32_t>(*buffer) == std::vector<int32_t> { 2147483520, INT32_MIN, 1 << 30, 0, 2147483520 }));
+}
+
+// int16 -> S24_3LE -> float -> S24_LE -> int32 -> int16 is lossless.
+void testRoundTrip()
+{
+    const auto input = generateNoise(1003);
+    auto buffer = createBuffer(input);
+
+    AudioConverter<int16_t, Int24Packed> toPacked;
+    toPacked.onProcess(buffer);
+    assert(buffer->audioConf().codec == AudioCodec::RawInt24Packed);
+    assert(buffer->size() == input.size()*3);
+    auto bytes = (const uint8_t*)buffer->constData();
+    assert(bytes[0] == 0x00 && bytes[1] == 0x00 && bytes[2] == 0x80);   // INT16_MIN
+    assert(bytes[3] == 0x00 && bytes[4] == 0xff && bytes[5] == 0x7f);   // INT16_MAX
+
+    AudioConverter<Int24Packed, float> toFloat;
+    toFloat.onProcess(buffer);
+    AudioConverter<float, Int24> toInt24;
+    toInt24.onProcess(buffer);
+    auto int24 = (const int32_t*)buffer->constData();
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        assert(int24[i] == input[i] * 256);
     }
+    AudioConverter<Int24, int32_t> toInt32;
+    toInt32.onProcess(buffer);
+    AudioConverter<int32_t, int16_t> toInt16;
+    toInt16.onProcess(buffer);
+    assert(samples<int16_t>(*buffer) == input);
+
+    // 24 bit saturates and rounds
+    buffer = createBuffer<int32_t>({ INT32_MAX, INT32_MIN, 0x80, 0x7f, -0x81 });
+    AudioConverter<int32_t, Int24Packed> toPacked32;
+    toPacked32.onProcess(buffer);
+    bytes = (const uint8_t*)buffer->constData();
+    const std::vector<uint8_t> expected = { 0xff, 0xff, 0x7f,  0x00, 0x00, 0x80,  0x01, 0x00, 0x00,
+                                            0x00, 0x00, 0x00,  0xff, 0xff, 0xff };
+    assert(std::vector<uint8_t>(bytes, bytes + buffer->size()) == expected);
+
+    // Mismatching codec passes through
+    buffer = createBuffer(input);
+    toFloat.onProcess(buffer);
+    assert(samples<int16_t>(*buffer) == input);
+}
+
+void runBenchmark()
+{
+    const auto input = generateNoise(1 << 16);
+    std::vector<float> floats(input.size());
+    std::vector<int16_t> ints(input.size());
+
+    auto bestTime = [&](auto&& run) {
+        double best = 1e9;
+        for (int i = 0; i < 20; ++i) {
+            const auto begin = std::chrono::steady_clock::now();
+            run();
+            const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - begin;
+            best = std::min(best, diff.count());
+        }
+        return best;
+    };
+    // Former implementation
+    const auto scalarTime = bestTime([&]() {
+        for (std::size_t i = 0; i < input.size(); ++i) {
+            int16_t tmp;
+            std::memcpy(&tmp, input.data() + i, 2);
+            float f = tmp/32767.0;
+            std::memcpy(floats.data() + i, &f, 4);
+        }
+        for (std::size_t i = 0; i < input.size(); ++i) {
+            const float f = floats[i];
+            ints[i] = f >= 1.0f ? 32767 : (f < -1.0f ? -32768 : (int16_t)(f*32767.0f));
+        }
+    });
+    const auto simdTime = bestTime([&]() {
+        convert((const char*)input.data(), AudioCodec::RawInt16, (char*)floats.data(), AudioCodec::RawFloat32, input.size());
+        convert((const char*)floats.data(), AudioCodec::RawFloat32, (char*)ints.data(), AudioCodec::RawInt16, input.size());
+    });
+    std::cout << "Samples: " << input.size() << " (int16 -> float -> int16), scalar: " << scalarTime
+              << ", simd: " << simdTime << ", speed-up: " << scalarTime/simdTime << std::endl;
+}
+
+int main()
+{
+    testInt16Float();
+    testInt32();
+    testRoundTrip();
+    runBenchmark();
 
     return 0;
 }
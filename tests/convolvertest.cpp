@@ -0,0 +1,164 @@
+#include <coro/audio/Convolver.h>
+#include <coro/audio/PartitionedConvolver.h>
+#include <coro/core/AppSink.h>
+
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace coro;
+
+std::vector<float> generateNoise(std::size_t count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> samples(count);
+    for (auto& s : samples) {
+        s = dist(gen);
+    }
+    return samples;
+}
+
+// Decaying noise, like a measured room response
+std::vector<float> generateImpulseResponse(std::size_t taps, unsigned seed)
+{
+    auto ir = generateNoise(taps, seed);
+    for (std::size_t i = 0; i < taps; ++i) {
+        ir[i] *= std::exp(-5.0f*i/taps);
+    }
+    return ir;
+}
+
+// Compares against direct convolution, input is fed in chunks of varying size.
+void testConvolution(std::size_t blockSize, std::size_t tailBlockSize, std::vector<std::size_t> taps)
+{
+    const std::size_t channelCount = taps.size();
+    const std::size_t frameCount = 6000;
+
+    std::vector<std::vector<float>> irs;
+    for (std::size_t ch = 0; ch < channelCount; ++ch) {
+        irs.push_back(generateImpulseResponse(taps[ch], ch+1));
+    }
+    audio::PartitionedConvolver convolver(blockSize, tailBlockSize);
+    convolver.setImpulseResponses(irs);
+    assert(convolver.channelCount() == channelCount);
+    assert(convolver.latency() == blockSize);
+
+    const auto input = generateNoise(frameCount*channelCount, 42);
+    auto output = input;
+    std::size_t pos = 0;
+    for (std::size_t chunk = 1; pos < frameCount; chunk = chunk*7 % 251) {
+        const std::size_t n = std::min(chunk, frameCount - pos);
+        convolver.process(output.data() + pos*channelCount, output.data() + pos*channelCount, n);
+        pos += n;
+    }
+
+    const std::size_t latency = convolver.latency();
+    for (std::size_t ch = 0; ch < channelCount; ++ch) {
+        for (std::size_t i = 0; i < frameCount; ++i) {
+            double ref = 0.0;
+            for (std::size_t t = 0; t < irs[ch].size() && t + latency <= i; ++t) {
+                ref += irs[ch][t] * input[(i - latency - t)*channelCount + ch];
+            }
+            assert(std::fabs(output[i*channelCount + ch] - ref) <= 1e-3);
+        }
+    }
+}
+
+void testNode()
+{
+    const audio::AudioConf conf { audio::AudioCodec::RawFloat32, audio::SampleRate::Rate48000, audio::Channels::Stereo };
+    audio::Convolver convolver(32);
+    core::AppSink sink;
+    core::Node::link(convolver, sink);
+
+    std::vector<float> received;
+    sink.setProcessCallback([&](const audio::AudioConf&, core::Buffer& buffer) {
+        auto data = (const float*)buffer.constData();
+        received.assign(data, data + buffer.size()/sizeof(float));
+    });
+
+    auto process = [&](const std::vector<float>& samples) {
+        const size_t bytes = samples.size()*sizeof(float);
+        auto buffer = core::Buffer::create(bytes);
+        std::memcpy(buffer->acquire(bytes), samples.data(), bytes);
+        buffer->commit(bytes);
+        buffer->audioConf() = conf;
+        convolver.process(buffer);
+        return received;
+    };
+
+    // No impulse responses: pass through
+    const auto input = generateNoise(256, 1);
+    assert(process(input) == input);
+
+    // Gain of 0.5 on left, one frame delay on right
+    convolver.setImpulseResponses({ { 0.5f }, { 0.0f, 1.0f } }, 48000);
+    const auto output = process(input);
+    assert(output.size() == input.size());
+    for (std::size_t i = 32 + 1; i < 128; ++i) {
+        assert(std::fabs(output[i*2] - 0.5f*input[(i-32)*2]) <= 1e-5f);
+        assert(std::fabs(output[i*2+1] - input[(i-33)*2+1]) <= 1e-5f);
+    }
+
+    // Rate mismatch: pass through
+    convolver.setImpulseResponses({ { 0.5f }, { 0.0f, 1.0f } }, 44100);
+    assert(process(input) == input);
+}
+
+// Reports CPU load for processing a stereo stream at 48 kHz. Since a block
+// has to be done within its period, the worst block counts as well.
+void runBenchmark(std::size_t taps, std::size_t blockSize, std::size_t tailBlockSize)
+{
+    const std::size_t rate = 48000;
+    const std::size_t frameCount = rate/2;
+    audio::PartitionedConvolver convolver(blockSize, tailBlockSize);
+    convolver.setImpulseResponses({ generateImpulseResponse(taps, 1), generateImpulseResponse(taps, 2) });
+
+    auto data = generateNoise(frameCount*2, 3);
+    double total = 0.0;
+    double worst = 0.0;
+    for (std::size_t pos = 0; pos + blockSize <= frameCount; pos += blockSize) {
+        const auto begin = std::chrono::steady_clock::now();
+        convolver.process(data.data() + pos*2, data.data() + pos*2, blockSize);
+        const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - begin;
+        total += diff.count();
+        worst = std::max(worst, diff.count());
+    }
+
+    std::cout << "Taps: " << std::setw(5) << taps
+              << ", block: " << std::setw(4) << blockSize
+              << ", tail block: " << std::setw(4) << tailBlockSize
+              << ", CPU load: " << std::fixed << std::setprecision(2) << 100.0 * total * rate / frameCount << " %"
+              << ", worst block: " << 100.0 * worst * rate / blockSize << " %"
+              << std::endl;
+}
+
+int main()
+{
+    std::cout << "#### Convolution test ####" << std::endl;
+    testConvolution(64, 0, { 1000, 700 });
+    testConvolution(64, 0, { 1000, 64, 1 });
+    testConvolution(32, 256, { 1500, 300 });
+    testConvolution(32, 256, { 1500, 200, 2000 });
+    // Tail partitions spread unevenly across blocks
+    testConvolution(32, 128, { 5000, 700 });
+    testNode();
+
+    std::cout << std::endl << "#### Convolution benchmark ####" << std::endl;
+    for (std::size_t taps : { 8192, 16384, 32768, 65536 }) {
+        for (std::size_t blockSize : { 64, 256, 1024 }) {
+            runBenchmark(taps, blockSize, 0);
+        }
+        runBenchmark(taps, 64, 1024);
+        runBenchmark(taps, 128, 2048);
+    }
+
+    return 0;
+}
@@ -0,0 +1,245 @@
+#include <coro/audio/BandSplitter.h>
+#include <coro/audio/BiquadCascade.h>
+#include <coro/audio/Crossover.h>
+#include <coro/core/AppSink.h>
+
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace coro;
+
+static const std::size_t frameCount = 44100/4;
+
+std::vector<float> generateNoise(std::size_t count)
+{
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> dist(-0.25f, 0.25f);
+    std::vector<float> samples(count);
+    for (auto& s : samples) {
+        s = dist(gen);
+    }
+    return samples;
+}
+
+// Runs stereo input through a crossover node and returns output with its channels.
+template <typename T>
+std::pair<audio::ChannelFlags, std::vector<T>> process(audio::TCrossover<T>& crossover, const std::vector<T>& input)
+{
+    core::AppSink sink;
+    core::Node::link(crossover, sink);
+
+    std::pair<audio::ChannelFlags, std::vector<T>> received;
+    sink.setProcessCallback([&](const audio::AudioConf& conf, core::Buffer& buffer) {
+        auto data = (const T*)buffer.constData();
+        received.first = conf.channels;
+        received.second.assign(data, data + buffer.size()/sizeof(T));
+    });
+
+    const size_t bytes = input.size()*sizeof(T);
+    auto buffer = core::Buffer::create(bytes);
+    std::memcpy(buffer->acquire(bytes), input.data(), bytes);
+    buffer->commit(bytes);
+    buffer->audioConf() = { audio::rawCodec<T>(), audio::SampleRate::Rate44100, audio::Channels::Stereo };
+    crossover.process(buffer);
+
+    return received;
+}
+
+// Runs interleaved input through a cascade of filters.
+std::vector<float> filter(const std::vector<Filter>& filters, std::vector<float> data, uint8_t channelCount, float gain = 1.0f)
+{
+    audio::BiquadCascade cascade(channelCount, 44100);
+    cascade.setFilters(filters);
+    cascade.setGain(gain);
+    cascade.process(data.data(), data.data(), data.size()/channelCount, channelCount, channelCount);
+    return data;
+}
+
+// Bands sum up to the all-pass chain of all crossover points.
+void testAllPassSum(const std::vector<Filter>& filters, audio::ChannelFlags channels)
+{
+    audio::Crossover crossover;
+    crossover.setFilters(filters);
+    const auto input = generateNoise(frameCount*2);
+    const auto output = process(crossover, input);
+    assert(output.first == channels);
+
+    const std::size_t channelCount = audio::toInt(channels);
+    assert(output.second.size() == frameCount*channelCount);
+
+    std::vector<Filter> allPasses;
+    for (const auto& f : filters) {
+        allPasses.push_back({ FilterType::AllPass, f.f, 0.0f, f.q });
+    }
+    const auto reference = filter(allPasses, input, 2);
+    for (std::size_t i = 0; i < frameCount; ++i) {
+        for (std::size_t ch = 0; ch < 2; ++ch) {
+            float sum = 0.0f;
+            for (std::size_t band = 0; band < channelCount/2; ++band) {
+                sum += output.second[i*channelCount + band*2 + ch];
+            }
+            assert(std::fabs(sum - reference[i*2 + ch]) < 5e-4f);
+        }
+    }
+}
+
+void testGainAndLfe()
+{
+    const Filter f { FilterType::Crossover, 2000.0f, 6.0f, 0.707f };
+    audio::Crossover crossover;
+    crossover.setFilter(f);
+    crossover.setLfe(true);
+    const auto input = generateNoise(frameCount*2);
+    const auto output = process(crossover, input);
+    assert(output.first == audio::ChannelFlags(audio::Channels::Surround41));
+
+    // Low band: LFE high-pass, LR4 low-pass and attenuated by 6 dB
+    const Filter lfeHp { FilterType::HighPass, audio::Crossover::lfeFrequency, 0.0f, float(M_SQRT1_2) };
+    const Filter lp { FilterType::LowPass, f.f, 0.0f, f.q };
+    const Filter hp { FilterType::HighPass, f.f, 0.0f, f.q };
+    const auto low = filter({ lfeHp, lfeHp, lp, lp }, input, 2, std::pow(10.0f, -6.0f/20.0f));
+    const auto high = filter({ hp, hp }, input, 2);
+
+    // LFE: mono sum, low-passed
+    const Filter lfeLp { FilterType::LowPass, audio::Crossover::lfeFrequency, 0.0f, float(M_SQRT1_2) };
+    std::vector<float> mono(frameCount);
+    for (std::size_t i = 0; i < frameCount; ++i) {
+        mono[i] = (input[i*2] + input[i*2+1]) * float(M_SQRT1_2);
+    }
+    const auto lfe = filter({ lfeLp, lfeLp }, mono, 1);
+
+    for (std::size_t i = 0; i < frameCount; ++i) {
+        const float* frame = output.second.data() + i*5;
+        for (std::size_t ch = 0; ch < 2; ++ch) {
+            assert(std::fabs(frame[ch] - low[i*2+ch]) < 1e-5f);
+            assert(std::fabs(frame[2+ch] - high[i*2+ch]) < 1e-5f);
+        }
+        assert(std::fabs(frame[4] - lfe[i]) < 1e-5f);
+    }
+
+    // LFE only (2.1)
+    crossover.setFilters({});
+    assert(process(crossover, input).first == audio::ChannelFlags(audio::Channels::Surround21));
+
+    // Neither: pass through
+    crossover.setLfe(false);
+    assert(process(crossover, input).second == input);
+}
+
+// Fixed point bands sum up like float ones (within rounding of each band).
+void testFixedPoint()
+{
+    const std::vector<Filter> filters {
+        { FilterType::Crossover, 300.0f, 0.0f, 0.707f },
+        { FilterType::Crossover, 3000.0f, 0.0f, 0.707f }
+    };
+    audio::CrossoverInt16 crossover;
+    crossover.setFilters(filters);
+    const auto noise = generateNoise(frameCount*2);
+    std::vector<int16_t> input(noise.size());
+    std::vector<float> scaled(noise.size());
+    for (std::size_t i = 0; i < noise.size(); ++i) {
+        input[i] = std::lround(noise[i] * 32768.0f);
+        scaled[i] = input[i];
+    }
+    const auto output = process(crossover, input);
+    assert(output.first == audio::ChannelFlags(audio::Channels::Hexa));
+
+    const auto reference = filter({ { FilterType::AllPass, 300.0f, 0.0f, 0.707f },
+                                    { FilterType::AllPass, 3000.0f, 0.0f, 0.707f } }, scaled, 2);
+    for (std::size_t i = 0; i < frameCount*2; ++i) {
+        const std::size_t frame = i/2, ch = i%2;
+        float sum = 0.0f;
+        for (std::size_t band = 0; band < 3; ++band) {
+            sum += output.second[frame*6 + band*2 + ch];
+        }
+        assert(std::fabs(sum - reference[i]) <= 4.0f);
+    }
+}
+
+// Compares fused splitting against one cascade pass per band with strided writes.
+void runBenchmark(std::size_t wayCount)
+{
+    std::vector<Filter> points;
+    for (std::size_t i = 1; i < wayCount; ++i) {
+        points.push_back({ FilterType::Crossover, 200.0f * std::pow(8.0f, float(i-1)), 0.0f, 0.707f });
+    }
+    audio::Crossover crossover;
+    crossover.setFilters(points);
+
+    // Same band filters as the crossover
+    std::vector<std::vector<Filter>> bands(wayCount);
+    for (std::size_t i = 0; i < wayCount; ++i) {
+        for (std::size_t j = 0; j < points.size(); ++j) {
+            const auto type = j < i ? FilterType::HighPass : (j == i ? FilterType::LowPass : FilterType::AllPass);
+            bands[i].push_back({ type, points[j].f, 0.0f, points[j].q });
+            if (type != FilterType::AllPass) {
+                bands[i].push_back(bands[i].back());
+            }
+        }
+    }
+    std::vector<audio::BiquadCascade> cascades(wayCount);
+    audio::BandSplitter splitter;
+    std::vector<audio::BandSplitter::Output> outputs;
+    for (std::size_t i = 0; i < wayCount; ++i) {
+        cascades[i].setFilters(bands[i]);
+        outputs.push_back({ { 1.0f, 0.0f }, bands[i], 1.0f });
+        outputs.push_back({ { 0.0f, 1.0f }, bands[i], 1.0f });
+    }
+    splitter.setOutputs(outputs);
+
+    const auto input = generateNoise(frameCount*2);
+    std::vector<float> output(frameCount*wayCount*2);
+    auto bestTime = [&](auto&& run) {
+        double best = 1e9;
+        for (int i = 0; i < 5; ++i) {
+            const auto begin = std::chrono::steady_clock::now();
+            run();
+            const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - begin;
+            best = std::min(best, diff.count());
+        }
+        return best;
+    };
+    const auto separateTime = bestTime([&]() {
+        for (std::size_t i = 0; i < wayCount; ++i) {
+            cascades[i].process(input.data(), output.data() + i*2, frameCount, 2, wayCount*2);
+        }
+    });
+    const auto fusedTime = bestTime([&]() {
+        splitter.process(input.data(), output.data(), frameCount);
+    });
+
+    std::cout << "Ways: " << wayCount
+              << ", separate: " << separateTime
+              << ", fused: " << fusedTime
+              << ", speed-up: " << separateTime/fusedTime << std::endl;
+}
+
+int main()
+{
+    std::cout << "#### Crossover test ####" << std::endl;
+    testAllPassSum({ { FilterType::Crossover, 2000.0f, 0.0f, 0.707f } }, audio::Channels::Quad);
+    testAllPassSum({ { FilterType::Crossover, 2000.0f, 0.0f, 0.5f } }, audio::Channels::Quad);
+    testAllPassSum({ { FilterType::Crossover, 3000.0f, 0.0f, 0.707f },
+                     { FilterType::Crossover, 300.0f, 0.0f, 0.707f } }, audio::Channels::Hexa);
+    testAllPassSum({ { FilterType::Crossover, 300.0f, 0.0f, 0.5f },
+                     { FilterType::Crossover, 3000.0f, 0.0f, 0.5f } }, audio::Channels::Hexa);
+    testAllPassSum({ { FilterType::Crossover, 100.0f, 0.0f, 0.707f },
+                     { FilterType::Crossover, 1000.0f, 0.0f, 0.707f },
+                     { FilterType::Crossover, 8000.0f, 0.0f, 0.707f } }, audio::Channels::Octo);
+    testGainAndLfe();
+    testFixedPoint();
+
+    std::cout << std::endl << "#### Crossover benchmark ####" << std::endl;
+    for (std::size_t ways : { 2, 3, 4 }) {
+        runBenchmark(ways);
+    }
+
+    return 0;
+}
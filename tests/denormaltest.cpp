@@ -0,0 +1,122 @@
+#include <coro/audio/Crossover.h>
+#include <coro/audio/Denormals.h>
+#include <coro/audio/Peq.h>
+#include <loguru/loguru.hpp>
+
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace coro;
+
+static const audio::AudioConf conf { audio::AudioCodec::RawFloat32, audio::SampleRate::Rate48000, audio::Channels::Stereo };
+static const size_t frameCount = 480;
+
+struct Times {
+    double burst = 0.0;
+    double silence = 0.0;
+};
+
+// Feeds a loud burst, followed by silence through Peq and Crossover and
+// returns mean time per buffer of both phases.
+Times run(audio::DenormalMode mode)
+{
+    audio::setDenormalMode(mode);
+
+    audio::Peq peq;
+    std::vector<Filter> filters;
+    for (float f = 31.25f; f < 20000.0f; f *= 2.0f) {
+        filters.push_back({ FilterType::Peak, f, 6.0, 4.0 });
+    }
+    peq.setFilters(filters);
+    audio::Crossover crossover;
+    crossover.setFilter({ FilterType::Crossover, 2000.0f, 0.0f, 0.707f });
+    core::Node::link(peq, crossover);
+
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> loud(frameCount*2);
+    std::vector<float> silence(frameCount*2, 0.0f);
+
+    auto process = [&](const std::vector<float>& samples) {
+        const size_t bytes = samples.size()*sizeof(float);
+        auto buffer = core::Buffer::create(bytes);
+        std::memcpy(buffer->acquire(bytes), samples.data(), bytes);
+        buffer->commit(bytes);
+        buffer->audioConf() = conf;
+
+        const auto begin = std::chrono::steady_clock::now();
+        peq.process(buffer);
+        const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - begin;
+        return diff.count();
+    };
+
+    Times times;
+    const size_t burstBuffers = 100;
+    for (size_t i = 0; i < burstBuffers; ++i) {
+        for (auto& s : loud) {
+            s = dist(gen);
+        }
+        times.burst += process(loud);
+    }
+    times.burst /= burstBuffers;
+
+    // History needs a while to decay into denormals. Measure the last second.
+    const size_t silenceBuffers = 2000;
+    for (size_t i = 0; i < silenceBuffers; ++i) {
+        const auto t = process(silence);
+        if (i >= silenceBuffers - 100) {
+            times.silence += t;
+        }
+    }
+    times.silence /= 100;
+
+    return times;
+}
+
+int main()
+{
+    // Buffer allocations of each run would spoil the timing
+    loguru::g_stderr_verbosity = loguru::Verbosity_WARNING;
+
+    const char* names[] = { "Off", "FlushToZero", "DcOffset" };
+    for (auto mode : { audio::DenormalMode::Off, audio::DenormalMode::FlushToZero, audio::DenormalMode::DcOffset }) {
+        // Best of three runs, since timing is noisy
+        Times best { 1e9, 1e9 };
+        for (int i = 0; i < 3; ++i) {
+            const auto t = run(mode);
+            best.burst = std::min(best.burst, t.burst);
+            best.silence = std::min(best.silence, t.silence);
+        }
+        // Per buffer time stays flat (ratio near 1), when denormals are handled.
+        std::cout << names[static_cast<int>(mode)]
+                  << ": burst: " << best.burst*1e6 << " us"
+                  << ", silence: " << best.silence*1e6 << " us"
+                  << ", ratio: " << best.silence/best.burst << std::endl;
+    }
+
+    // Flush scope restores previous state of calling thread
+    audio::setDenormalMode(audio::DenormalMode::FlushToZero);
+    volatile float tiny = 1e-38f;
+    {
+        audio::ScopedDenormalFlush flush;
+        if (audio::canFlushDenormals()) {
+            assert(tiny * 0.5f == 0.0f);
+        }
+    }
+    assert(tiny * 0.5f != 0.0f);
+
+    // DC offset is only used, if requested or FTZ is not available
+    assert(audio::denormalOffset() == (audio::canFlushDenormals() ? 0.0f : 1e-20f));
+    audio::setDenormalMode(audio::DenormalMode::DcOffset);
+    assert(audio::denormalOffset() > 0.0f);
+    audio::setDenormalMode(audio::DenormalMode::Off);
+    assert(audio::denormalOffset() == 0.0f);
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include <coro/audio/AudioConverter.h>
+#include <coro/audio/Crossover.h>
+#include <coro/audio/FusedChain.h>
+#include <coro/audio/Loudness.h>
+#include <coro/audio/Peq.h>
+#include <coro/core/AppSink.h>
+#include <coro/core/Tee.h>
+
+#include <assert.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace coro;
+
+// Typical graph: int16 -> float -> loudness -> peq -> crossover -> int16
+struct Chain
+{
+    Chain() {
+        core::Node::link(fused, in);
+        core::Node::link(in, loudness);
+        core::Node::link(loudness, peq);
+        core::Node::link(peq, crossover);
+        core::Node::link(crossover, out);
+        core::Node::link(out, sink);
+
+        loudness.setLevel(40);
+        loudness.setVolume(0.8f);
+        peq.setFilters({ { FilterType::Peak, 200.0f, -6.0f, 1.4f },
+                         { FilterType::Peak, 1000.0f, 3.0f, 2.0f },
+                         { FilterType::HighShelf, 6000.0f, -3.0f, 0.7f } });
+        crossover.setFilters({ { FilterType::Crossover, 300.0f, 0.0f, 0.707f },
+                               { FilterType::Crossover, 3000.0f, 3.0f, 0.707f } });
+        crossover.setLfe(true);
+
+        sink.setProcessCallback([this](const audio::AudioConf& conf, core::Buffer& buffer) {
+            auto data = (const int16_t*)buffer.constData();
+            channels = conf.channels;
+            received.assign(data, data + buffer.size()/sizeof(int16_t));
+        });
+    }
+
+    void process(const std::vector<int16_t>& samples) {
+        const size_t bytes = samples.size()*sizeof(int16_t);
+        auto buffer = core::Buffer::create(bytes);
+        std::memcpy(buffer->acquire(bytes), samples.data(), bytes);
+        buffer->commit(bytes);
+        buffer->audioConf() = { audio::AudioCodec::RawInt16, audio::SampleRate::Rate44100, audio::Channels::Stereo };
+        fused.process(buffer);
+    }
+
+    audio::FusedChain fused;
+    audio::AudioConverter<int16_t, float> in;
+    audio::Loudness loudness;
+    audio::Peq peq;
+    audio::Crossover crossover;
+    audio::AudioConverter<float, int16_t> out;
+    core::AppSink sink;
+
+    audio::ChannelFlags channels;
+    std::vector<int16_t> received;
+};
+
+std::vector<int16_t> generateNoise(std::size_t count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int16_t> dist(-16384, 16383);
+    std::vector<int16_t> samples(count);
+    for (auto& s : samples) {
+        s = dist(gen);
+    }
+    return samples;
+}
+
+// Processes next buffer through both chains and compares (within rounding of conversion).
+void compare(Chain& reference, Chain& fused, unsigned seed)
+{
+    // Odd number of frames to cover partial blocks
+    const auto input = generateNoise(2*(3*audio::FusedChain::blockSize + 17), seed);
+    reference.process(input);
+    fused.process(input);
+    assert(reference.channels == fused.channels);
+    assert(reference.received.size() == fused.received.size());
+    for (std::size_t i = 0; i < reference.received.size(); ++i) {
+        assert(std::abs(reference.received[i] - fused.received[i]) <= 1);
+    }
+}
+
+void testFusion()
+{
+    // Reference passes through its unfused FusedChain
+    Chain reference;
+    Chain fused;
+    assert(fused.fused.compile() == 5);
+    assert(fused.fused.nodes().size() == 5);
+    assert(fused.fused.nodes().front() == &fused.in);
+    assert(fused.fused.nodes().back() == &fused.out);
+    assert(fused.fused.next() == &fused.sink);
+
+    compare(reference, fused, 1);
+    assert(fused.channels == audio::ChannelFlags(audio::Channels::Hexa | audio::Channels::Lfe));
+    assert(fused.received.size() == (3*audio::FusedChain::blockSize + 17) * 7);
+
+    // History continues across buffers
+    compare(reference, fused, 2);
+
+    // Parameters are picked up
+    for (auto chain : { &reference, &fused }) {
+        chain->loudness.setVolume(0.5f);
+        chain->peq.setFilters({ { FilterType::LowShelf, 100.0f, 6.0f, 0.7f } });
+    }
+    compare(reference, fused, 3);
+    for (auto chain : { &reference, &fused }) {
+        chain->crossover.setLfe(false);
+        chain->peq.setIsBypassed(true);
+    }
+    compare(reference, fused, 4);
+    assert(fused.channels == audio::ChannelFlags(audio::Channels::Hexa));
+    for (auto chain : { &reference, &fused }) {
+        chain->crossover.setIsBypassed(true);
+        chain->loudness.setLevel(0);
+    }
+    compare(reference, fused, 5);
+    assert(fused.channels == audio::ChannelFlags(audio::Channels::Stereo));
+
+    // Relinking undoes fusion
+    core::Node::link(fused.fused, fused.out);
+    assert(fused.fused.nodes().empty());
+    assert(fused.fused.compile() == 0);
+    assert(fused.fused.next() == &fused.out);
+}
+
+// Float chain without converters is fused up to the first unknown node.
+void testPartialFusion()
+{
+    audio::FusedChain fused;
+    audio::Peq peq;
+    audio::Loudness loudness;
+    core::Tee unfused;
+    core::Node::link(fused, peq);
+    core::Node::link(peq, loudness);
+    core::Node::link(loudness, unfused);
+    assert(fused.compile() == 2);
+    assert(fused.next() == &unfused);
+
+    // A single node is not worth fusing
+    core::Node::link(fused, unfused);
+    assert(fused.compile() == 0);
+    assert(fused.next() == &unfused);
+}
+
+void runBenchmark()
+{
+    Chain reference;
+    Chain fused;
+    fused.fused.compile();
+    const auto input = generateNoise(2*4096, 1);
+
+    auto bestTime = [&](Chain& chain) {
+        double best = 1e9;
+        for (int i = 0; i < 20; ++i) {
+            const auto begin = std::chrono::steady_clock::now();
+            chain.process(input);
+            const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - begin;
+            best = std::min(best, diff.count());
+        }
+        return best;
+    };
+    const auto referenceTime = bestTime(reference);
+    const auto fusedTime = bestTime(fused);
+    std::cout << "Frames: 4096, nodes: " << referenceTime
+              << ", fused: " << fusedTime
+              << ", speed-up: " << referenceTime/fusedTime << std::endl;
+}
+
+int main()
+{
+    std::cout << "#### Fused chain test ####" << std::endl;
+    testFusion();
+    testPartialFusion();
+
+    std::cout << std::endl << "#### Fused chain benchmark ####" << std::endl;
+    runBenchmark();
+
+    return 0;
+}
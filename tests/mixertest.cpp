@@ -0,0 +1,117 @@
+#include <coro/audio/Mixer.h>
+#include <coro/core/AppSink.h>
+
+#include <assert.h>
+#include <vector>
+
+using namespace coro;
+
+static const audio::AudioConf conf { audio::AudioCodec::RawFloat32, audio::SampleRate::Rate48000, audio::Channels::Stereo };
+
+void push(audio::MixerInput& input, float value, size_t frames)
+{
+    std::vector<float> samples(frames * 2, value);
+    core::Buffer buffer((const char*)samples.data(), samples.size() * sizeof(float));
+    input.process(conf, buffer);
+}
+
+int main()
+{
+    audio::Mixer mixer(2, 64);
+    core::AppSink sink;
+    core::Node::link(mixer, sink);
+
+    std::vector<float> received;
+    sink.setProcessCallback([&](const audio::AudioConf& conf, core::Buffer& buffer) {
+        assert(conf.codec == audio::AudioCodec::RawFloat32);
+        assert(buffer.size() == 64 * 2 * sizeof(float));
+        auto data = (const float*)buffer.constData();
+        received.insert(received.end(), data, data + buffer.size()/sizeof(float));
+    });
+
+    mixer.input(0).setGain(0.5f);
+    mixer.input(1).setGain(2.0f);
+
+    // Blocks are aligned, partial blocks are kept.
+    push(mixer.input(0), 1.0f, 100);
+    assert(received.size() == 128);
+    assert(received.front() == 0.5f && received.back() == 0.5f);
+
+    // Both inputs active: mixer waits for second input and sums both.
+    // (input 0: 136 frames, input 1: 210 frames)
+    received.clear();
+    push(mixer.input(1), 1.0f, 10);
+    push(mixer.input(0), 1.0f, 100);
+    assert(received.empty());
+    push(mixer.input(1), 1.0f, 200);
+    assert(received.size() == 2 * 128);
+    for (auto v : received) {
+        assert(v == 2.5f);
+    }
+
+    // Second input stalls: after max pending blocks, it is skipped.
+    // (input 0: 328 frames, input 1: 82 frames)
+    received.clear();
+    push(mixer.input(0), 1.0f, (audio::Mixer::maxPendingBlocks + 1) * 64);
+    assert(received.size() == 5 * 128);
+    assert(received.front() == 2.5f && received.back() == 0.5f);
+
+    // Muted inputs produce silence
+    received.clear();
+    mixer.input(0).setGain(0.0f);
+    push(mixer.input(0), 1.0f, 64);
+    assert(received.size() == 128 && received.front() == 0.0f);
+
+    // Silent input blocks are skipped, but still consumed.
+    // (input 0: 0 frames, input 1: 64 frames)
+    received.clear();
+    mixer.input(0).setGain(1.0f);
+    push(mixer.input(1), 0.0f, 64);
+    assert(received.empty());
+    push(mixer.input(0), 1.0f, 64);
+    assert(received.size() == 128 && received.front() == 1.0f && received.back() == 1.0f);
+
+    // Downstream nodes run outside of the mixer lock, so they might feed it again.
+    received.clear();
+    bool isFed = false;
+    sink.setProcessCallback([&](const audio::AudioConf&, core::Buffer& buffer) {
+        auto data = (const float*)buffer.constData();
+        received.insert(received.end(), data, data + buffer.size()/sizeof(float));
+        if (!isFed) {
+            isFed = true;
+            push(mixer.input(0), 1.0f, 64);
+            push(mixer.input(1), 1.0f, 64);
+        }
+    });
+    push(mixer.input(0), 1.0f, 64);
+    push(mixer.input(1), 1.0f, 64);
+    assert(received.size() == 2 * 128);
+    for (auto v : received) {
+        assert(v == 3.0f);
+    }
+
+    // Degenerate block size and invalid formats do not produce empty blocks.
+    audio::Mixer single(1, 0);
+    core::AppSink singleSink;
+    core::Node::link(single, singleSink);
+    std::vector<size_t> sizes;
+    singleSink.setProcessCallback([&](const audio::AudioConf&, core::Buffer& buffer) {
+        sizes.push_back(buffer.size());
+    });
+    assert(single.blockFrames() == 1);
+    auto pushConf = [&](const audio::AudioConf& conf) {
+        std::vector<float> samples(8, 1.0f);
+        core::Buffer buffer((const char*)samples.data(), samples.size() * sizeof(float));
+        single.input(0).process(conf, buffer);
+    };
+    pushConf({ audio::AudioCodec::RawFloat32, audio::SampleRate::Rate48000, audio::Channels::Invalid });
+    pushConf({ audio::AudioCodec::RawFloat32, audio::SampleRate::Invalid, audio::Channels::Stereo });
+    assert(sizes.empty());
+    pushConf(conf);
+    assert(sizes.size() == 4);
+    for (auto size : sizes) {
+        assert(size == 2 * sizeof(float));
+    }
+
+    return 0;
+}
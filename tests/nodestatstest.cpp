@@ -0,0 +1,35 @@
+#include <coro/audio/AudioConf.h>
+#include <coro/core/NodeStats.h>
+
+#include <assert.h>
+#include <cmath>
+
+using namespace coro;
+
+int main()
+{
+    core::NodeStats stats;
+    const audio::AudioConf pcm { audio::AudioCodec::RawInt16, audio::SampleRate::Rate48000, audio::Channels::Stereo };
+    const audio::AudioConf sbc { audio::AudioCodec::Sbc, audio::SampleRate::Rate48000, audio::Channels::Stereo };
+
+    // 480 frames (10 ms) processed in 1 ms
+    stats.add(pcm, 480 * 4, pcm, 480 * 4, std::chrono::milliseconds(1));
+    assert(stats.count() == 1 && stats.frames() == 480);
+    assert(stats.audioNs() == 10000000);
+    assert(std::abs(stats.dspLoad() - 0.1f) < 0.0001f);
+
+    // Encoded input: frames are taken from decoded output
+    stats.add(sbc, 100, pcm, 480 * 4, std::chrono::milliseconds(3));
+    assert(stats.frames() == 960);
+    assert(std::abs(stats.dspLoad() - 0.2f) < 0.0001f);
+    assert(stats.maxProcessingNs() == 3000000);
+
+    // 1 ms and 3 ms fall into buckets 19 and 21
+    const auto histogram = stats.histogram();
+    assert(histogram[19] == 1 && histogram[21] == 1);
+
+    stats.reset();
+    assert(stats.count() == 0 && stats.dspLoad() == 0.0f);
+
+    return 0;
+}
@@ -0,0 +1,290 @@
+#include <coro/audio/Crossover.h>
+#include <coro/audio/Loudness.h>
+#include <coro/audio/Peq.h>
+#include <coro/core/AppSink.h>
+#include <coro/core/Queue.h>
+#include <coro/core/Source.h>
+#include <coro/core/StaticPipeline.h>
+
+#include <assert.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace coro;
+
+// Stages forwarding to next() themselves are rejected by StaticPipeline
+static_assert(core::Queue::isForwarding && !audio::Peq::isForwarding, "Queue forwards buffers itself");
+
+class TestSource : public core::Source
+{
+public:
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{ { core::NoCap {} }, { audio::AudioCapRaw<int16_t> {} } }}};
+    }
+
+    const char* name() const override {
+        return "TestSource";
+    }
+
+    void push(const std::string& data) {
+        core::Buffer buffer(data.data(), data.size());
+        pushBuffer({ audio::AudioCodec::RawInt16, audio::SampleRate::Rate44100, audio::Channels::Stereo }, buffer);
+    }
+};
+
+// Appends given character to payload
+template<char c>
+class Appender : public core::Node
+{
+public:
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{ { audio::AudioCapRaw<int16_t> {} }, { audio::AudioCapRaw<int16_t> {} } }}};
+    }
+
+    const char* name() const override {
+        return "Appender";
+    }
+
+    audio::AudioConf onProcess(const audio::AudioConf& conf, core::Buffer& buffer) override {
+        buffer.pad(buffer.size() + 1);
+        buffer.data()[buffer.size() - 1] = c;
+        return conf;
+    }
+};
+
+// Records sizes of processed buffers
+class SizeRecorder : public core::Node
+{
+public:
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{ { audio::AudioCapRaw<int16_t> {} }, { audio::AudioCapRaw<int16_t> {} } }}};
+    }
+
+    const char* name() const override {
+        return "SizeRecorder";
+    }
+
+    audio::AudioConf onProcess(const audio::AudioConf& conf, core::Buffer& buffer) override {
+        sizes.push_back(buffer.size());
+        headrooms.push_back(buffer.headroom());
+        return conf;
+    }
+
+    std::vector<size_t> sizes;
+    std::vector<size_t> headrooms;
+};
+
+// Needs headroom and takes ownership of buffers (like Queue)
+class Taker : public core::Node
+{
+public:
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{ { audio::AudioCapRaw<int16_t> {} }, { core::NoCap {} } }}};
+    }
+
+    Taker() {
+        setHeadroom(16);
+    }
+
+    const char* name() const override {
+        return "Taker";
+    }
+
+    void onProcess(core::BufferPtr& buffer) override {
+        taken.push_back(std::move(buffer));
+    }
+
+    std::vector<core::BufferPtr> taken;
+};
+
+// Writes payload twice behind itself (like Crossover)
+class Doubler : public core::Node
+{
+public:
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{ { audio::AudioCapRaw<int16_t> {} }, { audio::AudioCapRaw<int16_t> {} } }}};
+    }
+
+    Doubler() {
+        setTailroom(2.0f);
+    }
+
+    const char* name() const override {
+        return "Doubler";
+    }
+
+    audio::AudioConf onProcess(const audio::AudioConf& conf, core::Buffer& buffer) override {
+        const auto size = buffer.size();
+        auto out = buffer.acquire(2*size, this);
+        std::memcpy(out, buffer.constData(), size);
+        std::memcpy(out + size, buffer.constData(), size);
+        buffer.commit(2*size);
+        return conf;
+    }
+};
+
+// Space for a packet to be received and for downstream nodes is reserved
+// up front, so nothing reallocates (like UdpSource).
+void testReserve()
+{
+    SizeRecorder recorder;
+    Doubler doubler;
+    SizeRecorder output;
+    core::Node::link(recorder, doubler);
+    core::Node::link(doubler, output);
+
+    auto buffer = core::Buffer::create(64);
+    for (int i = 0; i < 4; ++i) {
+        buffer->clear();
+        recorder.reserve(*buffer, 256);
+        const auto capacity = buffer->capacity();
+        std::memset(buffer->data(), i, 256);
+        buffer->grow(256);
+        buffer->audioConf() = { audio::AudioCodec::RawInt16, audio::SampleRate::Rate44100, audio::Channels::Stereo };
+        recorder.process(buffer);
+        assert(output.sizes.back() == 2*256 && buffer->capacity() == capacity);
+    }
+}
+
+void testBlockMode()
+{
+    SizeRecorder recorder;
+    core::AppSink sink;
+    core::Node::link(recorder, sink);
+    std::string received;
+    sink.setProcessCallback([&](const audio::AudioConf&, core::Buffer& buffer) {
+        received.append(buffer.constData(), buffer.size());
+    });
+
+    // 352 stereo int16 frames (like ALAC packets)
+    std::string payload(352*4, 0);
+    for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = char(i);
+    }
+    auto process = [&]() {
+        auto buffer = core::Buffer::create(payload.size());
+        std::memcpy(buffer->acquire(payload.size()), payload.data(), payload.size());
+        buffer->commit(payload.size());
+        buffer->audioConf() = { audio::AudioCodec::RawInt16, audio::SampleRate::Rate44100, audio::Channels::Stereo };
+        recorder.process(buffer);
+    };
+
+    recorder.setBlockSize(1000);
+    assert(recorder.blockSize() == core::Node::maxBlockSize);
+    recorder.setBlockSize(1);
+    assert(recorder.blockSize() == core::Node::minBlockSize);
+
+    recorder.setBlockSize(128);
+    process();
+    assert(received == payload);
+    assert((recorder.sizes == std::vector<size_t> { 128*4, 128*4, 96*4 }));
+
+    // Disabled
+    received.clear();
+    recorder.sizes.clear();
+    recorder.setBlockSize(0);
+    process();
+    assert(received == payload);
+    assert(recorder.sizes == std::vector<size_t> { 352*4 });
+
+    // Every block keeps the headroom of downstream nodes, even if they take it.
+    SizeRecorder headroomRecorder;
+    Taker taker;
+    core::Node::link(headroomRecorder, taker);
+    headroomRecorder.setBlockSize(128);
+    auto buffer = core::Buffer::create(payload.size());
+    std::memcpy(buffer->acquire(payload.size()), payload.data(), payload.size());
+    buffer->commit(payload.size());
+    buffer->audioConf() = { audio::AudioCodec::RawInt16, audio::SampleRate::Rate44100, audio::Channels::Stereo };
+    headroomRecorder.process(buffer);
+    assert(taker.taken.size() == 3);
+    for (auto headroom : headroomRecorder.headrooms) {
+        assert(headroom >= 16);
+    }
+
+    // Per graph
+    core::StaticPipeline<TestSource, SizeRecorder, core::AppSink> pipeline;
+    pipeline.setBlockSize(64);
+    assert(pipeline.blockSize() == 64);
+    pipeline.source().push(std::string(200*4, 0));
+    assert((pipeline.stage<0>().sizes == std::vector<size_t> { 64*4, 64*4, 64*4, 8*4 }));
+}
+
+// Runs a typical float DSP chain on large buffers, with and without block mode.
+void runBlockModeBenchmark()
+{
+    audio::Loudness loudness;
+    audio::Peq peq;
+    audio::Crossover crossover;
+    core::AppSink sink;
+    core::Node::link(loudness, peq);
+    core::Node::link(peq, crossover);
+    core::Node::link(crossover, sink);
+    loudness.setLevel(40);
+    loudness.setVolume(0.8f);
+    peq.setFilters({ { FilterType::Peak, 200.0f, -6.0f, 1.4f },
+                     { FilterType::Peak, 1000.0f, 3.0f, 2.0f } });
+    crossover.setFilters({ { FilterType::Crossover, 300.0f, 0.0f, 0.707f },
+                           { FilterType::Crossover, 3000.0f, 0.0f, 0.707f } });
+
+    const size_t frameCount = 16384;
+    std::vector<float> samples(frameCount*2, 0.1f);
+    auto bestTime = [&]() {
+        double best = 1e9;
+        for (int i = 0; i < 10; ++i) {
+            auto buffer = core::Buffer::create(samples.size()*sizeof(float));
+            std::memcpy(buffer->acquire(samples.size()*sizeof(float)), samples.data(), samples.size()*sizeof(float));
+            buffer->commit(samples.size()*sizeof(float));
+            buffer->audioConf() = { audio::AudioCodec::RawFloat32, audio::SampleRate::Rate44100, audio::Channels::Stereo };
+            const auto begin = std::chrono::steady_clock::now();
+            loudness.process(buffer);
+            const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - begin;
+            best = std::min(best, diff.count());
+        }
+        return best;
+    };
+
+    std::cout << "Frames: " << frameCount << ", whole buffer: " << bestTime();
+    for (uint32_t blockSize : { 32, 64, 128, 256 }) {
+        loudness.setBlockSize(blockSize);
+        std::cout << ", block " << blockSize << ": " << bestTime();
+    }
+    std::cout << std::endl;
+}
+
+int main()
+{
+    core::StaticPipeline<TestSource, Appender<'a'>, Appender<'b'>, core::AppSink> pipeline;
+
+    std::string received;
+    pipeline.stage<2>().setProcessCallback([&](const audio::AudioConf&, core::Buffer& buffer) {
+        received.assign(buffer.constData(), buffer.size());
+    });
+
+    pipeline.source().push("x");
+    assert(received == "xab");
+
+    pipeline.setIsBypassed(0, true);
+    assert(pipeline.isBypassed(0) && !pipeline.isBypassed(1));
+    pipeline.source().push("x");
+    assert(received == "xb");
+
+#ifdef CORO_NODE_STATS
+    pipeline.stage<1>().setStatsEnabled(true);
+    pipeline.source().push("xx");
+    assert(pipeline.stage<1>().stats().count() == 1);
+    assert(pipeline.stage<1>().stats().bytes() == 2);
+#endif
+
+    // Does not compile, since caps do not intersect:
+    // core::StaticPipeline<TestSource, audio::Loudness> invalid;
+
+    testReserve();
+    testBlockMode();
+    runBlockModeBenchmark();
+
+    return 0;
+}
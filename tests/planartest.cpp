@@ -0,0 +1,256 @@
+#define private public
+#include "../include/coro/audio/Convolver.h"
+#include "../include/coro/audio/Crossover.h"
+#include "../include/coro/audio/FileSink.h"
+#include "../include/coro/audio/Interleaver.h"
+#include "../include/coro/audio/Peq.h"
+#undef private
+#include <coro/audio/AlsaSink.h>
+#include <coro/audio/AudioDecoderFfmpeg.h>
+#include <coro/audio/Mixer.h>
+#include <coro/audio/PartitionedConvolver.h>
+
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace coro;
+using namespace coro::audio;
+
+// Layout is negotiated statically
+static_assert(core::Cap::canIntersect(Deinterleaver::caps(), Peq::caps()), "Peq takes planar buffers");
+static_assert(core::Cap::canIntersect(Peq::caps(), Convolver::caps()), "Convolver takes planar buffers");
+static_assert(core::Cap::canIntersect(Convolver::caps(), Interleaver::caps()), "Interleaver takes planar buffers");
+static_assert(!core::Cap::canIntersect(Deinterleaver::caps(), Crossover::caps()), "Crossover only takes interleaved buffers");
+static_assert(!core::Cap::canIntersect(Interleaver::caps(), Interleaver::caps()), "Interleaver outputs interleaved buffers");
+static_assert(core::Cap::canIntersect(AudioDecoderFfmpeg<AudioCodec::Ac3>::caps(), Peq::caps()), "Decoder outputs planar buffers");
+static_assert(core::Cap::canIntersect(Deinterleaver::caps(), AlsaSink::caps()), "AlsaSink interleaves planar buffers");
+static_assert(!core::Cap::canIntersect(Deinterleaver::caps(), MixerInput::caps()), "Mixer only takes interleaved buffers");
+
+template <typename T>
+std::vector<T> generateNoise(std::size_t count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<T> samples(count);
+    for (auto& s : samples) {
+        s = std::is_same<T, float>::value ? dist(gen) : T(dist(gen) * 20000.0f);
+    }
+    return samples;
+}
+
+template <typename T>
+core::BufferPtr createBuffer(const std::vector<T>& samples, ChannelFlags channels)
+{
+    auto buffer = core::Buffer::create(samples.size()*sizeof(T));
+    std::memcpy(buffer->acquire(samples.size()*sizeof(T)), samples.data(), samples.size()*sizeof(T));
+    buffer->commit(samples.size()*sizeof(T));
+    buffer->audioConf() = { rawCodec<T>(), SampleRate::Rate48000, channels };
+    return buffer;
+}
+
+template <typename T>
+std::vector<T> samples(const core::Buffer& buffer)
+{
+    auto data = (const T*)buffer.constData();
+    return std::vector<T>(data, data + buffer.size()/sizeof(T));
+}
+
+// Odd frame counts cover vector bodies and scalar tails.
+template <typename T>
+void testRoundTrip(ChannelFlags channels, std::size_t frameCount)
+{
+    const std::size_t channelCount = toInt(channels);
+    const auto input = generateNoise<T>(frameCount*channelCount, 1);
+    auto buffer = createBuffer(input, channels);
+
+    TDeinterleaver<T> deinterleaver;
+    TInterleaver<T> interleaver;
+
+    deinterleaver.onProcess(buffer);
+    assert(buffer->audioConf().isPlanar);
+    const auto planar = samples<T>(*buffer);
+    assert(planar.size() == input.size());
+    for (std::size_t ch = 0; ch < channelCount; ++ch) {
+        for (std::size_t i = 0; i < frameCount; ++i) {
+            assert(planar[ch*frameCount + i] == input[i*channelCount + ch]);
+        }
+    }
+
+    // Already planar, nothing to do
+    deinterleaver.onProcess(buffer);
+    assert(samples<T>(*buffer) == planar);
+
+    interleaver.onProcess(buffer);
+    assert(!buffer->audioConf().isPlanar);
+    assert(samples<T>(*buffer) == input);
+}
+
+// Planar processing yields the same result as interleaved processing.
+template <typename Node>
+void testNode(Node& interleaved, Node& planar, std::size_t channelCount, float tolerance)
+{
+    const std::size_t frameCount = 1000;
+    const auto channels = channelCount == 2 ? ChannelFlags(Channels::Stereo) : ChannelFlags(Channels::Mono);
+    const auto input = generateNoise<float>(frameCount*channelCount, 2);
+
+    Deinterleaver deinterleaver;
+    Interleaver interleaver;
+    // Chunks of different size carry history across calls.
+    for (std::size_t pos = 0, chunk = 1; pos < frameCount; chunk = chunk*7 % 257) {
+        const std::size_t n = std::min(chunk, frameCount - pos);
+        const std::vector<float> in(input.begin() + pos*channelCount, input.begin() + (pos+n)*channelCount);
+        auto a = createBuffer(in, channels);
+        auto b = createBuffer(in, channels);
+
+        interleaved.onProcess(a);
+        deinterleaver.onProcess(b);
+        planar.onProcess(b);
+        assert(b->audioConf().isPlanar);
+        interleaver.onProcess(b);
+
+        const auto expected = samples<float>(*a);
+        const auto actual = samples<float>(*b);
+        assert(expected.size() == actual.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            assert(std::abs(expected[i] - actual[i]) <= tolerance);
+        }
+        pos += n;
+    }
+}
+
+void testPeq()
+{
+    const std::vector<Filter> filters = { { FilterType::Peak, 200.0f, -6.0f, 1.4f },
+                                          { FilterType::LowShelf, 80.0f, 4.0f, 0.7f },
+                                          { FilterType::HighShelf, 8000.0f, -3.0f, 0.7f } };
+    Peq interleaved;
+    Peq planar;
+    interleaved.setFilters(filters);
+    planar.setFilters(filters);
+    testNode(interleaved, planar, 2, 1e-6f);
+}
+
+void testConvolver()
+{
+    std::vector<std::vector<float>> irs = { generateNoise<float>(300, 3), generateNoise<float>(200, 4) };
+    Convolver interleaved;
+    Convolver planar;
+    interleaved.setImpulseResponses(irs, 48000);
+    planar.setImpulseResponses(irs, 48000);
+    testNode(interleaved, planar, 2, 1e-5f);
+}
+
+// Decoder (planar) -> Peq -> AlsaSink, which interleaves planes itself.
+// Sinks, which cannot, reject planar buffers.
+void testSink()
+{
+    const std::size_t frameCount = 1000;
+    const auto input = generateNoise<float>(frameCount*2, 8);
+    const std::vector<Filter> filters = { { FilterType::Peak, 200.0f, -6.0f, 1.4f } };
+    Peq interleaved;
+    Peq planar;
+    interleaved.setFilters(filters);
+    planar.setFilters(filters);
+
+    auto a = createBuffer(input, Channels::Stereo);
+    interleaved.onProcess(a);
+
+    // Planes are laid out like AudioDecoderFfmpeg::copyPlanes() does
+    std::vector<float> planes(input.size());
+    for (std::size_t i = 0; i < frameCount; ++i) {
+        planes[i] = input[i*2];
+        planes[frameCount + i] = input[i*2 + 1];
+    }
+    auto b = createBuffer(planes, Channels::Stereo);
+    b->audioConf().isPlanar = true;
+    planar.onProcess(b);
+    assert(b->audioConf().isPlanar);
+
+    // AlsaSink runs this ahead of writing to the device
+    interleave(*b);
+    assert(!b->audioConf().isPlanar);
+    const auto expected = samples<float>(*a);
+    const auto actual = samples<float>(*b);
+    assert(expected.size() == actual.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        assert(std::abs(expected[i] - actual[i]) <= 1e-6f);
+    }
+
+    // Interleaved and non-raw buffers are left untouched
+    interleave(*b);
+    assert(samples<float>(*b) == actual);
+
+    FileSink sink;
+    sink.setFileName("testplanar.raw");
+    auto c = createBuffer(planes, Channels::Stereo);
+    c->audioConf().isPlanar = true;
+    sink.onProcess(c);
+    assert(c->size() == 0);
+    auto d = createBuffer(input, Channels::Stereo);
+    sink.onProcess(d);
+    sink.onStop();
+    std::ifstream file("testplanar.raw", std::ios::binary | std::ios::ate);
+    assert(std::size_t(file.tellg()) == input.size()*sizeof(float));
+    std::remove("testplanar.raw");
+}
+
+// Planar blocks skip gathering/scattering channels inside the convolver.
+void runBenchmark()
+{
+    const std::size_t channelCount = 2;
+    const std::size_t frameCount = 1 << 15;
+    PartitionedConvolver interleaved(256);
+    PartitionedConvolver planar(256);
+    const std::vector<std::vector<float>> irs = { generateNoise<float>(1024, 5), generateNoise<float>(1024, 6) };
+    interleaved.setImpulseResponses(irs);
+    planar.setImpulseResponses(irs);
+    auto input = generateNoise<float>(frameCount*channelCount, 7);
+    std::vector<float> output(input.size());
+
+    auto bestTime = [&](auto&& run) {
+        double best = 1e9;
+        for (int i = 0; i < 10; ++i) {
+            const auto begin = std::chrono::steady_clock::now();
+            run();
+            const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - begin;
+            best = std::min(best, diff.count());
+        }
+        return best;
+    };
+    const auto interleavedTime = bestTime([&]() {
+        interleaved.process(input.data(), output.data(), frameCount);
+    });
+    for (std::size_t ch = 0; ch < channelCount; ++ch) {
+        for (std::size_t i = 0; i < frameCount; ++i) {
+            output[ch*frameCount + i] = input[i*channelCount + ch];
+        }
+    }
+    input.swap(output);
+    const auto planarTime = bestTime([&]() {
+        planar.processPlanar(input.data(), output.data(), frameCount);
+    });
+    std::cout << "Frames: " << frameCount << " (convolver, 2 x 1024 taps), interleaved: " << interleavedTime
+              << ", planar: " << planarTime << ", speed-up: " << interleavedTime/planarTime << std::endl;
+}
+
+int main()
+{
+    testRoundTrip<float>(Channels::Stereo, 1027);
+    testRoundTrip<float>(Channels::Mono, 5);
+    testRoundTrip<int16_t>(Channels::Stereo, 1027);
+    testRoundTrip<int32_t>(Channels::Stereo, 3);
+    testPeq();
+    testConvolver();
+    testSink();
+    runBenchmark();
+
+    return 0;
+}
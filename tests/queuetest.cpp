@@ -0,0 +1,106 @@
+#include <coro/core/AppSink.h>
+#include <coro/core/Queue.h>
+
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace coro;
+
+class Receiver
+{
+public:
+    Receiver() {
+        sink.setProcessCallback([this](const audio::AudioConf&, core::Buffer& buffer) {
+            // Block on first buffer until released
+            isEntered = true;
+            while (isGated) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            values.push_back(buffer.constData()[0]);
+            threadId = std::this_thread::get_id();
+        });
+    }
+
+    void waitFor(size_t count) {
+        for (int i = 0; i < 1000 && received() < count; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    size_t received() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return values.size();
+    }
+
+    core::AppSink sink;
+    std::atomic_bool isEntered = false;
+    std::atomic_bool isGated = false;
+    std::mutex mutex;
+    std::vector<char> values;
+    std::thread::id threadId;
+};
+
+void push(core::Queue& queue, char value)
+{
+    audio::AudioConf conf { audio::AudioCodec::RawInt16 };
+    core::Buffer buffer(&value, 1);
+    queue.process(conf, buffer);
+    // Payload got handed over to queue
+    assert(buffer.size() == 0);
+}
+
+void testOrder()
+{
+    core::Queue queue(4, core::Queue::OverflowPolicy::Block);
+    Receiver receiver;
+    core::Node::link(queue, receiver.sink);
+
+    for (int i = 0; i < 100; ++i) {
+        push(queue, i);
+    }
+    receiver.waitFor(100);
+
+    assert(queue.droppedCount() == 0);
+    assert(receiver.values.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        assert(receiver.values.at(i) == i);
+    }
+    // Downstream runs on worker thread
+    assert(receiver.threadId != std::this_thread::get_id());
+}
+
+void testOverflow(core::Queue::OverflowPolicy policy, const std::vector<char>& expected)
+{
+    core::Queue queue(2, policy);
+    Receiver receiver;
+    core::Node::link(queue, receiver.sink);
+
+    // Worker blocks on first buffer, so the following ones pile up
+    receiver.isGated = true;
+    push(queue, 0);
+    while (!receiver.isEntered) {
+        std::this_thread::yield();
+    }
+    for (char i = 1; i < 5; ++i) {
+        push(queue, i);
+    }
+    receiver.isGated = false;
+    receiver.waitFor(3);
+
+    assert(queue.droppedCount() == 2);
+    assert(receiver.values == expected);
+}
+
+int main()
+{
+    testOrder();
+    testOverflow(core::Queue::OverflowPolicy::DropNewest, { 0, 1, 2 });
+    testOverflow(core::Queue::OverflowPolicy::DropOldest, { 0, 3, 4 });
+
+    return 0;
+}
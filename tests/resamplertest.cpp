@@ -0,0 +1,154 @@
+#include <coro/audio/PolyphaseResampler.h>
+#include <coro/audio/Resampler.h>
+#include <coro/core/AppSink.h>
+
+#include <assert.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace coro;
+
+static const std::vector<uint32_t> rates { 32000, 44100, 48000, 96000, 192000 };
+
+std::vector<float> generateSine(uint32_t rate, double frequency, std::size_t frameCount, std::size_t channelCount)
+{
+    std::vector<float> samples(frameCount*channelCount);
+    for (std::size_t i = 0; i < frameCount; ++i) {
+        for (std::size_t ch = 0; ch < channelCount; ++ch) {
+            // Second channel is inverted
+            samples[i*channelCount + ch] = (ch % 2 ? -0.5 : 0.5) * std::sin(2.0*M_PI*frequency*i/rate);
+        }
+    }
+    return samples;
+}
+
+// Resamples a sine in chunks and compares against the ideal one at output rate.
+void testSine(uint32_t inRate, uint32_t outRate)
+{
+    const std::size_t channelCount = 2;
+    const std::size_t frameCount = inRate/4;
+    const double frequency = 1000.0;
+    const auto input = generateSine(inRate, frequency, frameCount, channelCount);
+
+    audio::PolyphaseResampler resampler(inRate, outRate, channelCount);
+    std::vector<float> output;
+    for (std::size_t pos = 0; pos < frameCount; pos += 441) {
+        const uint32_t n = std::min<std::size_t>(441, frameCount - pos);
+        std::vector<float> out(resampler.maxOutputFrames(n)*channelCount);
+        const uint32_t outCount = resampler.process(input.data() + pos*channelCount, n, out.data());
+        assert(outCount <= resampler.maxOutputFrames(n));
+        output.insert(output.end(), out.begin(), out.begin() + outCount*channelCount);
+    }
+
+    // Output frames cover input minus look-ahead
+    const double expectedCount = double(frameCount - resampler.latency()) * outRate / inRate;
+    assert(std::fabs(output.size()/channelCount - expectedCount) <= 1.0 + double(outRate)/inRate);
+
+    const std::size_t begin = resampler.tapCount() * outRate / inRate;
+    double maxError = 0.0;
+    for (std::size_t i = begin; i < output.size()/channelCount; ++i) {
+        const double t = double(i)/outRate;
+        const double ref = 0.5 * std::sin(2.0*M_PI*frequency*t);
+        maxError = std::max(maxError, std::fabs(output[i*channelCount] - ref));
+        maxError = std::max(maxError, std::fabs(output[i*channelCount+1] + ref));
+    }
+    assert(maxError < 1e-3);
+}
+
+// Content above the lower Nyquist frequency is suppressed.
+void testAntiAliasing()
+{
+    const auto input = generateSine(96000, 30000.0, 9600, 1);
+    audio::PolyphaseResampler resampler(96000, 44100, 1);
+    std::vector<float> output(resampler.maxOutputFrames(input.size()));
+    const uint32_t outCount = resampler.process(input.data(), input.size(), output.data());
+    for (uint32_t i = resampler.tapCount(); i < outCount; ++i) {
+        assert(std::fabs(output[i]) < 1e-3);
+    }
+}
+
+void testNode()
+{
+    audio::Resampler resampler(audio::SampleRate::Rate48000);
+    core::AppSink sink;
+    core::Node::link(resampler, sink);
+
+    std::size_t received = 0;
+    sink.setProcessCallback([&](const audio::AudioConf& conf, core::Buffer& buffer) {
+        assert(conf.rate == audio::SampleRate::Rate48000);
+        received = buffer.size()/conf.frameSize();
+    });
+
+    auto process = [&](audio::SampleRate rate, std::size_t frameCount) {
+        const auto samples = generateSine(audio::toInt(rate), 1000.0, frameCount, 2);
+        const size_t bytes = samples.size()*sizeof(float);
+        auto buffer = core::Buffer::create(bytes);
+        std::memcpy(buffer->acquire(bytes), samples.data(), bytes);
+        buffer->commit(bytes);
+        buffer->audioConf() = { audio::AudioCodec::RawFloat32, rate, audio::Channels::Stereo };
+        received = 0;
+        resampler.process(buffer);
+        return received;
+    };
+
+    // Output rate passes unchanged
+    assert(process(audio::SampleRate::Rate48000, 480) == 480);
+
+    // Source switches between rates, sink always sees 48 kHz
+    std::size_t frameCount = 0;
+    for (int i = 0; i < 100; ++i) {
+        frameCount += process(audio::SampleRate::Rate44100, 441);
+    }
+    assert(frameCount <= 48000 && frameCount > 48000 - 100);
+    frameCount = 0;
+    for (int i = 0; i < 100; ++i) {
+        frameCount += process(audio::SampleRate::Rate96000, 960);
+    }
+    assert(frameCount <= 48000 && frameCount > 48000 - 100);
+}
+
+// Reports CPU load for a stereo stream.
+void runBenchmark(uint32_t inRate, uint32_t outRate)
+{
+    const std::size_t frameCount = inRate;
+    const auto input = generateSine(inRate, 1000.0, frameCount, 2);
+    audio::PolyphaseResampler resampler(inRate, outRate, 2);
+    std::vector<float> output(resampler.maxOutputFrames(480)*2);
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (std::size_t pos = 0; pos + 480 <= frameCount; pos += 480) {
+        resampler.process(input.data() + pos*2, 480, output.data());
+    }
+    const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - begin;
+
+    std::cout << std::setw(6) << inRate << " -> " << std::setw(6) << outRate
+              << ", taps: " << std::setw(3) << resampler.tapCount()
+              << ", CPU load: " << std::fixed << std::setprecision(2) << 100.0 * diff.count() << " %"
+              << std::endl;
+}
+
+int main()
+{
+    std::cout << "#### Resampler test ####" << std::endl;
+    for (auto inRate : rates) {
+        for (auto outRate : rates) {
+            if (inRate != outRate) {
+                testSine(inRate, outRate);
+            }
+        }
+    }
+    testAntiAliasing();
+    testNode();
+
+    std::cout << std::endl << "#### Resampler benchmark ####" << std::endl;
+    for (auto inRate : rates) {
+        runBenchmark(inRate, 48000);
+    }
+    runBenchmark(48000, 44100);
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <coro/core/AppSink.h>
+#include <coro/core/Queue.h>
+#include <coro/core/Tee.h>
+
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace coro;
+
+// Writes to buffer in place
+class Writer : public core::Node
+{
+public:
+    static constexpr std::array<std::pair<core::Cap, core::Cap>, 1> caps() {
+        return {{{ { core::AnyCap {} }, { core::AnyCap {} } }}};
+    }
+
+    const char* name() const override {
+        return "Writer";
+    }
+
+    audio::AudioConf onProcess(const audio::AudioConf& conf, core::Buffer& buffer) override {
+        buffer.data()[0] = 'X';
+        return conf;
+    }
+};
+
+int main()
+{
+    core::Tee tee;
+    Writer writer;
+    core::AppSink sink1, sink2, sink3;
+    core::Queue queue;
+
+    std::string received1, received2, received3;
+    const char* data3 = nullptr;
+    std::atomic_bool isReceived2 = false;
+    sink1.setProcessCallback([&](const audio::AudioConf&, core::Buffer& buffer) {
+        received1.assign(buffer.constData(), buffer.size());
+    });
+    sink2.setProcessCallback([&](const audio::AudioConf&, core::Buffer& buffer) {
+        received2.assign(buffer.constData(), buffer.size());
+        isReceived2 = true;
+    });
+    sink3.setProcessCallback([&](const audio::AudioConf&, core::Buffer& buffer) {
+        received3.assign(buffer.constData(), buffer.size());
+        data3 = buffer.constData();
+    });
+
+    // Branches: writer -> sink1, queue -> sink2 (threaded), sink3
+    core::Node::link(tee, writer);
+    core::Node::link(writer, sink1);
+    core::Node::link(tee, queue);
+    core::Node::link(queue, sink2);
+    core::Node::link(tee, sink3);
+    assert(tee.branches().size() == 3);
+
+    audio::AudioConf conf { audio::AudioCodec::RawInt16 };
+    core::Buffer buffer("payload", 7);
+    const auto data = buffer.constData();
+    tee.process(conf, buffer);
+
+    for (int i = 0; i < 1000 && !isReceived2; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Writing branch got a private copy, others see original payload
+    assert(received1 == "Xayload");
+    assert(received2 == "payload");
+    assert(received3 == "payload");
+    // Last branch got original storage
+    assert(data3 == data);
+
+    return 0;
+}